@@ -24,6 +24,15 @@
 /* Define to 1 if you have the <netinet/in.h> header file. */
 #cmakedefine HAVE_NETINET_IN_H 1
 
+/* Define to 1 if you have the <linux/if_tun.h> header file. */
+#cmakedefine HAVE_LINUX_IF_TUN_H 1
+
+/* Define to 1 if you have the <linux/if_packet.h> header file. */
+#cmakedefine HAVE_LINUX_IF_PACKET_H 1
+
+/* Define to 1 if you have the <sys/un.h> header file for control sockets. */
+#cmakedefine HAVE_UNIX_DOMAIN_SOCKETS 1
+
 /* Define to 1 if you have the <byteswap.h> header file. */
 #cmakedefine HAVE_BYTESWAP_H 1
 
@@ -45,6 +54,12 @@
 /* Define to 1 if you have the 'nanosleep' function. */
 #cmakedefine HAVE_NANOSLEEP 1
 
+/* Define to 1 if you have the 'setitimer' function. */
+#cmakedefine HAVE_SETITIMER 1
+
+/* Define to 1 if you have the 'fork' function. */
+#cmakedefine HAVE_FORK 1
+
 /* Define to 1 if you have the 'alphasort' function. */
 #cmakedefine HAVE_ALPHASORT 1
 
@@ -60,6 +75,9 @@
 /* Define to 1 if you have the 'flock' function. */
 #cmakedefine HAVE_FLOCK 1
 
+/* Define to 1 if you have the 'mmap' function. */
+#cmakedefine HAVE_MMAP 1
+
 /* Define to 1 if you have the 'strdup' function */
 #cmakedefine HAVE_STRDUP 1
 
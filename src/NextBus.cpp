@@ -38,6 +38,7 @@ void NextBusSlot::board_bput(uint32_t addr, uint8_t val)  {bus_error(addr, BUS_E
 
 void NextBusSlot::reset(void) {}
 void NextBusSlot::pause(bool pause) {}
+void NextBusSlot::snapshot(bool save) {}
 
 NextBusBoard::NextBusBoard(int slot) : NextBusSlot(slot) {}
 
@@ -201,4 +202,9 @@ extern "C" {
         for(int slot = 0; slot < 16; slot++)
             nextbus[slot]->pause(pause);
     }
+    
+    void NextBus_MemorySnapShot_Capture(bool bSave) {
+        for(int slot = 0; slot < 16; slot++)
+            nextbus[slot]->snapshot(bSave);
+    }
 }
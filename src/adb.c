@@ -14,6 +14,7 @@ const char Adb_fileid[] = "Previous adb.c";
 #include "sysReg.h"
 #include "rtcnvram.h"
 #include "adb.h"
+#include "memorySnapShot.h"
 
 #define LOG_ADB_LEVEL      LOG_DEBUG
 #define LOG_ADB_CMD_LEVEL  LOG_DEBUG
@@ -693,3 +694,9 @@ void adb_reset(void) {
 	adb_kbd_reset();
 	adb_mouse_reset();
 }
+
+void ADB_MemorySnapShot_Capture(bool bSave) {
+	MemorySnapShot_Store(&adb, sizeof(adb));
+	MemorySnapShot_Store(&adb_kbd, sizeof(adb_kbd));
+	MemorySnapShot_Store(&adb_mouse, sizeof(adb_mouse));
+}
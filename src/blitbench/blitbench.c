@@ -0,0 +1,103 @@
+/*
+ *  blitbench.c
+ *  Previous
+ *
+ *  Measure the frame rate of the pixel format conversion kernels used
+ *  by the screen repaint for each framebuffer type.
+ *
+ *  Usage: blitbench [-f <frames>]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdlblit.h"
+
+#define SCRN_W  1120
+#define SCRN_H  832
+
+static uint8_t  vram[(SCRN_W + 32) * SCRN_H * 4];
+static uint32_t pixels[SCRN_W * SCRN_H];
+
+enum {
+    BENCH_BW,
+    BENCH_BW_TURBO,
+    BENCH_COLOR,
+    BENCH_COLOR_TURBO,
+    BENCH_DIMENSION,
+    BENCH_COUNT
+};
+
+static const char* bench_name[BENCH_COUNT] = {
+    "BW", "BW Turbo", "Color", "Color Turbo", "Dimension"
+};
+
+static void blit_frame(int type) {
+    switch (type) {
+        case BENCH_BW:
+            Blit_BW(vram, (SCRN_W + 32) / 4, pixels, SCRN_W * 4, SCRN_W, SCRN_H);
+            break;
+        case BENCH_BW_TURBO:
+            Blit_BW(vram, SCRN_W / 4, pixels, SCRN_W * 4, SCRN_W, SCRN_H);
+            break;
+        case BENCH_COLOR:
+            Blit_Color((uint16_t*)vram, (SCRN_W + 32) * 2, pixels, SCRN_W * 4, SCRN_W, SCRN_H);
+            break;
+        case BENCH_COLOR_TURBO:
+            Blit_Color((uint16_t*)vram, SCRN_W * 2, pixels, SCRN_W * 4, SCRN_W, SCRN_H);
+            break;
+        case BENCH_DIMENSION:
+            Blit_Dimension((uint32_t*)vram, (SCRN_W + 32) * 4, pixels, SCRN_W * 4, SCRN_W, SCRN_H);
+            break;
+        default:
+            break;
+    }
+}
+
+int main(int argc, const char* argv[]) {
+    int frames = 500;
+    int i, k, t;
+    uint64_t start, ns;
+
+    for (i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-f") && i + 1 < argc) {
+            frames = atoi(argv[++i]);
+        } else {
+            printf("Usage: %s [-f <frames>]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) {
+        frames = 1;
+    }
+
+    for (i = 0; i < (int)sizeof(vram); i++) {
+        vram[i] = rand();
+    }
+    Blit_Init(SDL_PIXELFORMAT_BGRA32);
+
+    printf("%-12s", "");
+    for (t = 0; t < BENCH_COUNT; t++) {
+        printf("%14s", bench_name[t]);
+    }
+    printf("\n");
+
+    for (k = 0; k < BLIT_KERNEL_COUNT; k++) {
+        if (!Blit_SelectKernel((BLIT_KERNEL)k)) {
+            continue;
+        }
+        printf("%-12s", Blit_KernelName((BLIT_KERNEL)k));
+        for (t = 0; t < BENCH_COUNT; t++) {
+            blit_frame(t); /* warm up caches and tables */
+            start = SDL_GetTicksNS();
+            for (i = 0; i < frames; i++) {
+                blit_frame(t);
+            }
+            ns = SDL_GetTicksNS() - start;
+            printf("%10.0f fps", ns ? frames * 1e9 / ns : 0.0);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -14,6 +14,7 @@ const char Bmap_fileid[] = "Previous bmap.c";
 #include "sysReg.h"
 #include "reset.h"
 #include "bmap.h"
+#include "memorySnapShot.h"
 
 #define LOG_BMAP_LEVEL  LOG_DEBUG
 
@@ -235,3 +236,12 @@ void BMAP_Reset(void) {
     bmap_hreq_enable = 0;
     bmap_txdn_enable = 0;
 }
+
+
+void BMAP_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(NEXTbmap, sizeof(NEXTbmap));
+    MemorySnapShot_Store(&bmap_rom_local, sizeof(bmap_rom_local));
+    MemorySnapShot_Store(&bmap_tpe_select, sizeof(bmap_tpe_select));
+    MemorySnapShot_Store(&bmap_hreq_enable, sizeof(bmap_hreq_enable));
+    MemorySnapShot_Store(&bmap_txdn_enable, sizeof(bmap_txdn_enable));
+}
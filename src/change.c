@@ -31,6 +31,7 @@ const char Change_fileid[] = "Previous change.c";
 #include "snd.h"
 #include "tablet.h"
 #include "keymap.h"
+#include "timing.h"
 
 #define DEBUG 1
 #if DEBUG
@@ -242,6 +243,7 @@ void Change_CopyChangedParamsToConfiguration(CNF_PARAMS *current, CNF_PARAMS *ch
 	bool bReInitEnetEmu = false;
 	bool bReInitSoundEmu = false;
 	bool bScreenModeChange = false;
+	bool bMaxSpeedChange = false;
 
 	Dprintf("Changes for:\n");
 	/* Do we need to warn user that changes will only take effect after reset? */
@@ -282,6 +284,11 @@ void Change_CopyChangedParamsToConfiguration(CNF_PARAMS *current, CNF_PARAMS *ch
 			bReInitSoundEmu = true;
 		}
 
+		/* Do we need to switch max speed mode? */
+		if (current->System.bMaxSpeed != changed->System.bMaxSpeed) {
+			bMaxSpeedChange = true;
+		}
+
 		/* Do we need to change Screen configuration? */
 		if (current->Screen.nMode != changed->Screen.nMode) {
 			bScreenModeChange = true;
@@ -305,6 +312,12 @@ void Change_CopyChangedParamsToConfiguration(CNF_PARAMS *current, CNF_PARAMS *ch
 	/* Copy details to global, if we reset copy them all */
 	Configuration_Apply(NeedReset);
 
+	/* Switch max speed mode? */
+	if (bMaxSpeedChange) {
+		Dprintf("- Max speed\n");
+		Timing_SetMaxSpeed(ConfigureParams.System.bMaxSpeed);
+	}
+
 	/* Re-init Ethernet? */
 	if (bReInitEnetEmu) {
 		Dprintf("- Ethernet\n");
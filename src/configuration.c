@@ -75,6 +75,7 @@ static const struct Config_Tag configs_Screen[] =
 	{ "bFullScreen", Bool_Tag, &ConfigureParams.Screen.bFullScreen },
 	{ "bShowStatusbar", Bool_Tag, &ConfigureParams.Screen.bShowStatusbar },
 	{ "bShowTitlebar", Bool_Tag, &ConfigureParams.Screen.bShowTitlebar },
+	{ "bShaderConvert", Bool_Tag, &ConfigureParams.Screen.bShaderConvert },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -115,6 +116,7 @@ static const struct Config_Tag configs_ShortCutWithMod[] =
 	{ "kColdReset",   Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_COLDRESET] },
 	{ "kScreenshot",  Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_SCREENSHOT] },
 	{ "kRecord",      Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_RECORD] },
+	{ "kVideo",       Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_VIDEO] },
 	{ "kSound",       Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_SOUND] },
 	{ "kPause",       Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_PAUSE] },
 	{ "kDebuggerM68K",Key_Tag, &ConfigureParams.Shortcut.withModifier[SHORTCUT_DEBUG_M68K] },
@@ -135,6 +137,7 @@ static const struct Config_Tag configs_ShortCutWithoutMod[] =
 	{ "kColdReset",   Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_COLDRESET] },
 	{ "kScreenshot",  Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_SCREENSHOT] },
 	{ "kRecord",      Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_RECORD] },
+	{ "kVideo",       Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_VIDEO] },
 	{ "kSound",       Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_SOUND] },
 	{ "kPause",       Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_PAUSE] },
 	{ "kDebuggerM68K",Key_Tag, &ConfigureParams.Shortcut.withoutModifier[SHORTCUT_DEBUG_M68K] },
@@ -152,6 +155,7 @@ static const struct Config_Tag configs_Sound[] =
 {
 	{ "bEnableMicrophone", Bool_Tag, &ConfigureParams.Sound.bEnableMicrophone },
   	{ "bEnableSound", Bool_Tag, &ConfigureParams.Sound.bEnableSound },
+	{ "nGrabFormat", Int_Tag, &ConfigureParams.Sound.nGrabFormat },
 	{ NULL , Error_Tag, NULL }
 };
 
@@ -334,6 +338,7 @@ static const struct Config_Tag configs_System[] =
 	{ "nCpuFreq", Int_Tag, &ConfigureParams.System.nCpuFreq },
 	{ "bCompatibleCpu", Bool_Tag, &ConfigureParams.System.bCompatibleCpu },
 	{ "bRealtime", Bool_Tag, &ConfigureParams.System.bRealtime },
+	{ "bMaxSpeed", Bool_Tag, &ConfigureParams.System.bMaxSpeed },
 	{ "nDSPType", Int_Tag, &ConfigureParams.System.nDSPType },
 	{ "bDSPMemoryExpansion", Bool_Tag, &ConfigureParams.System.bDSPMemoryExpansion },
 	{ "n_FPUType", Int_Tag, &ConfigureParams.System.n_FPUType },
@@ -505,10 +510,12 @@ void Configuration_SetDefault(void)
 	ConfigureParams.Screen.bFullScreen = false;
 	ConfigureParams.Screen.bShowStatusbar = true;
 	ConfigureParams.Screen.bShowTitlebar = true;
+	ConfigureParams.Screen.bShaderConvert = false;
 
 	/* Set defaults for Sound */
 	ConfigureParams.Sound.bEnableMicrophone = true;
 	ConfigureParams.Sound.bEnableSound = true;
+	ConfigureParams.Sound.nGrabFormat = SOUNDGRAB_AIFF;
 
 	/* Set defaults for Rom */
 	File_MakePathBuf(ConfigureParams.Rom.szRom030FileName,
@@ -539,6 +546,7 @@ void Configuration_SetDefault(void)
 	ConfigureParams.System.nCpuFreq = 25;
 	ConfigureParams.System.bCompatibleCpu = false;
 	ConfigureParams.System.bRealtime = false;
+	ConfigureParams.System.bMaxSpeed = false;
 	ConfigureParams.System.nDSPType = DSP_TYPE_EMU;
 	ConfigureParams.System.bDSPMemoryExpansion = false;
 	ConfigureParams.System.n_FPUType = FPU_68882;
@@ -659,7 +667,8 @@ static void Configuration_CheckEthernetSettings(void) {
 	if (ConfigureParams.System.nMachineType == NEXT_CUBE030) {
 		ConfigureParams.Ethernet.bTwistedPair = false;
 	}
-	if (ConfigureParams.Ethernet.nHostInterface == ENET_PCAP) {
+	if (ConfigureParams.Ethernet.nHostInterface == ENET_PCAP ||
+	    ConfigureParams.Ethernet.nHostInterface == ENET_TAP) {
 		ConfigureParams.Ethernet.bNetworkTime = false;
 	}
 }
@@ -25,9 +25,13 @@ const char Control_fileid[] = "Previous control.c : " __DATE__ " " __TIME__;
 #include "configuration.h"
 #include "control.h"
 #include "debugui.h"
+#include "enet_capture.h"
 #include "file.h"
+#include "hostprof.h"
 #include "log.h"
+#include "memorySnapShot.h"
 #include "screen.h"
+#include "gui-sdl/sdlkeymap.h"
 #include "shortcut.h"
 #include "str.h"
 
@@ -54,34 +58,73 @@ static bool bRemotePaused;
  */
 static bool Control_InsertKey(const char *event)
 {
+	SDL_KeyboardEvent sdlkey;
 	const char *key = NULL;
+	bool down = false, up = false;
 
 	if (strncmp(event, "keypress ", 9) == 0) {
 		key = &event[9];
+		down = up = true;
 	} else if (strncmp(event, "keydown ", 8) == 0) {
 		key = &event[8];
+		down = true;
 	} else if (strncmp(event, "keyup ", 6) == 0) {
 		key = &event[6];
+		up = true;
 	}
 	if (!(key && key[0])) {
 		fprintf(stderr, "ERROR: '%s' contains no key press/down/up event\n", event);
 		return false;
 	}
+	memset(&sdlkey, 0, sizeof(sdlkey));
 	if (key[1]) {
 		char *endptr;
-		/* multiple characters, assume it's a keycode */
-		int keycode = strtol(key, &endptr, 0);
-		/* not a valid number or keycode is out of range? */
-		if (*endptr || keycode < 0 || keycode > 255) {
+		/* multiple characters, assume it's a scancode */
+		int scancode = strtol(key, &endptr, 0);
+		/* not a valid number or scancode is out of range? */
+		if (*endptr || scancode <= 0 || scancode >= SDL_SCANCODE_COUNT) {
 			fprintf(stderr, "ERROR: '%s' is not valid key scancode, got %d\n",
-				key, keycode);
+				key, scancode);
 			return false;
 		}
-    }
-#if 0
-	fprintf(stderr, "Simulated key %s of %d\n",
-		(down? (up? "press":"down") :"up"), key);
-#endif
+		sdlkey.scancode = scancode;
+		sdlkey.key = SDL_GetKeyFromScancode(sdlkey.scancode, SDL_KMOD_NONE, false);
+	} else {
+		/* single character, SDL keycodes match ASCII */
+		sdlkey.key = tolower((unsigned char)key[0]);
+		sdlkey.scancode = SDL_GetScancodeFromKey(sdlkey.key, NULL);
+	}
+	if (down) {
+		sdlkey.type = SDL_EVENT_KEY_DOWN;
+		sdlkey.down = true;
+		Keymap_KeyDown(&sdlkey);
+	}
+	if (up) {
+		sdlkey.type = SDL_EVENT_KEY_UP;
+		sdlkey.down = false;
+		Keymap_KeyUp(&sdlkey);
+	}
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Parse mouse motion command and move the mouse by given amount.
+ * Return false if parsing failed, true otherwise
+ */
+static bool Control_InsertMotion(const char *event)
+{
+	SDL_MouseMotionEvent sdlmotion;
+	int dx, dy;
+
+	if (sscanf(event, "mousemove %d %d", &dx, &dy) != 2) {
+		return false;
+	}
+	memset(&sdlmotion, 0, sizeof(sdlmotion));
+	sdlmotion.type = SDL_EVENT_MOUSE_MOTION;
+	sdlmotion.xrel = dx;
+	sdlmotion.yrel = dy;
+	Keymap_MouseMove(&sdlmotion);
 	return true;
 }
 
@@ -92,20 +135,28 @@ static bool Control_InsertKey(const char *event)
  * 
  * This can be used by external Previous UI(s) on devices which input
  * methods differ from normal keyboard and mouse, such as high DPI
- * touchscreen (no right/middle button, inaccurate clicks)
+ * touchscreen (no right/middle button, inaccurate clicks), or to
+ * drive a headless instance.
  */
 static bool Control_InsertEvent(const char *event)
 {
-	if (strcmp(event, "doubleclick") == 0) {
-//		Keyboard.LButtonDblClk = 1;
+	if (strcmp(event, "leftdown") == 0) {
+		Keymap_MouseDown(true);
+		return true;
+	}
+	if (strcmp(event, "leftup") == 0) {
+		Keymap_MouseUp(true);
 		return true;
 	}
 	if (strcmp(event, "rightdown") == 0) {
-//		Keyboard.bRButtonDown |= BUTTON_MOUSE;
+		Keymap_MouseDown(false);
 		return true;
 	}
 	if (strcmp(event, "rightup") == 0) {
-//		Keyboard.bRButtonDown &= ~BUTTON_MOUSE;
+		Keymap_MouseUp(false);
+		return true;
+	}
+	if (Control_InsertMotion(event)) {
 		return true;
 	}
 	if (Control_InsertKey(event)) {
@@ -114,14 +165,16 @@ static bool Control_InsertEvent(const char *event)
 	fprintf(stderr, "ERROR: unrecognized event: '%s'\n", event);
 	fprintf(stderr,
 		"Supported mouse button and key events are:\n"
-		"- doubleclick\n"
+		"- leftdown\n"
+		"- leftup\n"
 		"- rightdown\n"
 		"- rightup\n"
+		"- mousemove <dx> <dy>\n"
 		"- keypress <key>\n"
 		"- keydown <key>\n"
 		"- keyup <key>\n"
-		"<key> can be either a single ASCII character or an ST scancode\n"
-		"(e.g. space has scancode of 57 and enter 28).\n"
+		"<key> can be either a single ASCII character or an SDL scancode\n"
+		"(e.g. space has scancode of 44 and return 40).\n"
 		);
 	return false;	
 }
@@ -229,6 +282,105 @@ static bool Control_SetPath(char *name)
 	return false;
 }
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Start or stop capturing Ethernet frames to a pcapng file:
+ *   start <file> [<max file size in MB> [<number of files>]]
+ *   stop
+ * Return false if parsing failed, true otherwise
+ */
+static bool Control_Capture(char *args)
+{
+	char *file, *size, *end;
+	uint64_t maxsize = 0;
+	int maxfiles = 0;
+
+	if (strcmp(args, "stop") == 0) {
+		enet_capture_stop();
+		return true;
+	}
+	if (strncmp(args, "start ", 6) != 0) {
+		fprintf(stderr, "ERROR: capture expects 'start <file> [<MB> [<files>]]' or 'stop'\n");
+		return false;
+	}
+	file = Str_Trim(args + 6);
+	size = strchr(file, ' ');
+	if (size) {
+		*size = '\0';
+		maxsize = strtoull(Str_Trim(size + 1), &end, 0) * 1024 * 1024;
+		maxfiles = atoi(end);
+	}
+	if (!enet_capture_start(file, maxsize, maxfiles)) {
+		fprintf(stderr, "ERROR: can't start capture to '%s'\n", file);
+		return false;
+	}
+	fprintf(stderr, "Ethernet capture: %s\n", file);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start or stop sampling host time used by emulated subsystems:
+ *   start <file> [<samples per second>]
+ *   stop
+ * Return false if parsing failed, true otherwise
+ */
+static bool Control_HostProf(char *args)
+{
+	char *file, *rate;
+	int hz = 0;
+
+	if (strcmp(args, "stop") == 0) {
+		HostProf_Stop();
+		return true;
+	}
+	if (strncmp(args, "start ", 6) != 0) {
+		fprintf(stderr, "ERROR: hostprof expects 'start <file> [<Hz>]' or 'stop'\n");
+		return false;
+	}
+	file = Str_Trim(args + 6);
+	rate = strchr(file, ' ');
+	if (rate) {
+		*rate = '\0';
+		hz = atoi(Str_Trim(rate + 1));
+	}
+	return HostProf_Start(file, hz);
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save or restore a snapshot of the whole machine:
+ *   save <file>
+ *   delta <file>
+ *   load <file>
+ *   compact <file> <output file>
+ * Return false if parsing or snapshot failed, true otherwise
+ */
+static bool Control_SnapShot(char *args)
+{
+	char *file, *out;
+
+	if (strncmp(args, "save ", 5) == 0) {
+		return MemorySnapShot_Capture(Str_Trim(args + 5));
+	}
+	if (strncmp(args, "delta ", 6) == 0) {
+		return MemorySnapShot_CaptureDelta(Str_Trim(args + 6));
+	}
+	if (strncmp(args, "load ", 5) == 0) {
+		return MemorySnapShot_Restore(Str_Trim(args + 5));
+	}
+	if (strncmp(args, "compact ", 8) == 0) {
+		file = Str_Trim(args + 8);
+		out = strchr(file, ' ');
+		if (out) {
+			*out = '\0';
+			return MemorySnapShot_Compact(file, Str_Trim(out + 1));
+		}
+	}
+	fprintf(stderr, "ERROR: snapshot expects 'save|delta|load <file>' or 'compact <file> <output>'\n");
+	return false;
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Show Previous remote usage info and return false
@@ -244,6 +396,9 @@ static bool Control_Usage(const char *cmd)
 		"- previous-enable/disable/toggle <device name>\n"
 		"- previous-path <config name> <new path>\n"
 		"- previous-shortcut <shortcut name>\n"
+		"- previous-capture start <file> [<MB> [<files>]] | stop\n"
+		"- previous-hostprof start <file> [<Hz>] | stop\n"
+		"- previous-snapshot save|delta|load <file> | compact <file> <output>\n"
 		"- previous-embed-info\n"
 		"- previous-stop\n"
 		"- previous-cont\n"
@@ -280,13 +435,19 @@ void Control_ProcessBuffer(char *buffer)
 			if (strcmp(cmd, "previous-option") == 0) {
 				ok = Change_ApplyCommandline(arg);
 			} else if (strcmp(cmd, "previous-debug") == 0) {
-				ok = DebugUI_RemoteParse(arg);
+				ok = DebugUI_ParseLine(arg);
 			} else if (strcmp(cmd, "previous-shortcut") == 0) {
 				ok = Shortcut_Invoke(arg);
 			} else if (strcmp(cmd, "previous-event") == 0) {
 				ok = Control_InsertEvent(arg);
 			} else if (strcmp(cmd, "previous-path") == 0) {
 				ok = Control_SetPath(arg);
+			} else if (strcmp(cmd, "previous-capture") == 0) {
+				ok = Control_Capture(arg);
+			} else if (strcmp(cmd, "previous-hostprof") == 0) {
+				ok = Control_HostProf(arg);
+			} else if (strcmp(cmd, "previous-snapshot") == 0) {
+				ok = Control_SnapShot(arg);
 			} else if (strcmp(cmd, "previous-enable") == 0) {
 				ok = Control_DeviceAction(arg, DO_ENABLE);
 			} else if (strcmp(cmd, "previous-disable") == 0) {
@@ -35,8 +35,10 @@
 #include "memory.h"
 #include "newcpu.h"
 #include "cpummu.h"
+#include "m68000.h"
 #include "debug.h"
 #include "log.h"
+#include "hostprof.h"
 
 #define MMUDUMP 1
 
@@ -668,6 +670,8 @@ static uae_u32 mmu_fill_atc(uaecptr addr, bool super, uae_u32 tag, bool write, s
     uae_u32 status = 0;
     int i;
 	int old_s;
+
+    CpuInstruction.ATC_miss++;
     
     // Use supervisor mode to access descriptors (really is fc = 7)
     old_s = regs.s;
@@ -975,7 +979,9 @@ atc_retry:
 	
 	// then initiate table search and create a new entry
 	l = &mmu_atc_array[data][index][way];
+	uint16_t tags = HostProf_Enter(HOSTPROF_MMU);
 	mmu_fill_atc(addr, super, tag, write, l, &status060);
+	HostProf_Leave(tags);
 
 	if (status060 && currprefs.mmu_model == 68060) {
 		mmu_bus_error(addr, val, mmu_get_fc(super, data), write, size, status060, false);
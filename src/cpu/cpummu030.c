@@ -42,7 +42,9 @@
 #include "newcpu.h"
 #include "debug.h"
 #include "cpummu030.h"
+#include "m68000.h"
 #include "savestate.h"
+#include "hostprof.h"
 
 // Prefetch mode and prefetch bus error: always flush and refill prefetch pipeline
 #define MMU030_ALWAYS_FULL_PREFETCH 1
@@ -90,6 +92,7 @@ static struct mmu_debug_data mddm;
 
 static void mmu030_ptest_atc_search(uaecptr logical_addr, uae_u32 fc, bool write);
 static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int level);
+static uae_u32 mmu030_table_walk(uaecptr addr, uae_u32 fc, bool write, int level);
 static TT_info mmu030_decode_tt(uae_u32 TT);
 
 #if MMU_DPAGECACHE030
@@ -1212,7 +1215,16 @@ static void desc_get_quad(uaecptr addr, uae_u32 *descr)
 /* This functions searches through the translation tables. It can be used 
  * for PTEST (levels 1 to 7). Using level 0 creates an ATC entry. */
 
+/* Tag table searches for the host profiler. A bus error during the walk
+ * longjumps out of here, the CPU loop resets the tags in that case. */
 static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int level) {
+    uint16_t tags = HostProf_Enter(HOSTPROF_MMU);
+    uae_u32 ret = mmu030_table_walk(addr, fc, write, level);
+    HostProf_Leave(tags);
+    return ret;
+}
+
+static uae_u32 mmu030_table_walk(uaecptr addr, uae_u32 fc, bool write, int level) {
     /* During table walk up to 7 different descriptors are used:
      * root pointer, descriptors fetched from function code lookup table,
      * tables A, B, C and D and one indirect descriptor */
@@ -1233,6 +1245,7 @@ static uae_u32 mmu030_table_search(uaecptr addr, uae_u32 fc, bool write, int lev
     bool descr_modified = false;
         
     mmu030.status = 0; /* Reset status */
+    CpuInstruction.ATC_miss++;
         
     /* Initial values for condition variables.
      * Note: Root pointer is long descriptor. */
@@ -29,6 +29,7 @@ const char Memory_fileid[] = "Previous memory.c";
 #include "m68000.h"
 #include "configuration.h"
 #include "NextBus.hpp"
+#include "memorySnapShot.h"
 
 #include "newcpu.h"
 
@@ -82,6 +83,20 @@ uae_u8* NEXTRam   = NULL;
 uae_u8* NEXTRom   = NULL;
 uae_u8* NEXTIo    = NULL;
 
+/* Allocated sizes of main memory and VRAM */
+static int ram_size;
+static int vram_size;
+
+/* One byte per page, set on every write since the last snapshot */
+static uae_u8* NEXTRamDirty   = NULL;
+static uae_u8* NEXTVideoDirty = NULL;
+
+#define RAM_DIRTY(addr,n)   (NEXTRamDirty[(addr)>>MEMSNAP_PAGE_SHIFT] = 1, NEXTRamDirty[((addr)+(n)-1)>>MEMSNAP_PAGE_SHIFT] = 1)
+#define VIDEO_DIRTY(addr,n) (NEXTVideoDirty[(addr)>>MEMSNAP_PAGE_SHIFT] = 1, NEXTVideoDirty[((addr)+(n)-1)>>MEMSNAP_PAGE_SHIFT] = 1)
+
+/* Incremented on every write to VRAM, used to skip unchanged frames */
+volatile uae_u32 NEXTVideoGeneration = 0;
+
 /* Unused stuff */
 uae_u8 ce_banktype[65536], ce_cachable[65536];
 
@@ -345,18 +360,21 @@ static void mem_ram_bank0_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= next_ram_bank0_mask;
 	do_put_mem_long(NEXTRam + addr, l);
+	RAM_DIRTY(addr, 4);
 }
 
 static void mem_ram_bank0_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= next_ram_bank0_mask;
 	do_put_mem_word(NEXTRam + addr, w);
+	RAM_DIRTY(addr, 2);
 }
 
 static void mem_ram_bank0_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= next_ram_bank0_mask;
 	NEXTRam[addr] = b;
+	RAM_DIRTY(addr, 1);
 }
 
 
@@ -382,18 +400,21 @@ static void mem_ram_bank1_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= next_ram_bank1_mask;
 	do_put_mem_long(NEXTRam + addr, l);
+	RAM_DIRTY(addr, 4);
 }
 
 static void mem_ram_bank1_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= next_ram_bank1_mask;
 	do_put_mem_word(NEXTRam + addr, w);
+	RAM_DIRTY(addr, 2);
 }
 
 static void mem_ram_bank1_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= next_ram_bank1_mask;
 	NEXTRam[addr] = b;
+	RAM_DIRTY(addr, 1);
 }
 
 
@@ -419,18 +440,21 @@ static void mem_ram_bank2_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= next_ram_bank2_mask;
 	do_put_mem_long(NEXTRam + addr, l);
+	RAM_DIRTY(addr, 4);
 }
 
 static void mem_ram_bank2_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= next_ram_bank2_mask;
 	do_put_mem_word(NEXTRam + addr, w);
+	RAM_DIRTY(addr, 2);
 }
 
 static void mem_ram_bank2_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= next_ram_bank2_mask;
 	NEXTRam[addr] = b;
+	RAM_DIRTY(addr, 1);
 }
 
 
@@ -456,18 +480,21 @@ static void mem_ram_bank3_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= next_ram_bank3_mask;
 	do_put_mem_long(NEXTRam + addr, l);
+	RAM_DIRTY(addr, 4);
 }
 
 static void mem_ram_bank3_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= next_ram_bank3_mask;
 	do_put_mem_word(NEXTRam + addr, w);
+	RAM_DIRTY(addr, 2);
 }
 
 static void mem_ram_bank3_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= next_ram_bank3_mask;
 	NEXTRam[addr] = b;
+	RAM_DIRTY(addr, 1);
 }
 
 
@@ -540,18 +567,24 @@ static void mem_video_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= NEXT_VRAM_MASK;
 	do_put_mem_long(NEXTVideo + addr, l);
+	VIDEO_DIRTY(addr, 4);
+	NEXTVideoGeneration++;
 }
 
 static void mem_video_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= NEXT_VRAM_MASK;
 	do_put_mem_word(NEXTVideo + addr, w);
+	VIDEO_DIRTY(addr, 2);
+	NEXTVideoGeneration++;
 }
 
 static void mem_video_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= NEXT_VRAM_MASK;
 	NEXTVideo[addr] = b;
+	VIDEO_DIRTY(addr, 1);
+	NEXTVideoGeneration++;
 }
 
 
@@ -763,18 +796,24 @@ static void mem_color_video_lput(uaecptr addr, uae_u32 l)
 {
 	addr &= NEXT_VRAM_COLOR_MASK;
 	do_put_mem_long(NEXTVideo + addr, l);
+	VIDEO_DIRTY(addr, 4);
+	NEXTVideoGeneration++;
 }
 
 static void mem_color_video_wput(uaecptr addr, uae_u32 w)
 {
 	addr &= NEXT_VRAM_COLOR_MASK;
 	do_put_mem_word(NEXTVideo + addr, w);
+	VIDEO_DIRTY(addr, 2);
+	NEXTVideoGeneration++;
 }
 
 static void mem_color_video_bput(uaecptr addr, uae_u32 b)
 {
 	addr &= NEXT_VRAM_COLOR_MASK;
 	NEXTVideo[addr] = b;
+	VIDEO_DIRTY(addr, 1);
+	NEXTVideoGeneration++;
 }
 
 
@@ -1010,9 +1049,6 @@ int memory_init (void)
 	uae_u32 bankstart[4];
 	uae_u32 banksize[4];
 	
-	int ram_size;
-	int vram_size;
-	
 	write_log("Memory init: Memory size: %iMB\n", Configuration_CheckMemory(ConfigureParams.Memory.nMemoryBankSize));
 	
 	/* Set machine dependent variables */
@@ -1039,11 +1075,16 @@ int memory_init (void)
 	/* Allocate memory */
 	NEXTRam   = malloc_aligned(ram_size);
 	NEXTVideo = malloc_aligned(vram_size);
+	NEXTVideoGeneration++;
 	NEXTIo    = malloc_aligned(NEXT_IO_ALLOC);
 	NEXTRom   = malloc_aligned(NEXT_EPROM_ALLOC);
 	
+	/* Everything differs from the last snapshot after reset */
+	NEXTRamDirty   = malloc((ram_size>>MEMSNAP_PAGE_SHIFT)+1);
+	NEXTVideoDirty = malloc((vram_size>>MEMSNAP_PAGE_SHIFT)+1);
+	
 	/* Check if memory allocation was successful */
-	if (!(NEXTRom && NEXTVideo && NEXTRam && NEXTIo)) {
+	if (!(NEXTRom && NEXTVideo && NEXTRam && NEXTIo && NEXTRamDirty && NEXTVideoDirty)) {
 		write_log("Memory init: Cannot allocate memory\n");
 		return 1;
 	}
@@ -1053,6 +1094,8 @@ int memory_init (void)
 	memset(NEXTVideo, 0, vram_size);
 	memset(NEXTRam, 0, ram_size);
 	memset(NEXTIo, 0, NEXT_IO_ALLOC);
+	memset(NEXTRamDirty, 1, (ram_size>>MEMSNAP_PAGE_SHIFT)+1);
+	memset(NEXTVideoDirty, 1, (vram_size>>MEMSNAP_PAGE_SHIFT)+1);
 	
 	/* Load ROM file */
 	if (rom_load(NEXTRom, NEXT_EPROM_ALLOC)) {
@@ -1220,8 +1263,29 @@ void memory_uninit (void)
 	free(NEXTVideo);
 	free(NEXTRam);
 	free(NEXTIo);
+	free(NEXTRamDirty);
+	free(NEXTVideoDirty);
 	
 	NEXTRom = NEXTVideo = NEXTRam = NEXTIo = NULL;
+	NEXTRamDirty = NEXTVideoDirty = NULL;
+}
+
+
+/*
+ * Save/Restore snapshot of main memory, VRAM and I/O memory.
+ * Memory must be allocated with the same sizes when restoring.
+ * Incremental snapshots only contain main memory and VRAM pages
+ * written since the last snapshot.
+ */
+void NEXTMemory_MemorySnapShot_Capture(bool bSave)
+{
+	MemorySnapShot_StorePages(NEXTRam, ram_size, NEXTRamDirty);
+	MemorySnapShot_StorePages(NEXTVideo, vram_size, NEXTVideoDirty);
+	MemorySnapShot_StoreBlock(NEXTIo, NEXT_IO_ALLOC);
+	
+	if (!bSave) {
+		NEXTVideoGeneration++;
+	}
 }
 
 
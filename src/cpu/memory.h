@@ -22,6 +22,7 @@ extern int jit_n_addr_unsafe;
 #define call_mem_put_func(func, addr, v) ((*func)(addr, v))
 
 extern uae_u8* NEXTVideo;
+extern volatile uae_u32 NEXTVideoGeneration;
 extern uae_u8* NEXTRam;
 extern uae_u8* NEXTRom;
 extern uae_u8* NEXTIo;
@@ -50,6 +51,7 @@ extern mem_put_func bank_bput[65536];
 
 int  memory_init(void);
 void memory_uninit(void);
+void NEXTMemory_MemorySnapShot_Capture(bool bSave);
 void map_banks(addrbank *bank, uae_u32 start, uae_u32 size);
 
 #define get_long(addr)   (call_mem_get_func(get_mem_bank(bank_lget, addr), addr))
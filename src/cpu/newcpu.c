@@ -48,6 +48,7 @@
 #include "dimension.hpp"
 #include "sysReg.h"
 #include "debugcpu.h"
+#include "hostprof.h"
 #endif
 
 
@@ -5129,6 +5130,7 @@ static inline void run_other_MPUs(void)
 {
 	static int ndCycles = 0;
 
+	nCpuInstrExecuted++;
 	ndCycles += cpu_cycles;
 	// bundle some 68k cycles for MPUs
 #if ENABLE_DSP_EMU
@@ -5141,6 +5143,15 @@ static inline void run_other_MPUs(void)
 	}
 
 	M68000_AddCycles(cpu_cycles);
+
+	/* Fast-forward to the next event while STOP waits for an interrupt */
+	if (regs.stopped && !regs.spcflags
+#if ENABLE_DSP_EMU
+	    && !dsp_core.running
+#endif
+	   ) {
+		ndCycles += CycInt_Idle();
+	}
 }
 
 static int do_specialties (int cycles)
@@ -6417,6 +6428,8 @@ static void m68k_run_mmu040 (void)
 				}
 			}
 		} CATCH (prb) {
+			/* exception may have unwound tagged code */
+			HostProf_Leave(0);
 
 			if (mmu_restart) {
 				/* restore state if instruction restart */
@@ -6527,6 +6540,8 @@ insretry:
 			}
 
 		} CATCH (prb) {
+			/* exception may have unwound tagged code */
+			HostProf_Leave(0);
 
 			if (mmu030_opcode == -1) {
 				// full prefetch fill access fault
@@ -9213,9 +9228,7 @@ static void fill_icache020 (uae_u32 addr, bool opcode)
 		regs.cacheholdingaddr020 = addr;
 		regs.cacheholdingdata020 = c->data;
 		regs.cacheholdingdata_valid = 1;
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.I_Cache_hit++;
-#endif
 		return;
 	}
 
@@ -9245,9 +9258,7 @@ static void fill_icache020 (uae_u32 addr, bool opcode)
 	regs.cacheholdingaddr020 = addr;
 	regs.cacheholdingdata020 = data;
 	regs.cacheholdingdata_valid = 1;
-#ifndef WINUAE_FOR_PREVIOUS
 	CpuInstruction.I_Cache_miss++;
-#endif
 }
 
 #if MORE_ACCURATE_68020_PIPELINE
@@ -9770,9 +9781,7 @@ static void fill_icache030(uae_u32 addr)
 		regs.cacheholdingaddr020 = addr;
 		regs.cacheholdingdata020 = c->data[lws];
 //fprintf ( stderr , "fill ica %x -> hit %x %x\n" , addr , regs.cacheholdingdata020 , regs.cacr );
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.I_Cache_hit++;
-#endif
 		return;
 	}
 
@@ -9861,9 +9870,7 @@ static void fill_icache030(uae_u32 addr)
 	regs.cacheholdingaddr020 = addr;
 	regs.cacheholdingdata020 = data;
 //fprintf ( stderr , "fill ica %x -> miss %x\n" , addr , regs.cacheholdingdata020 );
-#ifndef WINUAE_FOR_PREVIOUS
 	CpuInstruction.I_Cache_miss++;
-#endif
 }
 
 #if VALIDATE_68030_DATACACHE
@@ -10178,15 +10185,11 @@ static bool read_dcache030_2(uaecptr addr, uae_u32 size, uae_u32 *valp)
 		validate_dcache030();
 #endif
 //fprintf ( stderr , "read cache %x %x %d tag1 %x lws1 %x tag2 %x lws2 %x ref %x\n", addr, v1, size, tag1, lws1, tag2, lws2 , get_long (0x1f81ec) );
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.D_Cache_miss++;
-#endif
 	} else {
 		// Cache hit, inhibited caching do not prevent read hits.
 		v1 = c1->data[lws1];
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.D_Cache_hit++;
-#endif
 	}
 
 	// only one long fetch needed?
@@ -10215,14 +10218,10 @@ static bool read_dcache030_2(uaecptr addr, uae_u32 size, uae_u32 *valp)
 		validate_dcache030();
 #endif
 //fprintf ( stderr , "read cache %x %x %d tag1 %x lws1 %x tag2 %x lws2 %x\n", addr, v1, size, tag1, lws1, tag2, lws2 );
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.D_Cache_miss++;
-#endif
 	} else {
 		v2 = c2->data[lws2];
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.D_Cache_hit++;
-#endif
 	}
 
 	uae_u64 v64 = ((uae_u64)v1 << 32) | v2;
@@ -10514,9 +10513,7 @@ uae_u32 fill_icache040(uae_u32 addr)
 				if ((lws & 1) != icachehalfline) {
 					icachehalfline ^= 1;
 					icachelinecnt++;
-#ifndef WINUAE_FOR_PREVIOUS
 				CpuInstruction.I_Cache_hit++;
-#endif
 				}
 				return c->data[cache_lastline][lws];
 			}
@@ -10553,9 +10550,7 @@ uae_u32 fill_icache040(uae_u32 addr)
 			icachehalfline ^= 1;
 			icachelinecnt++;
 		}
-#ifndef WINUAE_FOR_PREVIOUS
 		CpuInstruction.I_Cache_miss++;
-#endif
 		return c->data[line][lws];
 
 	}
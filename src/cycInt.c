@@ -17,6 +17,7 @@ const char CycInt_fileid[] = "Previous cycInt.c";
 #include "cycInt.h"
 #include "configuration.h"
 #include "timing.h"
+#include "host.h"
 #include "video.h"
 #include "sysReg.h"
 #include "esp.h"
@@ -29,9 +30,12 @@ const char CycInt_fileid[] = "Previous cycInt.c";
 #include "scc.h"
 #include "tablet.h"
 #include "dimension.hpp"
+#include "hostprof.h"
+#include "memorySnapShot.h"
 
 
 #define CHECK_INTERVAL 100
+#define IDLE_INTERVAL  10000
 
 uint64_t nCyclesMainCounter; /* Main cycles counter, counts emulated CPU cycles since reset */
 
@@ -119,7 +123,9 @@ void CycInt_AddCycles(int Cycles) {
 		EventList[i].type = TYPE_NONE;
 		nCyclesFirst = EventList[i].next;
 		EventList[nCyclesFirst].prev = EVENT_NULL;
+		uint16_t tags = HostProf_Enter(HOSTPROF_CYCINT);
 		EventList[i].func();
+		HostProf_Leave(tags);
 	}
 	if (nCheckCycles <= nCyclesMainCounter) {
 		nTimeNow = Timing_GetTime();
@@ -136,13 +142,57 @@ void CycInt_AddCycles(int Cycles) {
 				EventList[i].type = TYPE_NONE;
 				nTimeFirst = EventList[i].next;
 				EventList[nTimeFirst].prev = EVENT_NULL;
+				uint16_t tags = HostProf_Enter(HOSTPROF_CYCINT);
 				EventList[i].func();
+				HostProf_Leave(tags);
 			}
 		}
 		nCheckCycles = nCyclesMainCounter + CHECK_INTERVAL * ConfigureParams.System.nCpuFreq;
 	}
 }
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Skip cycles up to the next event while the CPU is stopped and waiting
+ * for an interrupt. Nothing but events can change the machine state until
+ * then. If the next event is due at a realtime instant, the host thread
+ * sleeps until then. Returns the number of cycles skipped.
+ */
+int CycInt_Idle(void) {
+	int cycles;
+	uint64_t target = EventList[nCyclesFirst].time;
+	uint64_t limit  = nCyclesMainCounter + IDLE_INTERVAL * ConfigureParams.System.nCpuFreq;
+	
+	if (nTimeFirst) {
+		nTimeNow = Timing_GetTime();
+		int64_t diff = EventList[nTimeFirst].time - nTimeNow;
+		if (diff <= 0) {
+			target = nCyclesMainCounter;
+		} else if (nCyclesMainCounter + diff * ConfigureParams.System.nCpuFreq < target) {
+			if (diff > IDLE_INTERVAL) {
+				diff = IDLE_INTERVAL;
+			}
+			if (Timing_IsRealtime()) {
+				host_sleep_us(diff);
+			}
+			target = nCyclesMainCounter + diff * ConfigureParams.System.nCpuFreq;
+		}
+		if (nCheckCycles > target) {
+			nCheckCycles = target;
+		}
+	}
+	if (target > limit) {
+		target = limit;
+	}
+	if (target < nCyclesMainCounter) {
+		target = nCyclesMainCounter;
+	}
+	cycles = (int)(target - nCyclesMainCounter);
+	CycInt_AddCycles(cycles);
+	
+	return cycles;
+}
+
 /*-----------------------------------------------------------------------*/
 /**
  * Add event to the queue.
@@ -283,3 +333,26 @@ void CycInt_RemovePendingEvent(event_id i) {
 bool CycInt_EventPending(event_id i) {
 	return (EventList[i].type != TYPE_NONE);
 }
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save/Restore snapshot of pending events and counters.
+ * Handler pointers are not stored, they never change.
+ */
+void CycInt_MemorySnapShot_Capture(bool bSave) {
+	event_id i;
+
+	MemorySnapShot_Store(&nCyclesMainCounter, sizeof(nCyclesMainCounter));
+	MemorySnapShot_Store(&nCheckCycles, sizeof(nCheckCycles));
+	MemorySnapShot_Store(&nTimeNow, sizeof(nTimeNow));
+	MemorySnapShot_Store(&nCyclesFirst, sizeof(nCyclesFirst));
+	MemorySnapShot_Store(&nTimeFirst, sizeof(nTimeFirst));
+
+	for (i = EVENT_NULL; i < NUM_EVENTS; i++) {
+		MemorySnapShot_Store(&EventList[i].type, sizeof(EventList[i].type));
+		MemorySnapShot_Store(&EventList[i].time, sizeof(EventList[i].time));
+		MemorySnapShot_Store(&EventList[i].prev, sizeof(EventList[i].prev));
+		MemorySnapShot_Store(&EventList[i].next, sizeof(EventList[i].next));
+	}
+}
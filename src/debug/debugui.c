@@ -27,6 +27,7 @@ const char DebugUI_fileid[] = "Hatari debugui.c";
 #include "file.h"
 #include "log.h"
 #include "m68000.h"
+#include "memorySnapShot.h"
 #include "reset.h"
 #include "screen.h"
 #include "str.h"
@@ -40,6 +41,7 @@ const char DebugUI_fileid[] = "Hatari debugui.c";
 #include "debugui.h"
 #include "evaluate.h"
 #include "history.h"
+#include "hostprof.h"
 #include "profile.h"
 #include "symbols.h"
 #include "vars.h"
@@ -370,6 +372,48 @@ static int DebugUI_Echo(int argc, char *argv[])
 	return DEBUGGER_CMDDONE;
 }
 
+/**
+ * Command: Save/restore snapshot of the whole machine
+ */
+static int DebugUI_SnapShot(int argc, char *argv[])
+{
+	if (argc == 4 && strcmp(argv[1], "compact") == 0)
+		MemorySnapShot_Compact(argv[2], argv[3]);
+	else if (argc != 3)
+		return DebugUI_PrintCmdHelp(argv[0]);
+	else if (strcmp(argv[1], "save") == 0)
+		MemorySnapShot_Capture(argv[2]);
+	else if (strcmp(argv[1], "delta") == 0)
+		MemorySnapShot_CaptureDelta(argv[2]);
+	else if (strcmp(argv[1], "load") == 0)
+		MemorySnapShot_Restore(argv[2]);
+	else
+		return DebugUI_PrintCmdHelp(argv[0]);
+
+	return DEBUGGER_CMDDONE;
+}
+
+/**
+ * Command: Start/stop sampling of host time spent in emulated subsystems
+ */
+static int DebugUI_HostProfile(int argc, char *argv[])
+{
+	int hz = 0;
+
+	if (argc >= 3 && strcmp(argv[1], "start") == 0)
+	{
+		if (argc > 3)
+			hz = atoi(argv[3]);
+		HostProf_Start(argv[2], hz);
+	}
+	else if (argc == 2 && strcmp(argv[1], "stop") == 0)
+		HostProf_Stop();
+	else
+		return DebugUI_PrintCmdHelp(argv[0]);
+
+	return DEBUGGER_CMDDONE;
+}
+
 /**
  * Command: Rename file
  */
@@ -1002,6 +1046,26 @@ static const dbgcommand_t uicommand[] =
 	  "\tGiving just count will show (at max) given number of last saved PC\n"
 	  "\tvalues and instructions currently at corresponding RAM addresses.",
 	  false },
+	{ DebugUI_HostProfile, NULL,
+	  "hostprofile", "",
+	  "sample host time used by emulated subsystems",
+	  "start <file> [hz]|stop\n"
+	  "\tSample which emulator thread and subsystem (CPU, DSP, i860,\n"
+	  "\tMMU, SCSI, ...) host CPU time is spent in, 'hz' times per second\n"
+	  "\t(default 997). On stop, samples are written to <file> as folded\n"
+	  "\tstacks for flame graph tools.",
+	  false },
+	{ DebugUI_SnapShot, NULL,
+	  "snapshot", "",
+	  "save or restore a snapshot of the whole machine",
+	  "save|delta|load <file>|compact <file> <output>\n"
+	  "\tSave emulated machine state to <file> or restore it. 'delta'\n"
+	  "\tsaves only memory changed since the last snapshot saved or\n"
+	  "\trestored, which must be kept. 'compact' merges a delta and the\n"
+	  "\tsnapshots it is based on into a full snapshot. Snapshots can\n"
+	  "\tonly be restored by the same build and machine configuration.\n"
+	  "\tDisk images are not part of the snapshot.",
+	  false },
 	{ DebugInfo_Command, DebugInfo_MatchInfo,
 	  "info", "i",
 	  "show machine/OS information",
@@ -12,7 +12,9 @@ const char Profile_fileid[] = "Hatari profile.c";
 
 #include "main.h"
 #include "debugui.h"
+#include "debug_priv.h"
 #include "profile.h"
+#include "profile_priv.h"
 
 
 /* ------------------- command parsing ---------------------- */
@@ -24,11 +26,30 @@ const char Profile_fileid[] = "Hatari profile.c";
  */
 char *Profile_Match(const char *text, int state)
 {
-	return NULL;
+	static const char *names[] = {
+		"atc", "counts", "cycles", "loops", "misses", "off", "on", "save", "stats", "symbols"
+	};
+	return DebugUI_MatchHelper(names, ARRAY_SIZE(names), text, state);
 }
 
 const char Profile_Description[] =
-	  "<profile command is not supported on Previous>";
+	  "<on|off|stats|counts|cycles|misses|atc|loops|symbols|save> [count|file]\n"
+	  "\t'on' and 'off' enable and disable profiling.  Data is collected\n"
+	  "\tuntil the debugger is entered again, at which point the results\n"
+	  "\tcan be shown with the other subcommands.\n"
+	  "\n"
+	  "\t'stats' shows a summary of the collected data.  'counts',\n"
+	  "\t'cycles', 'misses' and 'atc' list the PC addresses sorted by\n"
+	  "\texecution count, used cycles, instruction cache misses or ATC\n"
+	  "\tmisses.  'symbols' lists functions sorted by used cycles, using\n"
+	  "\tthe loaded code symbols.  Optional count limits the number of\n"
+	  "\tlisted items.\n"
+	  "\n"
+	  "\tFor the DSP, 'misses', 'atc' and 'symbols' are not available.\n"
+	  "\tInstead 'loops' lists DO and REP loops sorted by iteration count.\n"
+	  "\n"
+	  "\t'save' writes profile data for all addresses to the given file\n"
+	  "\tin callgrind format, e.g. for viewing with KCachegrind.";
 
 
 /**
@@ -37,5 +58,88 @@ const char Profile_Description[] =
  */
 int Profile_Command(int nArgc, char *psArgs[], bool bForDsp)
 {
+	static int show = 16;
+	const char *cmd, *proc = bForDsp ? "DSP" : "CPU";
+	FILE *out;
+	bool ok;
+
+	if (nArgc < 2)
+	{
+		DebugUI_PrintCmdHelp(psArgs[0]);
+		return DEBUGGER_CMDDONE;
+	}
+	cmd = psArgs[1];
+
+	if (strcmp(cmd, "on") == 0)
+	{
+		if (bForDsp)
+			Profile_DspEnable(true);
+		else
+			Profile_CpuEnable(true);
+		fprintf(stderr, "%s profiling enabled.\n", proc);
+		return DEBUGGER_CMDDONE;
+	}
+	if (strcmp(cmd, "off") == 0)
+	{
+		if (bForDsp)
+			Profile_DspEnable(false);
+		else
+			Profile_CpuEnable(false);
+		fprintf(stderr, "%s profiling disabled.\n", proc);
+		return DEBUGGER_CMDDONE;
+	}
+	if (strcmp(cmd, "save") == 0)
+	{
+		if (nArgc < 3)
+		{
+			DebugUI_PrintCmdHelp(psArgs[0]);
+			return DEBUGGER_CMDDONE;
+		}
+		out = fopen(psArgs[2], "w");
+		if (!out)
+		{
+			fprintf(stderr, "ERROR: opening '%s' for writing failed!\n", psArgs[2]);
+			return DEBUGGER_CMDDONE;
+		}
+		ok = bForDsp ? Profile_DspSave(out) : Profile_CpuSave(out);
+		if (ok)
+			fprintf(stderr, "%s profile data saved to '%s'.\n", proc, psArgs[2]);
+		fclose(out);
+		return DEBUGGER_CMDDONE;
+	}
+
+	if (nArgc > 2 && atoi(psArgs[2]) > 0)
+		show = atoi(psArgs[2]);
+
+	if (bForDsp)
+	{
+		if (strcmp(cmd, "stats") == 0)
+			Profile_DspShowStats();
+		else if (strcmp(cmd, "counts") == 0)
+			Profile_DspShowCounts(show);
+		else if (strcmp(cmd, "cycles") == 0)
+			Profile_DspShowCycles(show);
+		else if (strcmp(cmd, "loops") == 0)
+			Profile_DspShowLoops(show);
+		else
+			DebugUI_PrintCmdHelp(psArgs[0]);
+		return DEBUGGER_CMDDONE;
+	}
+
+	if (strcmp(cmd, "stats") == 0)
+		Profile_CpuShowStats();
+	else if (strcmp(cmd, "counts") == 0)
+		Profile_CpuShowCounts(show);
+	else if (strcmp(cmd, "cycles") == 0)
+		Profile_CpuShowCycles(show);
+	else if (strcmp(cmd, "misses") == 0)
+		Profile_CpuShowMisses(show);
+	else if (strcmp(cmd, "atc") == 0)
+		Profile_CpuShowAtcMisses(show);
+	else if (strcmp(cmd, "symbols") == 0)
+		Profile_CpuShowSymbols(show);
+	else
+		DebugUI_PrintCmdHelp(psArgs[0]);
+
 	return DEBUGGER_CMDDONE;
 }
@@ -0,0 +1,35 @@
+/*
+ * Hatari - profile_priv.h
+ *
+ * This file is distributed under the GNU General Public License, version 2
+ * or at your option any later version. Read the file gpl.txt for details.
+ *
+ * Internal header used by profiler files.
+ */
+
+#ifndef HATARI_PROFILE_PRIV_H
+#define HATARI_PROFILE_PRIV_H
+
+/* CPU profile control */
+extern void Profile_CpuEnable(bool enable);
+
+/* CPU profile results */
+extern void Profile_CpuShowStats(void);
+extern void Profile_CpuShowCounts(int show);
+extern void Profile_CpuShowCycles(int show);
+extern void Profile_CpuShowMisses(int show);
+extern void Profile_CpuShowAtcMisses(int show);
+extern void Profile_CpuShowSymbols(int show);
+extern bool Profile_CpuSave(FILE *out);
+
+/* DSP profile control */
+extern void Profile_DspEnable(bool enable);
+
+/* DSP profile results */
+extern void Profile_DspShowStats(void);
+extern void Profile_DspShowCounts(int show);
+extern void Profile_DspShowCycles(int show);
+extern void Profile_DspShowLoops(int show);
+extern bool Profile_DspSave(FILE *out);
+
+#endif
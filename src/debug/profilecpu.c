@@ -1,17 +1,91 @@
 /*
  * Hatari - profilecpu.c
- * 
+ *
  * Copyright (C) 2010-2026 by Eero Tamminen
  *
  * This file is distributed under the GNU General Public License, version 2
  * or at your option any later version. Read the file gpl.txt for details.
  *
  * profilecpu.c - functions for profiling CPU and showing the results.
+ *
+ * NeXTstep runs code all over the 32-bit virtual address space, so
+ * instead of one array per memory region, profile data is kept in
+ * pages of flat arrays indexed by (PC - page base)/2.  Pages are
+ * allocated when code in them is executed for the first time.
  */
 const char Profilecpu_fileid[] = "Hatari profilecpu.c";
 
+#include <inttypes.h>
 #include "main.h"
+#include "m68000.h"
+#include "debug_priv.h"
+#include "symbols.h"
 #include "profile.h"
+#include "profile_priv.h"
+
+#define PROFILE_PAGE_SHIFT 12
+#define PROFILE_PAGE_MASK  ((1 << PROFILE_PAGE_SHIFT) - 1)
+#define PROFILE_PAGE_ITEMS (1 << (PROFILE_PAGE_SHIFT - 1))  /* instructions are word aligned */
+#define PROFILE_PAGE_COUNT (1 << (32 - PROFILE_PAGE_SHIFT))
+
+typedef struct {
+	uint64_t count;       /* how many times this address instruction is executed */
+	uint64_t cycles;      /* how many CPU cycles was taken at this address */
+	uint32_t i_misses;    /* how many CPU instruction cache misses happened at this address */
+	uint32_t atc_misses;  /* how many ATC misses happened at this address */
+} cpu_profile_item_t;
+
+typedef struct {
+	uint64_t count;
+	uint64_t cycles;
+	uint64_t i_misses;
+	uint64_t atc_misses;
+} cpu_profile_totals_t;
+
+typedef struct {
+	char *name;
+	uint32_t addr;
+	cpu_profile_totals_t data;
+} cpu_profile_func_t;
+
+static struct {
+	cpu_profile_item_t **pages;  /* profile data pages, NULL if not executed */
+	uint32_t prev_pc;            /* previous PC for which the cycles are for */
+	uint64_t prev_cycles;        /* previous cycles counter value */
+	uint32_t *sort_arr;          /* addresses with profile data */
+	uint32_t active;             /* number of addresses with profile data */
+	uint32_t allocated;          /* number of allocated data pages */
+	cpu_profile_totals_t all;    /* totals for all addresses */
+	bool enabled;                /* true when profiling enabled */
+	bool processed;              /* true when data is processed for showing */
+} cpu_profile;
+
+
+/**
+ * Return profile data item for given address, or NULL if there's none.
+ */
+static cpu_profile_item_t *Profile_CpuItem(uint32_t addr)
+{
+	cpu_profile_item_t *page;
+
+	if (!cpu_profile.pages)
+		return NULL;
+	page = cpu_profile.pages[addr >> PROFILE_PAGE_SHIFT];
+	if (!page)
+		return NULL;
+	return &page[(addr & PROFILE_PAGE_MASK) >> 1];
+}
+
+/**
+ * Return true if there are processed results to show, false otherwise.
+ */
+static bool Profile_CpuHasResults(void)
+{
+	if (cpu_profile.processed && cpu_profile.active)
+		return true;
+	fprintf(stderr, "No CPU profiling data available.\n");
+	return false;
+}
 
 
 /* ------------------ CPU profile results ----------------- */
@@ -21,7 +95,8 @@ const char Profilecpu_fileid[] = "Hatari profilecpu.c";
  */
 bool Profile_CpuAddr_HasData(uint32_t addr)
 {
-	return false;
+	cpu_profile_item_t *item = Profile_CpuItem(addr);
+	return item && item->count;
 }
 
 /**
@@ -33,16 +108,307 @@ bool Profile_CpuAddr_HasData(uint32_t addr)
  */
 int Profile_CpuAddr_DataStr(char *buffer, int maxlen, uint32_t addr)
 {
-	return 0;
+	cpu_profile_item_t *item = Profile_CpuItem(addr);
+	float percentage;
+	int len;
+
+	if (!item || !item->count)
+		return 0;
+
+	if (cpu_profile.all.count)
+		percentage = 100.0 * item->count / cpu_profile.all.count;
+	else
+		percentage = 0.0;
+
+	len = snprintf(buffer, maxlen, "%5.2f%% (%"PRIu64", %"PRIu64", %u, %u)",
+	               percentage, item->count, item->cycles,
+	               item->i_misses, item->atc_misses);
+	return (len < maxlen) ? len : maxlen - 1;
+}
+
+/**
+ * Show CPU profile statistics summary.
+ */
+void Profile_CpuShowStats(void)
+{
+	if (!Profile_CpuHasResults())
+		return;
+
+	fprintf(stderr, "CPU profile statistics:\n");
+	fprintf(stderr, "- active address range:\n  0x%08x-0x%08x\n",
+	        cpu_profile.sort_arr[0], cpu_profile.sort_arr[cpu_profile.active-1]);
+	fprintf(stderr, "- active instruction addresses:\n  %u (in %u pages, %u kB)\n",
+	        cpu_profile.active, cpu_profile.allocated,
+	        (uint32_t)(cpu_profile.allocated * PROFILE_PAGE_ITEMS * sizeof(cpu_profile_item_t) / 1024));
+	fprintf(stderr, "- executed instructions:\n  %"PRIu64"\n", cpu_profile.all.count);
+	fprintf(stderr, "- used cycles:\n  %"PRIu64"\n", cpu_profile.all.cycles);
+	fprintf(stderr, "- instruction cache misses:\n  %"PRIu64"\n", cpu_profile.all.i_misses);
+	fprintf(stderr, "- ATC misses:\n  %"PRIu64"\n", cpu_profile.all.atc_misses);
+}
+
+/* qsort callbacks for sorting addresses by their profile data */
+static int cmp_addr(const void *p1, const void *p2)
+{
+	uint32_t a1 = *(const uint32_t*)p1;
+	uint32_t a2 = *(const uint32_t*)p2;
+	return (a1 > a2) - (a1 < a2);
+}
+#define CMP_FIELD(field) \
+static int cmp_##field(const void *p1, const void *p2) \
+{ \
+	uint64_t v1 = Profile_CpuItem(*(const uint32_t*)p1)->field; \
+	uint64_t v2 = Profile_CpuItem(*(const uint32_t*)p2)->field; \
+	return (v1 < v2) - (v1 > v2); \
+}
+CMP_FIELD(count)
+CMP_FIELD(cycles)
+CMP_FIELD(i_misses)
+CMP_FIELD(atc_misses)
+
+/**
+ * Sort addresses with given callback and show first ones with their
+ * profile data, percentage is for the sorted value.
+ */
+static void Profile_CpuShowList(int show, int (*cmp)(const void*, const void*),
+                                uint64_t (*value)(cpu_profile_item_t*), uint64_t total,
+                                const char *what)
+{
+	cpu_profile_item_t *item;
+	const char *symbol;
+	uint32_t i, addr;
+
+	if (!Profile_CpuHasResults())
+		return;
+
+	qsort(cpu_profile.sort_arr, cpu_profile.active, sizeof(uint32_t), cmp);
+
+	fprintf(debugOutput, "addr:\t\t%s:\tcount:\t\tcycles:\t\ti-misses:\tatc-misses:\n", what);
+	for (i = 0; i < cpu_profile.active && i < (uint32_t)show; i++)
+	{
+		addr = cpu_profile.sort_arr[i];
+		item = Profile_CpuItem(addr);
+		if (!value(item))
+			break;
+		fprintf(debugOutput, "0x%08x\t%5.2f%%\t\t%-10"PRIu64"\t%-10"PRIu64"\t%-10u\t%u",
+		        addr, total ? 100.0 * value(item) / total : 0.0,
+		        item->count, item->cycles, item->i_misses, item->atc_misses);
+		symbol = Symbols_GetByCpuAddress(addr, SYMTYPE_CODE);
+		if (symbol)
+			fprintf(debugOutput, "\t%s", symbol);
+		fputc('\n', debugOutput);
+	}
+	fprintf(debugOutput, "%u CPU addresses listed.\n", i);
+
+	/* restore address order */
+	qsort(cpu_profile.sort_arr, cpu_profile.active, sizeof(uint32_t), cmp_addr);
+}
+
+static uint64_t value_count(cpu_profile_item_t *item) { return item->count; }
+static uint64_t value_cycles(cpu_profile_item_t *item) { return item->cycles; }
+static uint64_t value_i_misses(cpu_profile_item_t *item) { return item->i_misses; }
+static uint64_t value_atc_misses(cpu_profile_item_t *item) { return item->atc_misses; }
+
+/**
+ * Show CPU instructions which are executed most.
+ */
+void Profile_CpuShowCounts(int show)
+{
+	Profile_CpuShowList(show, cmp_count, value_count, cpu_profile.all.count, "count%");
+}
+
+/**
+ * Show CPU instructions which took most cycles.
+ */
+void Profile_CpuShowCycles(int show)
+{
+	Profile_CpuShowList(show, cmp_cycles, value_cycles, cpu_profile.all.cycles, "cycles%");
+}
+
+/**
+ * Show CPU instructions which had most instruction cache misses.
+ */
+void Profile_CpuShowMisses(int show)
+{
+	Profile_CpuShowList(show, cmp_i_misses, value_i_misses, cpu_profile.all.i_misses, "misses%");
+}
+
+/**
+ * Show CPU instructions which had most ATC misses.
+ */
+void Profile_CpuShowAtcMisses(int show)
+{
+	Profile_CpuShowList(show, cmp_atc_misses, value_atc_misses, cpu_profile.all.atc_misses, "atc%");
+}
+
+/**
+ * Add item profile data to given totals.
+ */
+static void Profile_CpuAddTotals(cpu_profile_totals_t *totals, cpu_profile_item_t *item)
+{
+	totals->count      += item->count;
+	totals->cycles     += item->cycles;
+	totals->i_misses   += item->i_misses;
+	totals->atc_misses += item->atc_misses;
+}
+
+/* qsort callback for sorting functions by used cycles */
+static int cmp_func_cycles(const void *p1, const void *p2)
+{
+	uint64_t v1 = ((const cpu_profile_func_t*)p1)->data.cycles;
+	uint64_t v2 = ((const cpu_profile_func_t*)p2)->data.cycles;
+	return (v1 < v2) - (v1 > v2);
+}
+
+/**
+ * Aggregate profile data per function (code symbol) and show
+ * the functions which took most cycles.
+ */
+void Profile_CpuShowSymbols(int show)
+{
+	cpu_profile_func_t *funcs = NULL, *func = NULL;
+	cpu_profile_totals_t unknown;
+	uint32_t i, addr, symaddr, count = 0, alloc = 0;
+	const char *name;
+
+	if (!Profile_CpuHasResults())
+		return;
+
+	memset(&unknown, 0, sizeof(unknown));
+
+	/* addresses are in ascending order, so each function's
+	 * addresses follow each other
+	 */
+	for (i = 0; i < cpu_profile.active; i++)
+	{
+		addr = symaddr = cpu_profile.sort_arr[i];
+		name = Symbols_GetBeforeCpuAddress(&symaddr);
+		if (!name)
+		{
+			Profile_CpuAddTotals(&unknown, Profile_CpuItem(addr));
+			continue;
+		}
+		if (!func || func->addr != symaddr)
+		{
+			if (count == alloc)
+			{
+				cpu_profile_func_t *tmp;
+				alloc += 256;
+				tmp = realloc(funcs, alloc * sizeof(cpu_profile_func_t));
+				if (!tmp)
+					break;
+				funcs = tmp;
+			}
+			func = &funcs[count++];
+			func->name = strdup(name);
+			func->addr = symaddr;
+			memset(&func->data, 0, sizeof(func->data));
+		}
+		Profile_CpuAddTotals(&func->data, Profile_CpuItem(addr));
+	}
+
+	if (!count)
+	{
+		fprintf(stderr, "No CPU code symbols matching profile data, load symbols first.\n");
+		free(funcs);
+		return;
+	}
+	qsort(funcs, count, sizeof(cpu_profile_func_t), cmp_func_cycles);
+
+	fprintf(debugOutput, "addr:\t\tcycles%%:\tcount:\t\tcycles:\t\ti-misses:\tatc-misses:\tfunction:\n");
+	for (i = 0; i < count; i++)
+	{
+		func = &funcs[i];
+		if (i < (uint32_t)show)
+		{
+			fprintf(debugOutput, "0x%08x\t%5.2f%%\t\t%-10"PRIu64"\t%-10"PRIu64"\t%-10"PRIu64"\t%-10"PRIu64"\t%s\n",
+			        func->addr,
+			        cpu_profile.all.cycles ? 100.0 * func->data.cycles / cpu_profile.all.cycles : 0.0,
+			        func->data.count, func->data.cycles,
+			        func->data.i_misses, func->data.atc_misses, func->name);
+		}
+		free(func->name);
+	}
+	fprintf(debugOutput, "%u of %u CPU functions listed, %5.2f%% of cycles outside known functions.\n",
+	        count < (uint32_t)show ? count : (uint32_t)show, count,
+	        cpu_profile.all.cycles ? 100.0 * unknown.cycles / cpu_profile.all.cycles : 0.0);
+	free(funcs);
+}
+
+/**
+ * Save all CPU profile data to given file in callgrind format.
+ * Return true on success.
+ */
+bool Profile_CpuSave(FILE *out)
+{
+	cpu_profile_item_t *item;
+	uint32_t i, addr, symaddr, funcaddr = 0;
+	const char *name;
+	bool known = false, first = true;
+
+	if (!Profile_CpuHasResults())
+		return false;
+
+	fprintf(out, "# callgrind format\n");
+	fprintf(out, "version: 1\n");
+	fprintf(out, "creator: " PROG_NAME "\n");
+	fprintf(out, "positions: instr\n");
+	fprintf(out, "events: Instructions Cycles I_Misses ATC_Misses\n");
+	fprintf(out, "summary: %"PRIu64" %"PRIu64" %"PRIu64" %"PRIu64"\n",
+	        cpu_profile.all.count, cpu_profile.all.cycles,
+	        cpu_profile.all.i_misses, cpu_profile.all.atc_misses);
+	fprintf(out, "ob=NeXT\n");
+
+	for (i = 0; i < cpu_profile.active; i++)
+	{
+		addr = symaddr = cpu_profile.sort_arr[i];
+		name = Symbols_GetBeforeCpuAddress(&symaddr);
+		if (first || (name ? (!known || symaddr != funcaddr) : known))
+		{
+			if (name)
+				fprintf(out, "fn=%s\n", name);
+			else
+				fprintf(out, "fn=0x%08x\n", addr);
+			known = (name != NULL);
+			funcaddr = symaddr;
+			first = false;
+		}
+		item = Profile_CpuItem(addr);
+		fprintf(out, "0x%08x %"PRIu64" %"PRIu64" %u %u\n", addr,
+		        item->count, item->cycles, item->i_misses, item->atc_misses);
+	}
+	return !ferror(out);
 }
 
+
 /* ------------------ CPU profile control ----------------- */
 
+/**
+ * Enable or disable CPU profiling, takes effect when emulation continues.
+ */
+void Profile_CpuEnable(bool enable)
+{
+	cpu_profile.enabled = enable;
+}
+
 /**
  * Free data from last profiling run, if any
  */
 void Profile_CpuFree(void)
 {
+	uint32_t i;
+
+	if (cpu_profile.pages)
+	{
+		for (i = 0; i < PROFILE_PAGE_COUNT; i++)
+			free(cpu_profile.pages[i]);
+		free(cpu_profile.pages);
+		cpu_profile.pages = NULL;
+	}
+	free(cpu_profile.sort_arr);
+	cpu_profile.sort_arr = NULL;
+	cpu_profile.active = 0;
+	cpu_profile.allocated = 0;
+	cpu_profile.processed = false;
 }
 
 /**
@@ -50,7 +416,37 @@ void Profile_CpuFree(void)
  */
 bool Profile_CpuStart(void)
 {
-	return false;
+	Profile_CpuFree();
+	if (!cpu_profile.enabled)
+		return false;
+
+	cpu_profile.pages = calloc(PROFILE_PAGE_COUNT, sizeof(cpu_profile_item_t*));
+	if (!cpu_profile.pages)
+	{
+		perror("ERROR, new CPU profile buffer alloc failed");
+		cpu_profile.enabled = false;
+		return false;
+	}
+	memset(&CpuInstruction, 0, sizeof(CpuInstruction));
+	cpu_profile.prev_cycles = nCyclesMainCounter;
+	cpu_profile.prev_pc = M68000_GetPC();
+	return true;
+}
+
+/**
+ * Allocate profile data page for given address.
+ */
+static cpu_profile_item_t *Profile_CpuAllocPage(uint32_t addr)
+{
+	cpu_profile_item_t *page;
+
+	page = calloc(PROFILE_PAGE_ITEMS, sizeof(cpu_profile_item_t));
+	if (page)
+	{
+		cpu_profile.pages[addr >> PROFILE_PAGE_SHIFT] = page;
+		cpu_profile.allocated++;
+	}
+	return page;
 }
 
 /**
@@ -61,6 +457,29 @@ bool Profile_CpuStart(void)
  */
 void Profile_CpuUpdate(void)
 {
+	cpu_profile_item_t *page, *item;
+	uint32_t prev_pc;
+
+	prev_pc = cpu_profile.prev_pc;
+	cpu_profile.prev_pc = M68000_GetPC();
+
+	page = cpu_profile.pages[prev_pc >> PROFILE_PAGE_SHIFT];
+	if (unlikely(!page))
+	{
+		page = Profile_CpuAllocPage(prev_pc);
+		if (!page)
+			return;
+	}
+	item = &page[(prev_pc & PROFILE_PAGE_MASK) >> 1];
+
+	item->count++;
+	item->cycles += nCyclesMainCounter - cpu_profile.prev_cycles;
+	cpu_profile.prev_cycles = nCyclesMainCounter;
+
+	item->i_misses += CpuInstruction.I_Cache_miss;
+	CpuInstruction.I_Cache_miss = 0;
+	item->atc_misses += CpuInstruction.ATC_miss;
+	CpuInstruction.ATC_miss = 0;
 }
 
 /**
@@ -69,4 +488,40 @@ void Profile_CpuUpdate(void)
  */
 void Profile_CpuStop(void)
 {
+	cpu_profile_item_t *page;
+	uint32_t i, j, alloc = 0;
+
+	if (!cpu_profile.pages || cpu_profile.processed)
+		return;
+
+	memset(&cpu_profile.all, 0, sizeof(cpu_profile.all));
+	cpu_profile.active = 0;
+
+	/* collect addresses with data, in ascending order */
+	for (i = 0; i < PROFILE_PAGE_COUNT; i++)
+	{
+		page = cpu_profile.pages[i];
+		if (!page)
+			continue;
+		for (j = 0; j < PROFILE_PAGE_ITEMS; j++)
+		{
+			if (!page[j].count)
+				continue;
+			if (cpu_profile.active == alloc)
+			{
+				uint32_t *tmp;
+				alloc += 4096;
+				tmp = realloc(cpu_profile.sort_arr, alloc * sizeof(uint32_t));
+				if (!tmp)
+				{
+					perror("ERROR, CPU profile sort array alloc failed");
+					return;
+				}
+				cpu_profile.sort_arr = tmp;
+			}
+			cpu_profile.sort_arr[cpu_profile.active++] = (i << PROFILE_PAGE_SHIFT) | (j << 1);
+			Profile_CpuAddTotals(&cpu_profile.all, &page[j]);
+		}
+	}
+	cpu_profile.processed = true;
 }
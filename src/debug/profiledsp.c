@@ -1,17 +1,69 @@
 /*
  * Hatari - profiledsp.c
- * 
+ *
  * Copyright (C) 2010-2019 by Eero Tamminen
  *
  * This file is distributed under the GNU General Public License, version 2
  * or at your option any later version. Read the file gpl.txt for details.
  *
  * profiledsp.c - functions for profiling DSP and showing the results.
+ *
+ * DSP program memory is only 64k words, so profile data is kept in
+ * a single flat array indexed by the P address.  Besides execution
+ * counts and cycles, DO and REP loop iterations are counted for
+ * the last instruction of a DO loop and for the REP'eated instruction.
  */
 const char Profiledsp_fileid[] = "Hatari profiledsp.c";
 
+#include <inttypes.h>
 #include "main.h"
+#include "dsp.h"
+#include "debug_priv.h"
+#include "symbols.h"
 #include "profile.h"
+#include "profile_priv.h"
+
+#define DSP_PROFILE_ARR_SIZE 0x10000
+
+#define DSP_LOOP_DO  1
+#define DSP_LOOP_REP 2
+
+typedef struct {
+	uint64_t count;           /* how many times this address instruction is executed */
+	uint64_t cycles;          /* how many DSP cycles was taken at this address */
+	uint64_t loop_iterations; /* how many loop iterations ended at this address */
+	uint32_t loop_exits;      /* how many times a loop ending at this address finished */
+	uint16_t min_cycle;
+	uint16_t max_cycle;
+	uint16_t loop_type;       /* DSP_LOOP_* flags */
+} dsp_profile_item_t;
+
+static struct {
+	dsp_profile_item_t *data; /* profile data, one item per P address */
+	uint16_t *sort_arr;       /* addresses with profile data */
+	uint32_t active;          /* number of addresses with profile data */
+	uint32_t loops;           /* number of addresses with loop data */
+	uint64_t all_count;       /* executed instructions */
+	uint64_t all_cycles;      /* used cycles */
+	uint64_t all_iterations;  /* loop iterations */
+	uint16_t prev_pc;         /* previous PC for which the cycles are for */
+	int prev_loop_end;        /* DO loop end before previous instruction, or -1 */
+	bool prev_rep;            /* REP active before previous instruction */
+	bool enabled;             /* true when profiling enabled */
+	bool processed;           /* true when data is processed for showing */
+} dsp_profile;
+
+
+/**
+ * Return true if there are processed results to show, false otherwise.
+ */
+static bool Profile_DspHasResults(void)
+{
+	if (dsp_profile.processed && dsp_profile.active)
+		return true;
+	fprintf(stderr, "No DSP profiling data available.\n");
+	return false;
+}
 
 
 /* ------------------ DSP profile results ----------------- */
@@ -23,17 +75,220 @@ const char Profiledsp_fileid[] = "Hatari profiledsp.c";
 bool Profile_DspAddressData(uint16_t addr, float *percentage, uint64_t *count,
                             uint64_t *cycles, uint16_t *cycle_diff)
 {
-	return false;
+	dsp_profile_item_t *item;
+
+	if (!dsp_profile.data)
+		return false;
+
+	item = &dsp_profile.data[addr];
+	if (!item->count)
+		return false;
+
+	*count = item->count;
+	*cycles = item->cycles;
+	*cycle_diff = item->max_cycle - item->min_cycle;
+	if (dsp_profile.all_count)
+		*percentage = 100.0 * item->count / dsp_profile.all_count;
+	else
+		*percentage = 0.0;
+	return true;
+}
+
+/**
+ * Show DSP profile statistics summary.
+ */
+void Profile_DspShowStats(void)
+{
+	if (!Profile_DspHasResults())
+		return;
+
+	fprintf(stderr, "DSP profile statistics:\n");
+	fprintf(stderr, "- active address range:\n  0x%04x-0x%04x\n",
+	        dsp_profile.sort_arr[0], dsp_profile.sort_arr[dsp_profile.active-1]);
+	fprintf(stderr, "- active instruction addresses:\n  %u\n", dsp_profile.active);
+	fprintf(stderr, "- executed instructions:\n  %"PRIu64"\n", dsp_profile.all_count);
+	fprintf(stderr, "- used cycles:\n  %"PRIu64"\n", dsp_profile.all_cycles);
+	fprintf(stderr, "- loop iterations:\n  %"PRIu64" (at %u addresses)\n",
+	        dsp_profile.all_iterations, dsp_profile.loops);
+}
+
+/* qsort callbacks for sorting addresses by their profile data */
+static int cmp_addr(const void *p1, const void *p2)
+{
+	uint16_t a1 = *(const uint16_t*)p1;
+	uint16_t a2 = *(const uint16_t*)p2;
+	return (a1 > a2) - (a1 < a2);
+}
+#define CMP_FIELD(field) \
+static int cmp_##field(const void *p1, const void *p2) \
+{ \
+	uint64_t v1 = dsp_profile.data[*(const uint16_t*)p1].field; \
+	uint64_t v2 = dsp_profile.data[*(const uint16_t*)p2].field; \
+	return (v1 < v2) - (v1 > v2); \
+}
+CMP_FIELD(count)
+CMP_FIELD(cycles)
+CMP_FIELD(loop_iterations)
+
+/**
+ * Sort addresses with given callback and show first ones with their
+ * profile data, percentage is for the sorted value.
+ */
+static void Profile_DspShowList(int show, int (*cmp)(const void*, const void*),
+                                bool by_count, uint64_t total, const char *what)
+{
+	dsp_profile_item_t *item;
+	const char *symbol;
+	uint32_t i;
+	uint16_t addr;
+
+	if (!Profile_DspHasResults())
+		return;
+
+	qsort(dsp_profile.sort_arr, dsp_profile.active, sizeof(uint16_t), cmp);
+
+	fprintf(debugOutput, "addr:\t%s:\tcount:\t\tcycles:\t\tcycle diff:\n", what);
+	for (i = 0; i < dsp_profile.active && i < (uint32_t)show; i++)
+	{
+		addr = dsp_profile.sort_arr[i];
+		item = &dsp_profile.data[addr];
+		fprintf(debugOutput, "0x%04x\t%5.2f%%\t\t%-10"PRIu64"\t%-10"PRIu64"\t%u",
+		        addr, total ? 100.0 * (by_count ? item->count : item->cycles) / total : 0.0,
+		        item->count, item->cycles, item->max_cycle - item->min_cycle);
+		symbol = Symbols_GetByDspAddress(addr, SYMTYPE_CODE);
+		if (symbol)
+			fprintf(debugOutput, "\t%s", symbol);
+		fputc('\n', debugOutput);
+	}
+	fprintf(debugOutput, "%u DSP addresses listed.\n", i);
+
+	/* restore address order */
+	qsort(dsp_profile.sort_arr, dsp_profile.active, sizeof(uint16_t), cmp_addr);
+}
+
+/**
+ * Show DSP instructions which are executed most.
+ */
+void Profile_DspShowCounts(int show)
+{
+	Profile_DspShowList(show, cmp_count, true, dsp_profile.all_count, "count%");
+}
+
+/**
+ * Show DSP instructions which took most cycles.
+ */
+void Profile_DspShowCycles(int show)
+{
+	Profile_DspShowList(show, cmp_cycles, false, dsp_profile.all_cycles, "cycles%");
+}
+
+/**
+ * Show DO and REP loops with most iterations.  DO loops are listed
+ * by their last instruction address, REP loops by the address of
+ * the repeated instruction.
+ */
+void Profile_DspShowLoops(int show)
+{
+	dsp_profile_item_t *item;
+	const char *symbol;
+	uint32_t i, shown = 0;
+	uint16_t addr;
+
+	if (!Profile_DspHasResults())
+		return;
+	if (!dsp_profile.loops)
+	{
+		fprintf(stderr, "No DSP loops executed.\n");
+		return;
+	}
+
+	qsort(dsp_profile.sort_arr, dsp_profile.active, sizeof(uint16_t), cmp_loop_iterations);
+
+	fprintf(debugOutput, "addr:\ttype:\titer%%:\t\titerations:\tloops:\t\tavg:\n");
+	for (i = 0; i < dsp_profile.active && shown < (uint32_t)show; i++)
+	{
+		addr = dsp_profile.sort_arr[i];
+		item = &dsp_profile.data[addr];
+		if (!item->loop_type)
+			break;
+		fprintf(debugOutput, "0x%04x\t%s\t%5.2f%%\t\t%-10"PRIu64"\t%-10u\t%.1f",
+		        addr, item->loop_type == DSP_LOOP_DO ? "DO" :
+		        (item->loop_type == DSP_LOOP_REP ? "REP" : "DO/REP"),
+		        dsp_profile.all_iterations ? 100.0 * item->loop_iterations / dsp_profile.all_iterations : 0.0,
+		        item->loop_iterations, item->loop_exits,
+		        item->loop_exits ? (double)item->loop_iterations / item->loop_exits : 0.0);
+		symbol = Symbols_GetByDspAddress(addr, SYMTYPE_CODE);
+		if (symbol)
+			fprintf(debugOutput, "\t%s", symbol);
+		fputc('\n', debugOutput);
+		shown++;
+	}
+	fprintf(debugOutput, "%u of %u DSP loop addresses listed.\n", shown, dsp_profile.loops);
+
+	/* restore address order */
+	qsort(dsp_profile.sort_arr, dsp_profile.active, sizeof(uint16_t), cmp_addr);
+}
+
+/**
+ * Save all DSP profile data to given file in callgrind format.
+ * Return true on success.
+ */
+bool Profile_DspSave(FILE *out)
+{
+	dsp_profile_item_t *item;
+	const char *name;
+	uint32_t i;
+	uint16_t addr;
+
+	if (!Profile_DspHasResults())
+		return false;
+
+	fprintf(out, "# callgrind format\n");
+	fprintf(out, "version: 1\n");
+	fprintf(out, "creator: " PROG_NAME "\n");
+	fprintf(out, "positions: instr\n");
+	fprintf(out, "events: Instructions Cycles\n");
+	fprintf(out, "summary: %"PRIu64" %"PRIu64"\n",
+	        dsp_profile.all_count, dsp_profile.all_cycles);
+	fprintf(out, "ob=DSP\n");
+
+	for (i = 0; i < dsp_profile.active; i++)
+	{
+		addr = dsp_profile.sort_arr[i];
+		name = Symbols_GetByDspAddress(addr, SYMTYPE_CODE);
+		if (name)
+			fprintf(out, "fn=%s\n", name);
+		else if (i == 0)
+			fprintf(out, "fn=0x%04x\n", addr);
+		item = &dsp_profile.data[addr];
+		fprintf(out, "0x%04x %"PRIu64" %"PRIu64"\n", addr, item->count, item->cycles);
+	}
+	return !ferror(out);
 }
 
 
 /* ------------------ DSP profile control ----------------- */
 
+/**
+ * Enable or disable DSP profiling, takes effect when emulation continues.
+ */
+void Profile_DspEnable(bool enable)
+{
+	dsp_profile.enabled = enable;
+}
+
 /**
  * Free data from last profiling run, if any
  */
 void Profile_DspFree(void)
 {
+	free(dsp_profile.data);
+	dsp_profile.data = NULL;
+	free(dsp_profile.sort_arr);
+	dsp_profile.sort_arr = NULL;
+	dsp_profile.active = 0;
+	dsp_profile.loops = 0;
+	dsp_profile.processed = false;
 }
 
 /**
@@ -41,7 +296,20 @@ void Profile_DspFree(void)
  */
 bool Profile_DspStart(void)
 {
-	return false;
+	Profile_DspFree();
+	if (!dsp_profile.enabled)
+		return false;
+
+	dsp_profile.data = calloc(DSP_PROFILE_ARR_SIZE, sizeof(dsp_profile_item_t));
+	if (!dsp_profile.data)
+	{
+		perror("ERROR, new DSP profile buffer alloc failed");
+		dsp_profile.enabled = false;
+		return false;
+	}
+	dsp_profile.prev_pc = DSP_GetPC();
+	dsp_profile.prev_loop_end = DSP_GetLoopState(&dsp_profile.prev_rep);
+	return true;
 }
 
 /**
@@ -52,6 +320,45 @@ bool Profile_DspStart(void)
  */
 void Profile_DspUpdate(void)
 {
+	dsp_profile_item_t *item;
+	uint16_t prev_pc, pc, cycles;
+	int loop_end;
+	bool rep;
+
+	prev_pc = dsp_profile.prev_pc;
+	pc = dsp_profile.prev_pc = DSP_GetPC();
+
+	item = &dsp_profile.data[prev_pc];
+	cycles = DSP_GetInstrCycles();
+	if (unlikely(!item->count))
+		item->min_cycle = item->max_cycle = cycles;
+	else if (cycles < item->min_cycle)
+		item->min_cycle = cycles;
+	else if (cycles > item->max_cycle)
+		item->max_cycle = cycles;
+	item->count++;
+	item->cycles += cycles;
+
+	loop_end = DSP_GetLoopState(&rep);
+
+	/* repeated instruction was executed: REP continues or ends */
+	if (dsp_profile.prev_rep)
+	{
+		item->loop_type |= DSP_LOOP_REP;
+		item->loop_iterations++;
+		if (!rep)
+			item->loop_exits++;
+	}
+	/* last DO loop instruction was executed: jump back or loop end */
+	else if (dsp_profile.prev_loop_end == prev_pc)
+	{
+		item->loop_type |= DSP_LOOP_DO;
+		item->loop_iterations++;
+		if (pc == (uint16_t)(prev_pc + 1))
+			item->loop_exits++;
+	}
+	dsp_profile.prev_loop_end = loop_end;
+	dsp_profile.prev_rep = rep;
 }
 
 /**
@@ -60,4 +367,47 @@ void Profile_DspUpdate(void)
  */
 void Profile_DspStop(void)
 {
+	dsp_profile_item_t *item;
+	uint32_t addr;
+
+	if (!dsp_profile.data || dsp_profile.processed)
+		return;
+
+	dsp_profile.all_count = dsp_profile.all_cycles = dsp_profile.all_iterations = 0;
+	dsp_profile.active = dsp_profile.loops = 0;
+
+	for (addr = 0; addr < DSP_PROFILE_ARR_SIZE; addr++)
+	{
+		item = &dsp_profile.data[addr];
+		if (!item->count)
+			continue;
+		dsp_profile.active++;
+		dsp_profile.all_count += item->count;
+		dsp_profile.all_cycles += item->cycles;
+		if (item->loop_type)
+		{
+			dsp_profile.loops++;
+			dsp_profile.all_iterations += item->loop_iterations;
+		}
+	}
+	if (!dsp_profile.active)
+	{
+		dsp_profile.processed = true;
+		return;
+	}
+
+	dsp_profile.sort_arr = malloc(dsp_profile.active * sizeof(uint16_t));
+	if (!dsp_profile.sort_arr)
+	{
+		perror("ERROR, DSP profile sort array alloc failed");
+		dsp_profile.active = 0;
+		return;
+	}
+	dsp_profile.active = 0;
+	for (addr = 0; addr < DSP_PROFILE_ARR_SIZE; addr++)
+	{
+		if (dsp_profile.data[addr].count)
+			dsp_profile.sort_arr[dsp_profile.active++] = addr;
+	}
+	dsp_profile.processed = true;
 }
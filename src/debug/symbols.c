@@ -1,33 +1,590 @@
 /*
  * Hatari - symbols.c
- * 
+ *
  * Copyright (C) 2010-2026 by Eero Tamminen
- * 
+ *
  * This file is distributed under the GNU General Public License, version 2
  * or at your option any later version. Read the file gpl.txt for details.
- * 
+ *
  * symbols.c - Hatari debugger symbol/address handling; parsing, sorting,
  * matching, TAB completion support etc.
- * 
+ *
  * Symbol/address information is read either from:
- * - A program file's symbol table (in DRI/GST, a.out, or ELF format), or
+ * - A program file's symbol table (in Mach-O or a.out format), or
  * - ASCII file which contents are subset of "nm" output i.e. composed of
  *   a hexadecimal addresses followed by a space, letter indicating symbol
  *   type (T = text/code, D = data, B = BSS), space and the symbol name.
  *   Empty lines and lines starting with '#' are ignored.  It's AHCC SYM
  *   output compatible.
+ *
+ * Loaded file is kept in memory and symbol names point to its string
+ * table, so loading needs no per-symbol allocations.  Symbols are
+ * sorted by address, with separate compact address arrays for binary
+ * searches, and names are looked up through a hash table.
  */
 const char Symbols_fileid[] = "Hatari symbols.c";
 
+#include <ctype.h>
+#include <limits.h>
+#include "config.h"
 #include "main.h"
-#include "symbols.h"
+#include "file.h"
+#include "str.h"
+#include "debug_priv.h"
 #include "debugui.h"
+#include "evaluate.h"
+#include "symbols.h"
+
+#if HAVE_LIBREADLINE
+#include <readline/readline.h>
+#endif
+
+/* Mach-O definitions */
+#define MH_MAGIC       0xfeedface
+#define MH_CIGAM       0xcefaedfe
+#define FAT_MAGIC      0xcafebabe
+#define CPU_TYPE_MC680x0 6
+#define LC_SEGMENT     0x1
+#define LC_SYMTAB      0x2
+#define MACHO_HDR_SIZE 28
+#define MACHO_SEG_SIZE 56
+#define MACHO_SECT_SIZE 68
+#define N_STAB         0xe0
+#define N_TYPE_MACHO   0x0e
+#define N_ABS_MACHO    0x02
+#define N_SECT         0x0e
+
+/* a.out definitions */
+#define OMAGIC         0407
+#define NMAGIC         0410
+#define ZMAGIC         0413
+#define AOUT_HDR_SIZE  32
+#define N_TYPE_AOUT    0x1e
+#define N_ABS          0x02
+#define N_TEXT         0x04
+#define N_DATA         0x06
+#define N_BSS          0x08
+
+#define NLIST_SIZE     12
+
+typedef struct {
+	char *filename;        /* file from which symbols were loaded */
+	uint8_t *buffer;       /* file contents, names point into this */
+	symbol_t *symbols;     /* symbols sorted by address (and type) */
+	uint32_t *addresses;   /* symbol addresses in same order */
+	uint32_t *codes;       /* code symbol indexes in address order */
+	uint32_t *code_addresses;
+	uint32_t *hash;        /* name hash table, symbol index + 1 or 0 */
+	uint32_t hashmask;
+	int count;             /* number of symbols */
+	int allocated;         /* number of allocated symbol slots */
+	int codecount;         /* number of code symbols */
+} symbol_list_t;
+
+static symbol_list_t *CpuSymbolsList;
+static symbol_list_t *DspSymbolsList;
+
+
+/* ------------------ load and free functions ------------------ */
+
+static inline uint32_t get_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+/**
+ * Free given symbol list.
+ */
+static void Symbols_Free(symbol_list_t *list)
+{
+	if (!list)
+		return;
+	free(list->filename);
+	free(list->buffer);
+	free(list->symbols);
+	free(list->addresses);
+	free(list->codes);
+	free(list->code_addresses);
+	free(list->hash);
+	free(list);
+}
+
+/**
+ * Add symbol to the list.  Return false if allocation fails.
+ */
+static bool Symbols_Add(symbol_list_t *list, char *name, uint32_t addr, symtype_t type)
+{
+	symbol_t *sym;
+
+	if (list->count == list->allocated)
+	{
+		symbol_t *tmp;
+		int alloc = list->allocated ? 2 * list->allocated : 1024;
+		tmp = realloc(list->symbols, alloc * sizeof(symbol_t));
+		if (!tmp)
+			return false;
+		list->symbols = tmp;
+		list->allocated = alloc;
+	}
+	sym = &list->symbols[list->count++];
+	sym->name = name;
+	sym->address = addr;
+	sym->type = type;
+	sym->name_allocated = false;
+	return true;
+}
+
+/**
+ * Return true if symbol name is just an object file name.
+ */
+static bool Symbols_IsFileName(const char *name)
+{
+	size_t len = strlen(name);
+	return len > 2 && name[len-2] == '.' && name[len-1] == 'o';
+}
+
+/**
+ * Parse symbols from Mach-O binary.  Return number of symbols or -1 on error.
+ */
+static int Symbols_ParseMachO(symbol_list_t *list, uint8_t *buf, uint32_t size, uint32_t offset)
+{
+	symtype_t sect_types[256];
+	uint32_t ncmds, cmd, cmdsize, pos, nsects, i, nsect = 0;
+	uint32_t symoff = 0, nsyms = 0, stroff = 0, strsize = 0;
+	uint8_t *nl, *sect;
+	symtype_t type;
+	uint8_t ntype;
+	uint32_t strx, addr;
+
+	if (size < MACHO_HDR_SIZE)
+		return -1;
+	if (get_be32(buf + 4) != CPU_TYPE_MC680x0)
+		fprintf(stderr, "WARNING: Mach-O binary is not for m68k CPU.\n");
+
+	for (i = 0; i < ARRAY_SIZE(sect_types); i++)
+		sect_types[i] = SYMTYPE_DATA;
+
+	ncmds = get_be32(buf + 16);
+	pos = MACHO_HDR_SIZE;
+	while (ncmds--)
+	{
+		if (pos + 8 > size)
+			return -1;
+		cmd = get_be32(buf + pos);
+		cmdsize = get_be32(buf + pos + 4);
+		if (cmdsize < 8 || cmdsize > size - pos)
+			return -1;
+
+		if (cmd == LC_SEGMENT && cmdsize >= MACHO_SEG_SIZE)
+		{
+			/* section numbers used by symbols are 1-based
+			 * and run over all segments
+			 */
+			nsects = get_be32(buf + pos + 48);
+			sect = buf + pos + MACHO_SEG_SIZE;
+			for (i = 0; i < nsects && MACHO_SEG_SIZE + (i+1) * MACHO_SECT_SIZE <= cmdsize; i++)
+			{
+				if (++nsect >= ARRAY_SIZE(sect_types))
+					break;
+				if (strncmp((char *)sect + 16, "__TEXT", 16) == 0)
+					type = SYMTYPE_TEXT;
+				else if (strncmp((char *)sect, "__bss", 16) == 0 ||
+				         strncmp((char *)sect, "__common", 16) == 0)
+					type = SYMTYPE_BSS;
+				else
+					type = SYMTYPE_DATA;
+				sect_types[nsect] = type;
+				sect += MACHO_SECT_SIZE;
+			}
+		}
+		else if (cmd == LC_SYMTAB && cmdsize >= 24)
+		{
+			symoff = get_be32(buf + pos + 8);
+			nsyms = get_be32(buf + pos + 12);
+			stroff = get_be32(buf + pos + 16);
+			strsize = get_be32(buf + pos + 20);
+		}
+		pos += cmdsize;
+	}
+
+	if (!nsyms || !strsize || symoff > size || nsyms > (size - symoff) / NLIST_SIZE ||
+	    stroff > size || strsize > size - stroff)
+	{
+		fprintf(stderr, "ERROR: no valid symbol table in Mach-O binary!\n");
+		return 0;
+	}
+	/* make sure all names are terminated */
+	buf[stroff + strsize - 1] = '\0';
+
+	for (nl = buf + symoff; nsyms--; nl += NLIST_SIZE)
+	{
+		strx = get_be32(nl);
+		ntype = nl[4];
+		addr = get_be32(nl + 8);
+		if ((ntype & N_STAB) || !strx || strx >= strsize || !buf[stroff + strx])
+			continue;
+		switch (ntype & N_TYPE_MACHO)
+		{
+		case N_SECT:
+			type = sect_types[nl[5]];
+			addr += offset;
+			break;
+		case N_ABS_MACHO:
+			type = SYMTYPE_ABS;
+			break;
+		default:
+			/* undefined and indirect symbols */
+			continue;
+		}
+		if (!Symbols_Add(list, (char *)buf + stroff + strx, addr, type))
+			return -1;
+	}
+	return list->count;
+}
+
+/**
+ * Parse symbols from multi-architecture Mach-O binary, using
+ * the m68k one.  Return number of symbols or -1 on error.
+ */
+static int Symbols_ParseFatMachO(symbol_list_t *list, uint8_t *buf, uint32_t size, uint32_t offset)
+{
+	uint32_t narchs, archoff, archsize, i;
+	uint8_t *arch;
+
+	if (size < 8)
+		return -1;
+	narchs = get_be32(buf + 4);
+	for (i = 0, arch = buf + 8; i < narchs && arch + 20 <= buf + size; i++, arch += 20)
+	{
+		if (get_be32(arch) != CPU_TYPE_MC680x0)
+			continue;
+		archoff = get_be32(arch + 8);
+		archsize = get_be32(arch + 12);
+		if (archoff > size || archsize > size - archoff || archsize < 4 ||
+		    get_be32(buf + archoff) != MH_MAGIC)
+			return -1;
+		return Symbols_ParseMachO(list, buf + archoff, archsize, offset);
+	}
+	fprintf(stderr, "ERROR: no m68k binary in multi-architecture file!\n");
+	return 0;
+}
+
+/**
+ * Parse symbols from a.out binary.  Return number of symbols or -1 on error.
+ */
+static int Symbols_ParseAout(symbol_list_t *list, uint8_t *buf, uint32_t size, uint32_t offset)
+{
+	uint32_t magic, symoff, nsyms, stroff, strsize, strx, addr;
+	uint64_t pos;
+	symtype_t type;
+	uint8_t *nl;
+	char *name;
+
+	magic = get_be32(buf) & 0xffff;
+	pos = (magic == ZMAGIC) ? 0 : AOUT_HDR_SIZE;
+	pos += (uint64_t)get_be32(buf + 4) + get_be32(buf + 8);     /* text + data */
+	pos += (uint64_t)get_be32(buf + 24) + get_be32(buf + 28);   /* relocations */
+	nsyms = get_be32(buf + 16) / NLIST_SIZE;
+	if (pos > size || nsyms > (size - pos) / NLIST_SIZE)
+		return -1;
+	symoff = pos;
+	stroff = symoff + nsyms * NLIST_SIZE;
+	if (!nsyms || stroff + 4 > size)
+	{
+		fprintf(stderr, "ERROR: no symbol table in a.out binary!\n");
+		return 0;
+	}
+	strsize = get_be32(buf + stroff);
+	if (strsize < 4 || strsize > size - stroff)
+		return -1;
+	buf[stroff + strsize - 1] = '\0';
+
+	for (nl = buf + symoff; nsyms--; nl += NLIST_SIZE)
+	{
+		strx = get_be32(nl);
+		addr = get_be32(nl + 8);
+		if ((nl[4] & N_STAB) || strx < 4 || strx >= strsize)
+			continue;
+		switch (nl[4] & N_TYPE_AOUT)
+		{
+		case N_TEXT:
+			type = SYMTYPE_TEXT;
+			break;
+		case N_DATA:
+			type = SYMTYPE_DATA;
+			break;
+		case N_BSS:
+			type = SYMTYPE_BSS;
+			break;
+		case N_ABS:
+			type = SYMTYPE_ABS;
+			break;
+		default:
+			/* undefined symbols and file names */
+			continue;
+		}
+		name = (char *)buf + stroff + strx;
+		if (!*name || (type == SYMTYPE_TEXT && Symbols_IsFileName(name)))
+			continue;
+		if (type != SYMTYPE_ABS)
+			addr += offset;
+		if (!Symbols_Add(list, name, addr, type))
+			return -1;
+	}
+	return list->count;
+}
+
+/**
+ * Parse symbols from ASCII "nm" output.  Buffer must be
+ * NUL terminated.  Return number of symbols or -1 on error.
+ */
+static int Symbols_ParseAscii(symbol_list_t *list, char *buf, uint32_t offset)
+{
+	char *line, *next, *end, *name;
+	symtype_t type;
+	uint32_t addr;
+	int lineno = 0;
+
+	for (line = buf; line && *line; line = next)
+	{
+		lineno++;
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		line = Str_Trim(line);
+		if (!*line || *line == '#')
+			continue;
+
+		addr = strtoul(line, &end, 16);
+		if (end == line || !isspace((unsigned char)*end))
+		{
+			fprintf(stderr, "WARNING: syntax error in line %d, skipping.\n", lineno);
+			continue;
+		}
+		while (isspace((unsigned char)*end))
+			end++;
+		switch (toupper((unsigned char)*end))
+		{
+		case 'T':
+			type = SYMTYPE_TEXT;
+			break;
+		case 'W':
+			type = SYMTYPE_WEAK;
+			break;
+		case 'D':
+		case 'R':
+			type = SYMTYPE_DATA;
+			break;
+		case 'B':
+			type = SYMTYPE_BSS;
+			break;
+		case 'A':
+			type = SYMTYPE_ABS;
+			break;
+		default:
+			fprintf(stderr, "WARNING: unrecognized symbol type in line %d, skipping.\n", lineno);
+			continue;
+		}
+		name = end + 1;
+		while (isspace((unsigned char)*name))
+			name++;
+		if (!*name)
+		{
+			fprintf(stderr, "WARNING: symbol name missing in line %d, skipping.\n", lineno);
+			continue;
+		}
+		if (type != SYMTYPE_ABS)
+			addr += offset;
+		if (!Symbols_Add(list, name, addr, type))
+			return -1;
+	}
+	return list->count;
+}
+
+/* qsort callback for sorting symbols by address, code symbols first */
+static int symbols_by_address(const void *s1, const void *s2)
+{
+	const symbol_t *sym1 = (const symbol_t*)s1;
+	const symbol_t *sym2 = (const symbol_t*)s2;
+
+	if (sym1->address != sym2->address)
+		return (sym1->address > sym2->address) - (sym1->address < sym2->address);
+	if (sym1->type != sym2->type)
+		return (int)sym1->type - (int)sym2->type;
+	return strcmp(sym1->name, sym2->name);
+}
+
+/**
+ * Symbol name hash (FNV-1a).
+ */
+static uint32_t Symbols_Hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+	while (*name)
+	{
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+/**
+ * Sort symbols, remove duplicates and create address and name
+ * search indexes.  Return false if allocations fail.
+ */
+static bool Symbols_BuildIndexes(symbol_list_t *list)
+{
+	uint32_t size, slot;
+	int i, j;
+
+	qsort(list->symbols, list->count, sizeof(symbol_t), symbols_by_address);
+
+	/* remove duplicate entries */
+	for (i = j = 1; i < list->count; i++)
+	{
+		if (list->symbols[i].address == list->symbols[j-1].address &&
+		    list->symbols[i].type == list->symbols[j-1].type &&
+		    strcmp(list->symbols[i].name, list->symbols[j-1].name) == 0)
+			continue;
+		list->symbols[j++] = list->symbols[i];
+	}
+	if (list->count)
+		list->count = j;
+
+	for (size = 16; size < 2 * (uint32_t)list->count; size <<= 1)
+		;
+	list->addresses = malloc(list->count * sizeof(uint32_t));
+	list->codes = malloc(list->count * sizeof(uint32_t));
+	list->code_addresses = malloc(list->count * sizeof(uint32_t));
+	list->hash = calloc(size, sizeof(uint32_t));
+	if (!(list->addresses && list->codes && list->code_addresses && list->hash))
+		return false;
+	list->hashmask = size - 1;
+
+	list->codecount = 0;
+	for (i = 0; i < list->count; i++)
+	{
+		list->addresses[i] = list->symbols[i].address;
+		if (list->symbols[i].type & SYMTYPE_CODE)
+		{
+			list->codes[list->codecount] = i;
+			list->code_addresses[list->codecount++] = list->symbols[i].address;
+		}
+		/* linear probing, first symbol with given name comes first */
+		slot = Symbols_Hash(list->symbols[i].name) & list->hashmask;
+		while (list->hash[slot])
+			slot = (slot + 1) & list->hashmask;
+		list->hash[slot] = i + 1;
+	}
+	return true;
+}
+
+/**
+ * Load symbols from given file and add given offset to their
+ * addresses.  DSP symbols can be loaded only from ASCII files.
+ * Return symbols list or NULL for failure.
+ */
+static symbol_list_t *Symbols_Load(const char *filename, uint32_t offset, bool for_dsp)
+{
+	symbol_list_t *list;
+	uint8_t *buf;
+	long size;
+	uint32_t magic;
+	int count;
+
+	buf = File_ReadAsIs(filename, &size);
+	if (!buf)
+	{
+		fprintf(stderr, "ERROR: reading symbols file '%s' failed!\n", filename);
+		return NULL;
+	}
+	list = calloc(1, sizeof(symbol_list_t));
+	if (!list)
+	{
+		free(buf);
+		return NULL;
+	}
+	list->buffer = buf;
+	list->filename = strdup(filename);
+
+	magic = size >= 4 ? get_be32(buf) : 0;
+	if (!for_dsp && magic == MH_MAGIC)
+		count = Symbols_ParseMachO(list, buf, size, offset);
+	else if (!for_dsp && magic == FAT_MAGIC)
+		count = Symbols_ParseFatMachO(list, buf, size, offset);
+	else if (magic == MH_CIGAM)
+	{
+		fprintf(stderr, "ERROR: little endian Mach-O binary, not for m68k!\n");
+		count = 0;
+	}
+	else if (!for_dsp && size >= AOUT_HDR_SIZE &&
+	         ((magic & 0xffff) == OMAGIC || (magic & 0xffff) == NMAGIC ||
+	          (magic & 0xffff) == ZMAGIC))
+		count = Symbols_ParseAout(list, buf, size, offset);
+	else
+	{
+		/* names are terminated in place */
+		buf = realloc(list->buffer, size + 1);
+		if (buf)
+		{
+			buf[size] = '\0';
+			list->buffer = buf;
+			count = Symbols_ParseAscii(list, (char *)buf, offset);
+		}
+		else
+			count = -1;
+	}
+
+	if (count < 0)
+		fprintf(stderr, "ERROR: invalid or truncated symbol data in '%s'!\n", filename);
+	if (count <= 0 || !Symbols_BuildIndexes(list))
+	{
+		Symbols_Free(list);
+		return NULL;
+	}
+	return list;
+}
 
 /**
  * Free all symbols (at exit).
  */
 void Symbols_FreeAll(void)
 {
+	Symbols_Free(CpuSymbolsList);
+	CpuSymbolsList = NULL;
+	Symbols_Free(DspSymbolsList);
+	DspSymbolsList = NULL;
+}
+
+
+/* ---------------- symbol name completion support ------------------ */
+
+/**
+ * Helper for symbol name completion: list symbols of given type
+ * which name starts with given text.
+ */
+static char* Symbols_MatchByName(symbol_list_t *list, symtype_t symtype, const char *text, int state)
+{
+	static int i, len;
+	const symbol_t *entry;
+
+	if (!list)
+		return NULL;
+
+	if (!state)
+	{
+		/* first match */
+		len = strlen(text);
+		i = 0;
+	}
+	/* next match */
+	while (i < list->count)
+	{
+		entry = &list->symbols[i++];
+		if ((entry->type & symtype) && strncmp(entry->name, text, len) == 0)
+			return strdup(entry->name);
+	}
+	return NULL;
 }
 
 /**
@@ -37,15 +594,15 @@ void Symbols_FreeAll(void)
  */
 char* Symbols_MatchCpuAddress(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchByName(CpuSymbolsList, SYMTYPE_ALL, text, state);
 }
 char* Symbols_MatchCpuCodeAddress(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchByName(CpuSymbolsList, SYMTYPE_CODE, text, state);
 }
 char* Symbols_MatchCpuDataAddress(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchByName(CpuSymbolsList, SYMTYPE_DATA|SYMTYPE_BSS, text, state);
 }
 
 /**
@@ -55,7 +612,24 @@ char* Symbols_MatchCpuDataAddress(const char *text, int state)
  */
 char *Symbols_MatchCpuAddrFile(const char *text, int state)
 {
-	return NULL;
+#if HAVE_LIBREADLINE
+	static bool files;
+	char *match;
+
+	if (!state)
+		files = false;
+	if (!files)
+	{
+		match = Symbols_MatchCpuAddress(text, state);
+		if (match)
+			return match;
+		files = true;
+		state = 0;
+	}
+	return rl_filename_completion_function(text, state);
+#else
+	return Symbols_MatchCpuAddress(text, state);
+#endif
 }
 
 /**
@@ -65,15 +639,44 @@ char *Symbols_MatchCpuAddrFile(const char *text, int state)
  */
 char* Symbols_MatchDspAddress(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchByName(DspSymbolsList, SYMTYPE_ALL, text, state);
 }
 char* Symbols_MatchDspCodeAddress(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchByName(DspSymbolsList, SYMTYPE_CODE, text, state);
 }
 char* Symbols_MatchDspDataAddress(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchByName(DspSymbolsList, SYMTYPE_DATA|SYMTYPE_BSS, text, state);
+}
+
+
+/* ---------------- symbol name -> address search ------------------ */
+
+/**
+ * Search symbol of given type by name from given list.
+ * Return true and set its address if found.
+ */
+static bool Symbols_SearchByName(symbol_list_t *list, symtype_t symtype, const char *name, uint32_t *addr)
+{
+	const symbol_t *entry;
+	uint32_t slot, idx;
+
+	if (!list)
+		return false;
+
+	slot = Symbols_Hash(name) & list->hashmask;
+	while ((idx = list->hash[slot]))
+	{
+		entry = &list->symbols[idx - 1];
+		if ((entry->type & symtype) && strcmp(entry->name, name) == 0)
+		{
+			*addr = entry->address;
+			return true;
+		}
+		slot = (slot + 1) & list->hashmask;
+	}
+	return false;
 }
 
 /**
@@ -82,11 +685,16 @@ char* Symbols_MatchDspDataAddress(const char *text, int state)
  */
 bool Symbols_GetCpuAddress(symtype_t symtype, const char *name, uint32_t *addr)
 {
-	return false;
+	return Symbols_SearchByName(CpuSymbolsList, symtype, name, addr);
 }
 bool Symbols_GetDspAddress(symtype_t symtype, const char *name, uint32_t *addr)
 {
-	return false;
+	return Symbols_SearchByName(DspSymbolsList, symtype, name, addr);
+}
+
+static inline bool is_symbol_char(char c)
+{
+	return isalnum((unsigned char)c) || c == '_';
 }
 
 /**
@@ -100,7 +708,78 @@ bool Symbols_GetDspAddress(symtype_t symtype, const char *name, uint32_t *addr)
  */
 bool Symbols_GetCpuMethodAddress(symtype_t symtype, const char *sub, uint32_t *addr)
 {
-	return false;
+	const symbol_t *entry, *found = NULL;
+	const char *name, *match;
+	size_t len;
+	int i;
+
+	if (!CpuSymbolsList || !*sub)
+		return false;
+
+	len = strlen(sub);
+	for (i = 0; i < CpuSymbolsList->count; i++)
+	{
+		entry = &CpuSymbolsList->symbols[i];
+		if (!(entry->type & symtype))
+			continue;
+		name = entry->name;
+		for (match = strstr(name, sub); match; match = strstr(match + 1, sub))
+		{
+			if ((match == name || !is_symbol_char(match[-1])) &&
+			    !is_symbol_char(match[len]))
+				break;
+		}
+		if (!match)
+			continue;
+		if (found)
+			return false;
+		found = entry;
+	}
+	if (!found)
+		return false;
+	*addr = found->address;
+	return true;
+}
+
+
+/* ---------------- symbol address -> name search ------------------ */
+
+/**
+ * Return index of first item in sorted array which is >= addr
+ */
+static int Symbols_LowerBound(const uint32_t *addresses, int count, uint32_t addr)
+{
+	int lo = 0, hi = count, mid;
+
+	while (lo < hi)
+	{
+		mid = (lo + hi) / 2;
+		if (addresses[mid] < addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * Search symbol in given list by type & address.
+ * Return symbol name if there's a match, NULL otherwise.
+ */
+static const char* Symbols_SearchByAddress(symbol_list_t *list, uint32_t addr, symtype_t type)
+{
+	int i;
+
+	if (!list)
+		return NULL;
+
+	for (i = Symbols_LowerBound(list->addresses, list->count, addr);
+	     i < list->count && list->addresses[i] == addr; i++)
+	{
+		if (list->symbols[i].type & type)
+			return list->symbols[i].name;
+	}
+	return NULL;
 }
 
 /**
@@ -111,18 +790,39 @@ bool Symbols_GetCpuMethodAddress(symtype_t symtype, const char *sub, uint32_t *a
  */
 const char* Symbols_GetByCpuAddress(uint32_t addr, symtype_t type)
 {
-	return NULL;
+	return Symbols_SearchByAddress(CpuSymbolsList, addr, type);
 }
 const char* Symbols_GetByDspAddress(uint32_t addr, symtype_t type)
 {
-	return NULL;
+	return Symbols_SearchByAddress(DspSymbolsList, addr, type);
+}
+
+/**
+ * Search code symbol preceding given address.
+ * Return symbol name and set address to its start if found, NULL otherwise.
+ * Returned name is valid only until next Symbols_* function call.
+ */
+const char* Symbols_GetBeforeCpuAddress(uint32_t *addr)
+{
+	symbol_list_t *list = CpuSymbolsList;
+	int i;
+
+	if (!list || !list->codecount || *addr == UINT32_MAX)
+		return NULL;
+
+	/* last code symbol at or before the address */
+	i = Symbols_LowerBound(list->code_addresses, list->codecount, *addr + 1) - 1;
+	if (i < 0)
+		return NULL;
+	*addr = list->code_addresses[i];
+	return list->symbols[list->codes[i]].name;
 }
 
 /**
  * Load symbols for last opened program when symbol autoloading is enabled.
  *
- * Called when debugger is invoked and by GEMDOS HD when "exec" symload
- * is requested.
+ * Previous doesn't load programs itself, so there's nothing to
+ * autoload; symbols are loaded with the 'symbols' command.
  */
 void Symbols_AutoLoadCurrentProgram(const uint32_t *offsets, uint32_t maxaddr)
 {
@@ -137,7 +837,27 @@ void Symbols_AutoLoadCurrentProgram(const uint32_t *offsets, uint32_t maxaddr)
  */
 char *Symbols_MatchCpuCommand(const char *text, int state)
 {
-	return NULL;
+	static const char *subs[] = {
+		"code", "data", "free", "name", "stats"
+	};
+#if HAVE_LIBREADLINE
+	static bool files;
+	char *match;
+
+	if (!state)
+		files = false;
+	if (!files)
+	{
+		match = DebugUI_MatchHelper(subs, ARRAY_SIZE(subs), text, state);
+		if (match)
+			return match;
+		files = true;
+		state = 0;
+	}
+	return rl_filename_completion_function(text, state);
+#else
+	return DebugUI_MatchHelper(subs, ARRAY_SIZE(subs), text, state);
+#endif
 }
 
 /**
@@ -147,16 +867,156 @@ char *Symbols_MatchCpuCommand(const char *text, int state)
  */
 char *Symbols_MatchDspCommand(const char *text, int state)
 {
-	return NULL;
+	return Symbols_MatchCpuCommand(text, state);
 }
 
 const char Symbols_Description[] =
-	"<symbols command is not supported on Previous>";
+	"<code|data|name|stats|free> [count] | <filename> [offset]\n"
+	"\tLoads symbol names and their addresses from the given file,\n"
+	"\treplacing earlier loaded symbols.  CPU symbols can be loaded\n"
+	"\tfrom Mach-O (also multi-architecture) and a.out binaries, e.g.\n"
+	"\tthe NeXTSTEP kernel or applications.  DSP and CPU symbols can\n"
+	"\tbe loaded from ASCII files with 'nm' style lines of hexadecimal\n"
+	"\taddress, type letter (T/D/B/A) and symbol name.  Optional\n"
+	"\toffset is added to the loaded non-absolute symbol addresses.\n"
+	"\n"
+	"\t'code' and 'data' list the loaded code and data symbols sorted\n"
+	"\tby address, 'name' lists all of them sorted by name.  Optional\n"
+	"\tcount limits the number of listed symbols.  'stats' shows symbol\n"
+	"\tcounts and 'free' removes the loaded symbols.";
+
+/* qsort callback for sorting symbols by name */
+static int symbols_by_name(const void *s1, const void *s2)
+{
+	return strcmp((*(const symbol_t* const*)s1)->name,
+	              (*(const symbol_t* const*)s2)->name);
+}
+
+/**
+ * List symbols of given type, sorted by name or by address.
+ */
+static void Symbols_Show(symbol_list_t *list, symtype_t symtype, bool by_name, int show)
+{
+	const symbol_t **entries;
+	const char *typestr;
+	int i, count = 0;
+
+	if (!list)
+	{
+		fprintf(stderr, "No symbols loaded.\n");
+		return;
+	}
+	entries = malloc(list->count * sizeof(symbol_t*));
+	if (!entries)
+		return;
+	for (i = 0; i < list->count; i++)
+	{
+		if (list->symbols[i].type & symtype)
+			entries[count++] = &list->symbols[i];
+	}
+	if (by_name)
+		qsort(entries, count, sizeof(symbol_t*), symbols_by_name);
+
+	for (i = 0; i < count && i < show; i++)
+	{
+		switch (entries[i]->type)
+		{
+		case SYMTYPE_TEXT: typestr = "T"; break;
+		case SYMTYPE_WEAK: typestr = "W"; break;
+		case SYMTYPE_DATA: typestr = "D"; break;
+		case SYMTYPE_BSS:  typestr = "B"; break;
+		default:           typestr = "A"; break;
+		}
+		fprintf(debugOutput, "0x%08x %s %s\n", entries[i]->address, typestr, entries[i]->name);
+	}
+	fprintf(debugOutput, "%d of %d symbols listed.\n", i, count);
+	free(entries);
+}
+
+/**
+ * Show statistics for given symbol list.
+ */
+static void Symbols_ShowStats(symbol_list_t *list)
+{
+	int i, data = 0, bss = 0, abs = 0;
+
+	if (!list)
+	{
+		fprintf(stderr, "No symbols loaded.\n");
+		return;
+	}
+	for (i = 0; i < list->count; i++)
+	{
+		switch (list->symbols[i].type)
+		{
+		case SYMTYPE_DATA: data++; break;
+		case SYMTYPE_BSS:  bss++;  break;
+		case SYMTYPE_ABS:  abs++;  break;
+		default: break;
+		}
+	}
+	fprintf(stderr, "Symbols from '%s':\n", list->filename);
+	fprintf(stderr, "- %d code symbols\n", list->codecount);
+	fprintf(stderr, "- %d data symbols\n", data);
+	fprintf(stderr, "- %d BSS symbols\n", bss);
+	fprintf(stderr, "- %d absolute symbols\n", abs);
+	fprintf(stderr, "= %d symbols\n", list->count);
+}
 
 /**
  * Handle debugger 'symbols' command and its arguments
  */
 int Symbols_Command(int nArgc, char *psArgs[])
 {
+	symbol_list_t **listp, *list;
+	const char *cmd;
+	uint32_t offset = 0;
+	bool for_dsp;
+	int show = INT_MAX;
+
+	if (nArgc < 2)
+	{
+		DebugUI_PrintCmdHelp(psArgs[0]);
+		return DEBUGGER_CMDDONE;
+	}
+	for_dsp = (strcmp(psArgs[0], "dspsymbols") == 0);
+	listp = for_dsp ? &DspSymbolsList : &CpuSymbolsList;
+	cmd = psArgs[1];
+
+	if (nArgc > 2 && strcmp(cmd, "code") && strcmp(cmd, "data") && strcmp(cmd, "name"))
+	{
+		if (!Eval_Number(psArgs[2], &offset, for_dsp ? NUM_TYPE_DSP : NUM_TYPE_CPU))
+		{
+			fprintf(stderr, "ERROR: invalid offset '%s'!\n", psArgs[2]);
+			return DEBUGGER_CMDDONE;
+		}
+	}
+	else if (nArgc > 2 && atoi(psArgs[2]) > 0)
+		show = atoi(psArgs[2]);
+
+	if (strcmp(cmd, "code") == 0)
+		Symbols_Show(*listp, SYMTYPE_CODE, false, show);
+	else if (strcmp(cmd, "data") == 0)
+		Symbols_Show(*listp, SYMTYPE_DATA|SYMTYPE_BSS, false, show);
+	else if (strcmp(cmd, "name") == 0)
+		Symbols_Show(*listp, SYMTYPE_ALL, true, show);
+	else if (strcmp(cmd, "stats") == 0)
+		Symbols_ShowStats(*listp);
+	else if (strcmp(cmd, "free") == 0)
+	{
+		Symbols_Free(*listp);
+		*listp = NULL;
+	}
+	else
+	{
+		list = Symbols_Load(cmd, offset, for_dsp);
+		if (list)
+		{
+			Symbols_Free(*listp);
+			*listp = list;
+			fprintf(stderr, "Loaded %d %s symbols from '%s'.\n",
+			        list->count, for_dsp ? "DSP" : "CPU", cmd);
+		}
+	}
 	return DEBUGGER_CMDDONE;
 }
@@ -44,6 +44,7 @@ extern bool Symbols_GetCpuMethodAddress(symtype_t symtype, const char *prefix, u
 /* symbol address -> name search */
 extern const char* Symbols_GetByCpuAddress(uint32_t addr, symtype_t symtype);
 extern const char* Symbols_GetByDspAddress(uint32_t addr, symtype_t symtype);
+extern const char* Symbols_GetBeforeCpuAddress(uint32_t *addr);
 /* handlers for automatic program symbol loading */
 extern void Symbols_AutoLoadCurrentProgram(const uint32_t *offsets, uint32_t maxaddr);
 extern void Symbols_FreeAll(void);
@@ -37,6 +37,10 @@ bool Dialog_DoProperty(void)
 	bool bLoadedSnapshot;
 	CNF_PARAMS current;
 
+	if (bHeadless) {
+		return false;
+	}
+
 	bWasActive = Main_PauseEmulation(true);
 	bForceReset = false;
 
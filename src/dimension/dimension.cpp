@@ -16,6 +16,7 @@
 #include "nd_nbic.hpp"
 #include "nd_mem.hpp"
 #include "nd_sdl.hpp"
+#include "memorySnapShot.h"
 
 #define nd_get_mem_bank(addr)    (nd->mem_banks[nd_bankindex((addr)|ND_BOARD_BITS)])
 #define nd68k_get_mem_bank(addr) (mem_banks[nd_bankindex(addr)])
@@ -47,6 +48,7 @@ NextDimension::NextDimension(int slot) :
     rom_last_addr(0),
     display_vbl(false),
     video_vbl(false),
+    vram_generation(0),
     sdl(slot, (uint32_t*)vram),
     i860(this),
     nbic(slot, ND_NBIC_ID),
@@ -87,6 +89,79 @@ void NextDimension::pause(bool pause) {
     i860.pause(pause);
 }
 
+void NextDimension::snapshot(bool save) {
+    int port, wait;
+    
+    /* Let the i860 thread consume pending messages before it is stopped */
+    for (wait = 0; wait < 100 && ConfigureParams.Dimension.bI860Thread && host_atomic_get(&m_port); wait++) {
+        host_sleep_ms(1);
+    }
+    port = host_atomic_get(&m_port);
+    MemorySnapShot_Store(&port, sizeof(port));
+    
+    i860.snapshot(save);
+    
+    MemorySnapShot_StoreBlock(ram, 64*1024*1024);
+    MemorySnapShot_StoreBlock(vram, 4*1024*1024);
+    MemorySnapShot_Store(dmem, 512);
+    MemorySnapShot_Store(&rom_command, sizeof(rom_command));
+    MemorySnapShot_Store(&rom_last_addr, sizeof(rom_last_addr));
+    MemorySnapShot_Store((void*)&display_vbl, sizeof(display_vbl));
+    MemorySnapShot_Store((void*)&video_vbl, sizeof(video_vbl));
+    
+    MemorySnapShot_Store(&mc.csr0, sizeof(mc.csr0));
+    MemorySnapShot_Store(&mc.csr1, sizeof(mc.csr1));
+    MemorySnapShot_Store(&mc.csr2, sizeof(mc.csr2));
+    MemorySnapShot_Store(&mc.sid, sizeof(mc.sid));
+    MemorySnapShot_Store(&mc.dma_csr, sizeof(mc.dma_csr));
+    MemorySnapShot_Store(&mc.dma_start, sizeof(mc.dma_start));
+    MemorySnapShot_Store(&mc.dma_width, sizeof(mc.dma_width));
+    MemorySnapShot_Store(&mc.dma_pstart, sizeof(mc.dma_pstart));
+    MemorySnapShot_Store(&mc.dma_pwidth, sizeof(mc.dma_pwidth));
+    MemorySnapShot_Store(&mc.dma_sstart, sizeof(mc.dma_sstart));
+    MemorySnapShot_Store(&mc.dma_swidth, sizeof(mc.dma_swidth));
+    MemorySnapShot_Store(&mc.dma_bsstart, sizeof(mc.dma_bsstart));
+    MemorySnapShot_Store(&mc.dma_bswidth, sizeof(mc.dma_bswidth));
+    MemorySnapShot_Store(&mc.dma_top, sizeof(mc.dma_top));
+    MemorySnapShot_Store(&mc.dma_bottom, sizeof(mc.dma_bottom));
+    MemorySnapShot_Store(&mc.dma_line_a, sizeof(mc.dma_line_a));
+    MemorySnapShot_Store(&mc.dma_curr_a, sizeof(mc.dma_curr_a));
+    MemorySnapShot_Store(&mc.dma_scurr_a, sizeof(mc.dma_scurr_a));
+    MemorySnapShot_Store(&mc.dma_out_a, sizeof(mc.dma_out_a));
+    MemorySnapShot_Store(&mc.vram, sizeof(mc.vram));
+    MemorySnapShot_Store(&mc.dram, sizeof(mc.dram));
+    MemorySnapShot_Store(&dp.iic_addr, sizeof(dp.iic_addr));
+    MemorySnapShot_Store(&dp.iic_msg, sizeof(dp.iic_msg));
+    MemorySnapShot_Store(&dp.iic_msgsz, sizeof(dp.iic_msgsz));
+    MemorySnapShot_Store(&dp.iic_busy, sizeof(dp.iic_busy));
+    MemorySnapShot_Store(&dp.doff, sizeof(dp.doff));
+    MemorySnapShot_Store(&dp.csr, sizeof(dp.csr));
+    MemorySnapShot_Store(&dp.alpha, sizeof(dp.alpha));
+    MemorySnapShot_Store(&dp.dma, sizeof(dp.dma));
+    MemorySnapShot_Store(&dp.cpu_x, sizeof(dp.cpu_x));
+    MemorySnapShot_Store(&dp.cpu_y, sizeof(dp.cpu_y));
+    MemorySnapShot_Store(&dp.dma_x, sizeof(dp.dma_x));
+    MemorySnapShot_Store(&dp.dma_y, sizeof(dp.dma_y));
+    MemorySnapShot_Store(&dp.iic_stat_addr, sizeof(dp.iic_stat_addr));
+    MemorySnapShot_Store(&dp.iic_data, sizeof(dp.iic_data));
+    MemorySnapShot_Store(&dmcd.addr, sizeof(dmcd.addr));
+    MemorySnapShot_Store(dmcd.reg, sizeof(dmcd.reg));
+    MemorySnapShot_Store(&dcsc0.addr, sizeof(dcsc0.addr));
+    MemorySnapShot_Store(&dcsc0.ctrl, sizeof(dcsc0.ctrl));
+    MemorySnapShot_Store(dcsc0.lut, sizeof(dcsc0.lut));
+    MemorySnapShot_Store(&dcsc1.addr, sizeof(dcsc1.addr));
+    MemorySnapShot_Store(&dcsc1.ctrl, sizeof(dcsc1.ctrl));
+    MemorySnapShot_Store(dcsc1.lut, sizeof(dcsc1.lut));
+    MemorySnapShot_Store(&ramdac, sizeof(ramdac));
+    
+    nbic.snapshot(save);
+    
+    if (!save) {
+        host_atomic_set(&m_port, port);
+        vram_generation++;
+    }
+}
+
 /* NeXTdimension board memory access (m68k) */
 
  uint32_t NextDimension::board_lget(uint32_t addr) {
@@ -387,6 +462,14 @@ extern "C" {
         }
     }
 
+    uint32_t nd_vram_generation(int slot) {
+        IF_NEXT_DIMENSION(slot, nd) {
+            return nd->vram_generation;
+        } else {
+            return 0;
+        }
+    }
+
     void nd_start_debugger(void) {
         FOR_EACH_SLOT(slot) {
             IF_NEXT_DIMENSION(slot, nd) {
@@ -31,6 +31,7 @@ extern "C" {
     extern void        nd_display_repaint(void);
     extern bool        nd_video_enabled(int slot);
     extern uint32_t*   nd_vram_for_slot(int slot);
+    extern uint32_t    nd_vram_generation(int slot);
     extern void        nd_start_debugger(void);
     extern const char* nd_reports(uint64_t realTime, uint64_t hostTime);
 #ifdef __cplusplus
@@ -153,6 +154,7 @@ public:
     
     volatile bool   display_vbl;
     volatile bool   video_vbl;
+    volatile uint32_t vram_generation; /* incremented on every write to VRAM */
     
     NDSDL           sdl;
     i860_cpu_device i860;
@@ -186,6 +188,7 @@ public:
 
     virtual void     reset(void);
     virtual void     pause(bool pause);
+    virtual void     snapshot(bool save);
 
     static uint8_t   i860_cs8get  (const NextDimension* nd, uint32_t addr);
     static void      i860_rd8_be  (const NextDimension* nd, uint32_t addr, uint32_t* val);
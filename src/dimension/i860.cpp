@@ -26,6 +26,8 @@
 #include "main.h"
 #include "event.h"
 #include "log.h"
+#include "hostprof.h"
+#include "memorySnapShot.h"
 
 extern "C" {
     static void i860_run_nop(int nHostCycles) {}
@@ -38,12 +40,16 @@ extern "C" {
 
     static void i860_run_no_thread(int nHostCycles) {
         int cycles;
+        uint16_t tags = HostProf_Enter(HOSTPROF_I860);
         
         FOR_EACH_SLOT(slot) {
             IF_NEXT_DIMENSION(slot, nd) {
                 nd->handle_msgs();
                 
-                if(nd->i860.is_halted()) return;
+                if(nd->i860.is_halted()) {
+                    HostProf_Leave(tags);
+                    return;
+                }
                 
                 cycles = nHostCycles * 33; // i860 @ 33MHz
                 cycles /= ConfigureParams.System.nCpuFreq;
@@ -54,6 +60,7 @@ extern "C" {
             }
         }
         nd_nbic_interrupt();
+        HostProf_Leave(tags);
     }    
 }
 
@@ -80,6 +87,7 @@ i860_cpu_device::i860_cpu_device(NextDimension* nd) : nd(nd) {
 
 int i860_cpu_device::thread(void* data) {
     host_thread_priority(0);
+    HostProf_SetThread("i860");
     ((i860_cpu_device*)data)->run();
     return 0;
 }
@@ -559,6 +567,51 @@ void i860_cpu_device::uninit() {
     }
 }
 
+void i860_cpu_device::snapshot(bool save) {
+    bool threaded = m_thread != NULL;
+    int  cycles   = host_atomic_get(&i860cycles);
+    
+    /* Stop the i860 thread so that its state does not change */
+    if(threaded) {
+        nd->send_msg(MSG_I860_KILL);
+        host_thread_wait(m_thread);
+        m_thread = NULL;
+    }
+    
+    MemorySnapShot_Store(&m_fpcs, sizeof(m_fpcs));
+    MemorySnapShot_Store(&m_pc, sizeof(m_pc));
+    MemorySnapShot_Store(&m_delay_slot_pc, sizeof(m_delay_slot_pc));
+    MemorySnapShot_Store(m_iregs, sizeof(m_iregs));
+    MemorySnapShot_Store(m_fregs, sizeof(m_fregs));
+    MemorySnapShot_Store(m_cregs, sizeof(m_cregs));
+    MemorySnapShot_Store(&m_dim, sizeof(m_dim));
+    MemorySnapShot_Store(&m_dim_cc, sizeof(m_dim_cc));
+    MemorySnapShot_Store(&m_dim_cc_valid, sizeof(m_dim_cc_valid));
+    MemorySnapShot_Store(&m_KR, sizeof(m_KR));
+    MemorySnapShot_Store(&m_KI, sizeof(m_KI));
+    MemorySnapShot_Store(&m_T, sizeof(m_T));
+    MemorySnapShot_Store(&m_merge, sizeof(m_merge));
+    MemorySnapShot_Store(m_A, sizeof(m_A));
+    MemorySnapShot_Store(m_M, sizeof(m_M));
+    MemorySnapShot_Store(m_L, sizeof(m_L));
+    MemorySnapShot_Store(&m_G, sizeof(m_G));
+    MemorySnapShot_Store((void*)&m_halt, sizeof(m_halt));
+    MemorySnapShot_Store(&m_flow, sizeof(m_flow));
+    MemorySnapShot_Store(&m_single_stepping, sizeof(m_single_stepping));
+    MemorySnapShot_Store(&cycles, sizeof(cycles));
+    
+    if(!save) {
+        host_atomic_set(&i860cycles, cycles);
+        set_mem_access(GET_EPSR_BE());
+        invalidate_icache();
+        invalidate_tlb();
+    }
+    
+    if(threaded) {
+        m_thread = host_thread_create(i860_cpu_device::thread, m_thread_name, this);
+    }
+}
+
 /* Message disaptcher - executed on i860 thread, safe to call i860 methods */
 bool i860_cpu_device::handle_msgs(int msg) {
     if(msg & MSG_I860_KILL)
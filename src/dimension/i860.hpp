@@ -454,6 +454,8 @@ public:
     void run();
     /* i860 thread message handler */
     bool handle_msgs(int msg);
+    /* Save/Restore snapshot of i860 state, i860 thread must be stopped */
+    void snapshot(bool save);
     
     static int thread(void* data);
     
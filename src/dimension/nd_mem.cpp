@@ -189,6 +189,7 @@ public:
             case 2: base[addr-2] = l >> 24; base[addr+1] = l >> 16; base[addr+4] = l >> 8; base[addr+3] = l; break;
             case 3: base[addr+0] = l >> 24; base[addr+3] = l >> 16; base[addr+2] = l >> 8; base[addr+1] = l; break;
         }
+        nd->vram_generation++;
     }
 
     uint32_t wget(uint32_t addr) const {
@@ -210,6 +211,7 @@ public:
             case 2: base[addr-2] = w >> 8; base[addr+1] = w; break;
             case 3: base[addr+0] = w >> 8; base[addr+3] = w; break;
         }
+        nd->vram_generation++;
     }
 
     uint32_t bget(uint32_t addr) const {
@@ -231,6 +233,7 @@ public:
             case 2: base[addr-2] = b; break;
             case 3: base[addr+0] = b; break;
         }
+        nd->vram_generation++;
     }
 };
 
@@ -12,6 +12,7 @@
 #include "nd_nbic.hpp"
 #include "dimension.hpp"
 #include "log.h"
+#include "memorySnapShot.h"
 
 /* NeXTdimention NBIC */
 #define ND_NBIC_INTR    0x80
@@ -158,6 +159,22 @@ void NBIC::init(void) {
     set_interrupt(INT_REMOTE, RELEASE_INT);
 }
 
+void NBIC::snapshot(bool save) {
+    uint32_t bit  = 1 << slot;
+    uint32_t rem  = remInter & bit;
+    uint32_t mask = remInterMask & bit;
+    
+    MemorySnapShot_Store(&intstatus, sizeof(intstatus));
+    MemorySnapShot_Store(&intmask, sizeof(intmask));
+    MemorySnapShot_Store(&rem, sizeof(rem));
+    MemorySnapShot_Store(&mask, sizeof(mask));
+    
+    if (!save) {
+        remInter     = (remInter & ~bit) | rem;
+        remInterMask = (remInterMask & ~bit) | mask;
+    }
+}
+
 volatile uint32_t NBIC::remInter;
 volatile uint32_t NBIC::remInterMask;
 
@@ -38,6 +38,7 @@ public:
     
     void   init(void);
     void   set_intstatus(bool set);
+    void   snapshot(bool save);
 };
 
 extern "C" {
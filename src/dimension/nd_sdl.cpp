@@ -11,10 +11,11 @@
 #include "dimension.hpp"
 #include "sdlscreen.h"
 #include "screen.h"
+#include "hostprof.h"
 
 
 #ifdef ENABLE_RENDERING_THREAD
-NDSDL::NDSDL(int slot, uint32_t* vram) : slot(slot), vram(vram), ndWindow(NULL), ndRenderer(NULL), ndTexture(NULL), doRepaint(true), repaintThread(NULL) {}
+NDSDL::NDSDL(int slot, uint32_t* vram) : slot(slot), vram(vram), ndWindow(NULL), ndRenderer(NULL), ndTexture(NULL), frameValid(false), doRepaint(true), repaintThread(NULL) {}
 
 int NDSDL::repainter(void *_this) {
     return ((NDSDL*)_this)->repainter();
@@ -22,10 +23,13 @@ int NDSDL::repainter(void *_this) {
 
 int NDSDL::repainter(void) {
     host_thread_priority(1);
+    HostProf_SetThread("nd repaint");
 
     while (doRepaint) {
         if (bEmulationActive && SDL_GetAtomicInt(&blitNDFB)) {
-            repaint();
+            if (!repaint()) {
+                host_sleep_ms(10);
+            }
         } else {
             host_sleep_ms(100);
         }
@@ -34,11 +38,23 @@ int NDSDL::repainter(void) {
     return 0;
 }
 #else // !ENABLE_RENDERING_THREAD
-NDSDL::NDSDL(int slot, uint32_t* vram) : slot(slot), vram(vram), ndWindow(NULL), ndRenderer(NULL), ndTexture(NULL) {}
+NDSDL::NDSDL(int slot, uint32_t* vram) : slot(slot), vram(vram), ndWindow(NULL), ndRenderer(NULL), ndTexture(NULL), frameValid(false) {}
 #endif // !ENABLE_RENDERING_THREAD
 
-void NDSDL::repaint(void) {
-    if (nd_video_enabled(slot)) {
+bool NDSDL::repaint(void) {
+    bool     enabled    = nd_video_enabled(slot);
+    uint32_t generation = nd_vram_generation(slot);
+
+    // skip conversion and present if nothing changed since last frame
+    if (frameValid && enabled == frameEnabled && (!enabled || generation == frameGeneration)) {
+        Screen_CountFrame(false);
+        return false;
+    }
+    frameValid      = true;
+    frameEnabled    = enabled;
+    frameGeneration = generation;
+
+    if (enabled) {
         Screen_BlitDimension(vram, ndTexture);
     } else {
         Screen_Blank(ndTexture);
@@ -46,13 +62,15 @@ void NDSDL::repaint(void) {
     SDL_RenderClear(ndRenderer);
     SDL_RenderTexture(ndRenderer, ndTexture, NULL, NULL);
     SDL_RenderPresent(ndRenderer);
+    Screen_CountFrame(true);
+    return true;
 }
 
 void NDSDL::init(void) {
     int x, y, w, h;
     char name[32];
 
-    if (ConfigureParams.Screen.nMode == SCREEN_ALL) {
+    if (ConfigureParams.Screen.nMode == SCREEN_ALL && !bHeadless) {
         SDL_GetWindowPosition(sdlWindow, &x, &y);
         SDL_GetWindowSize(sdlWindow, &w, &h);
         h = (w * NeXT_SCRN_H) / NeXT_SCRN_W;
@@ -81,6 +99,7 @@ void NDSDL::init(void) {
 
         titlebar(ConfigureParams.Screen.bShowTitlebar);
 
+        frameValid = false;
         SDL_ShowWindow(ndWindow);
 #ifdef ENABLE_RENDERING_THREAD
         SDL_SetAtomicInt(&blitNDFB, 1);
@@ -109,6 +128,7 @@ void NDSDL::destroy(void) {
 void NDSDL::resize(float scale) {
     if (ndWindow) {
         SDL_SetWindowSize(ndWindow, (int)SDL_lroundf(scale*NeXT_SCRN_W), (int)SDL_lroundf(scale*NeXT_SCRN_H));
+        frameValid = false;
     }
 }
 
@@ -23,6 +23,10 @@ class NDSDL {
     SDL_Renderer* ndRenderer;
     SDL_Texture*  ndTexture;
 
+    bool          frameValid;
+    bool          frameEnabled;
+    uint32_t      frameGeneration;
+
 #ifdef ENABLE_RENDERING_THREAD
     volatile bool doRepaint;
     SDL_AtomicInt blitNDFB;
@@ -32,7 +36,7 @@ class NDSDL {
 #endif
 public:
     NDSDL(int slot, uint32_t* vram);
-    void    repaint(void);
+    bool    repaint(void);
     void    init(void);
     void    uninit(void);
     void    destroy(void);
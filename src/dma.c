@@ -27,6 +27,7 @@ const char Dma_fileid[] = "Previous dma.c";
 #include "snd.h"
 #include "dsp.h"
 #include "mmu_common.h"
+#include "memorySnapShot.h"
 
 #define LOG_DMA_LEVEL LOG_DEBUG
 
@@ -1234,3 +1235,15 @@ void DMA_Reset(void) {
     }
     CycInt_RemovePendingEvent(EVENT_DMA_M2M_IO);
 }
+
+void DMA_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(dma, sizeof(dma));
+    MemorySnapShot_Store(&espdma_buf_size, sizeof(espdma_buf_size));
+    MemorySnapShot_Store(&espdma_buf_limit, sizeof(espdma_buf_limit));
+    MemorySnapShot_Store(espdma_buf, sizeof(espdma_buf));
+    MemorySnapShot_Store(&modma_buf_size, sizeof(modma_buf_size));
+    MemorySnapShot_Store(&modma_buf_limit, sizeof(modma_buf_limit));
+    MemorySnapShot_Store(modma_buf, sizeof(modma_buf));
+    MemorySnapShot_Store(m2m_buffer, sizeof(m2m_buffer));
+    MemorySnapShot_Store(&m2m_buffer_size, sizeof(m2m_buffer_size));
+}
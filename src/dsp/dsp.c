@@ -32,6 +32,8 @@
 #include "dma.h"
 #include "snd.h"
 #include "statusbar.h"
+#include "hostprof.h"
+#include "memorySnapShot.h"
 
 #if ENABLE_DSP_EMU
 #include "debugdsp.h"
@@ -286,15 +288,46 @@ void DSP_Start(uint8_t mode)
 void DSP_Run(int nHostCycles)
 {
 #if ENABLE_DSP_EMU
+	uint16_t tags = HostProf_Enter(HOSTPROF_DSP);
+
 	save_cycles += nHostCycles * 2;
 	
-	while (save_cycles > 0)
+	if (unlikely(bDspDebugging))
+	{
+		while (save_cycles > 0)
+		{
+			dsp56k_execute_instruction();
+			save_cycles -= dsp_core.instr_cycle;
+			DebugDsp_Check();
+		}
+	}
+	else
 	{
-		dsp56k_execute_instruction();
-		save_cycles -= dsp_core.instr_cycle;
+		while (save_cycles > 0)
+		{
+			dsp56k_execute_instruction();
+			save_cycles -= dsp_core.instr_cycle;
+		}
 	}
 	
 	DSP_HandleDMA();
+	HostProf_Leave(tags);
+#endif
+}
+
+/**
+ * Save/Restore snapshot of DSP state and external memory
+ */
+void DSP_MemorySnapShot_Capture(bool bSave)
+{
+#if ENABLE_DSP_EMU
+	MemorySnapShot_Store(&dsp_core, sizeof(dsp_core));
+	MemorySnapShot_Store(&DSP_RAMSIZE, sizeof(DSP_RAMSIZE));
+	MemorySnapShot_Store(&save_cycles, sizeof(save_cycles));
+	MemorySnapShot_StoreBlock(dsp_ram, sizeof(dsp_ram));
+
+	/* External memory is always our own buffer if enabled */
+	dsp_core.ramext = DSP_RAMSIZE ? dsp_ram : NULL;
 #endif
 }
 
@@ -364,6 +397,26 @@ uint16_t DSP_GetInstrCycles(void)
 	return 0;
 }
 
+/**
+ * Get DSP hardware loop state (for profiling).  Return the last address
+ * of the innermost active DO loop or -1 if there's none, and set *rep
+ * when an instruction is being repeated with REP.
+ */
+int DSP_GetLoopState(bool *rep)
+{
+#if ENABLE_DSP_EMU
+	if (bDspEnabled)
+	{
+		*rep = dsp_core.loop_rep && !dsp_core.pc_on_rep;
+		if (dsp_core.registers[DSP_REG_SR] & (1<<DSP_SR_LF))
+			return dsp_core.registers[DSP_REG_LA];
+		return -1;
+	}
+#endif
+	*rep = false;
+	return -1;
+}
+
 
 /**
  * Disassemble DSP code between given addresses, return next PC address
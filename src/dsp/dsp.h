@@ -46,6 +46,7 @@ extern void DSP_SetDebugging(bool enabled);
 extern uint16_t DSP_GetPC(void);
 extern uint16_t DSP_GetNextPC(uint16_t pc);
 extern uint16_t DSP_GetInstrCycles(void);
+extern int DSP_GetLoopState(bool *rep);
 extern uint32_t DSP_ReadMemory(uint16_t addr, char space, const char **mem_str);
 extern uint16_t DSP_DisasmMemory(FILE *fp, uint16_t dsp_memdump_addr, uint16_t dsp_memdump_upper, char space);
 extern uint16_t DSP_DisasmAddress(FILE *out, uint16_t lowerAdr, uint16_t UpperAdr);
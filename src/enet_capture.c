@@ -0,0 +1,341 @@
+/*
+  Previous - enet_capture.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Capture Ethernet frames sent and received by the emulated controller to
+  pcapng files. Frames are copied into a single producer, single consumer
+  ring on the emulation thread and written to disk by a background thread,
+  so slow disk I/O never stalls the emulation. With a size limit, files
+  are rotated through a fixed number of names, overwriting the oldest.
+*/
+const char Enet_capture_fileid[] = "Previous enet_capture.c";
+
+#include "main.h"
+#include "log.h"
+#include "host.h"
+#include "enet_capture.h"
+
+#include <time.h>
+
+#define LOG_EN_CAPTURE_LEVEL LOG_DEBUG
+
+#define CAPTURE_SNAPLEN     1518
+#define CAPTURE_SLOTS       512         /* must be a power of two */
+#define CAPTURE_WAIT_MS     100
+#define CAPTURE_MAX_FILES   10          /* default number of rotated files */
+
+typedef struct {
+    uint64_t counter;   /* host counter when the frame passed the controller */
+    uint32_t len;
+    uint32_t dropped;   /* frames dropped since the previous one in the ring */
+    bool     out;
+    uint8_t  data[CAPTURE_SNAPLEN];
+} capture_slot_t;
+
+static capture_slot_t capture_ring[CAPTURE_SLOTS];
+static atomic_int     capture_head;     /* written by emulation thread */
+static atomic_int     capture_tail;     /* written by writer thread */
+static atomic_int     capture_dropped;
+static atomic_int     capture_seen;
+static uint32_t       capture_lost;     /* emulation thread only */
+
+volatile bool         enet_capture_enabled = false;
+
+static thread_t*      capture_thread;
+static semaphore_t*   capture_sem;
+static volatile bool  capture_running;
+
+static char           capture_path[FILENAME_MAX];
+static FILE*          capture_file;
+static uint64_t       capture_size;
+static uint64_t       capture_maxsize;
+static int            capture_index;
+static int            capture_maxfiles;
+
+static uint64_t       capture_counter_start;
+static uint64_t       capture_counter_freq;
+static uint64_t       capture_epoch_ns;
+
+
+/* pcapng block types and options */
+#define PCAPNG_SHB          0x0A0D0D0A
+#define PCAPNG_IDB          0x00000001
+#define PCAPNG_ISB          0x00000005
+#define PCAPNG_EPB          0x00000006
+#define PCAPNG_BYTE_ORDER   0x1A2B3C4D
+#define PCAPNG_LINKTYPE_ETH 1
+#define PCAPNG_OPT_END      0
+#define PCAPNG_OPT_TSRESOL  9
+#define PCAPNG_OPT_EPBFLAGS 2
+#define PCAPNG_OPT_DROPCNT  4
+#define PCAPNG_OPT_IFRECV   4
+#define PCAPNG_OPT_IFDROP   5
+#define PCAPNG_FLAG_IN      0x1
+#define PCAPNG_FLAG_OUT     0x2
+
+static void capture_put32(uint8_t* p, uint32_t v) {
+    memcpy(p, &v, 4); /* pcapng is written in host byte order */
+}
+
+static void capture_put16(uint8_t* p, uint16_t v) {
+    memcpy(p, &v, 2);
+}
+
+static void capture_put64(uint8_t* p, uint64_t v) {
+    memcpy(p, &v, 8);
+}
+
+static bool capture_write(const void* buf, size_t len) {
+    if (fwrite(buf, 1, len, capture_file) != len) {
+        Log_Printf(LOG_WARN, "[EN] Capture: Write error. Stopping capture.");
+        return false;
+    }
+    capture_size += len;
+    return true;
+}
+
+/* Section header and interface description, written at the start of each file */
+static bool capture_write_header(void) {
+    uint8_t shb[28];
+    uint8_t idb[32];
+
+    capture_put32(shb+0,  PCAPNG_SHB);
+    capture_put32(shb+4,  sizeof(shb));
+    capture_put32(shb+8,  PCAPNG_BYTE_ORDER);
+    capture_put16(shb+12, 1);                    /* major version */
+    capture_put16(shb+14, 0);                    /* minor version */
+    capture_put32(shb+16, 0xFFFFFFFF);           /* section length unknown */
+    capture_put32(shb+20, 0xFFFFFFFF);
+    capture_put32(shb+24, sizeof(shb));
+
+    capture_put32(idb+0,  PCAPNG_IDB);
+    capture_put32(idb+4,  sizeof(idb));
+    capture_put16(idb+8,  PCAPNG_LINKTYPE_ETH);
+    capture_put16(idb+10, 0);
+    capture_put32(idb+12, CAPTURE_SNAPLEN);
+    capture_put16(idb+16, PCAPNG_OPT_TSRESOL);   /* nanosecond timestamps */
+    capture_put16(idb+18, 1);
+    idb[20] = 9; idb[21] = idb[22] = idb[23] = 0;
+    capture_put16(idb+24, PCAPNG_OPT_END);
+    capture_put16(idb+26, 0);
+    capture_put32(idb+28, sizeof(idb));
+
+    return capture_write(shb, sizeof(shb)) && capture_write(idb, sizeof(idb));
+}
+
+/* Build the name of the n-th file by inserting the index before the extension */
+static void capture_filename(char* name, size_t size, int index) {
+    const char* ext;
+
+    if (index == 0) {
+        snprintf(name, size, "%s", capture_path);
+        return;
+    }
+    ext = strrchr(capture_path, '.');
+    if (ext == NULL || strchr(ext, PATHSEP)) {
+        snprintf(name, size, "%s.%d", capture_path, index);
+    } else {
+        snprintf(name, size, "%.*s.%d%s", (int)(ext - capture_path), capture_path, index, ext);
+    }
+}
+
+static bool capture_open(void) {
+    char name[FILENAME_MAX];
+
+    capture_filename(name, sizeof(name), capture_index);
+    capture_file = fopen(name, "wb");
+    if (capture_file == NULL) {
+        Log_Printf(LOG_WARN, "[EN] Capture: Couldn't open %s", name);
+        return false;
+    }
+    Log_Printf(LOG_WARN, "[EN] Capture: Writing to %s", name);
+    capture_size = 0;
+    return capture_write_header();
+}
+
+static uint64_t capture_time_ns(uint64_t counter) {
+    uint64_t d = counter - capture_counter_start;
+    uint64_t sec = d / capture_counter_freq;
+    uint64_t rem = d % capture_counter_freq;
+    return capture_epoch_ns + sec * 1000000000ULL + (rem * 1000000000ULL) / capture_counter_freq;
+}
+
+/* Interface statistics with frame and drop counts since capture start, *
+ * written at the end of each file                                       */
+static bool capture_write_stats(void) {
+    uint8_t isb[52];
+    uint64_t ts = capture_time_ns(host_get_counter());
+
+    capture_put32(isb+0,  PCAPNG_ISB);
+    capture_put32(isb+4,  sizeof(isb));
+    capture_put32(isb+8,  0);                    /* interface id */
+    capture_put32(isb+12, (uint32_t)(ts >> 32));
+    capture_put32(isb+16, (uint32_t)ts);
+    capture_put16(isb+20, PCAPNG_OPT_IFRECV);
+    capture_put16(isb+22, 8);
+    capture_put64(isb+24, (uint32_t)host_atomic_get(&capture_seen));
+    capture_put16(isb+32, PCAPNG_OPT_IFDROP);
+    capture_put16(isb+34, 8);
+    capture_put64(isb+36, (uint32_t)host_atomic_get(&capture_dropped));
+    capture_put16(isb+44, PCAPNG_OPT_END);
+    capture_put16(isb+46, 0);
+    capture_put32(isb+48, sizeof(isb));
+
+    return capture_write(isb, sizeof(isb));
+}
+
+static bool capture_write_packet(capture_slot_t* slot) {
+    uint8_t hdr[28];
+    uint8_t opt[24];
+    uint8_t pad[4] = { 0, 0, 0, 0 };
+    uint32_t padlen = (4 - (slot->len & 3)) & 3;
+    uint32_t optlen = slot->dropped ? 24 : 12;
+    uint32_t total  = sizeof(hdr) + slot->len + padlen + optlen + 4;
+    uint64_t ts     = capture_time_ns(slot->counter);
+
+    if (capture_maxsize && capture_size + total > capture_maxsize && capture_size > 0) {
+        capture_write_stats();
+        fclose(capture_file);
+        capture_index++;
+        if (capture_maxfiles > 0) {
+            capture_index %= capture_maxfiles;
+        }
+        if (!capture_open()) {
+            return false;
+        }
+    }
+
+    capture_put32(hdr+0,  PCAPNG_EPB);
+    capture_put32(hdr+4,  total);
+    capture_put32(hdr+8,  0);                    /* interface id */
+    capture_put32(hdr+12, (uint32_t)(ts >> 32));
+    capture_put32(hdr+16, (uint32_t)ts);
+    capture_put32(hdr+20, slot->len);
+    capture_put32(hdr+24, slot->len);
+
+    capture_put16(opt+0, PCAPNG_OPT_EPBFLAGS);
+    capture_put16(opt+2, 4);
+    capture_put32(opt+4, slot->out ? PCAPNG_FLAG_OUT : PCAPNG_FLAG_IN);
+    if (slot->dropped) {
+        capture_put16(opt+8, PCAPNG_OPT_DROPCNT);
+        capture_put16(opt+10, 8);
+        capture_put64(opt+12, slot->dropped);
+    }
+    capture_put16(opt+optlen-4, PCAPNG_OPT_END);
+    capture_put16(opt+optlen-2, 0);
+
+    return capture_write(hdr, sizeof(hdr)) &&
+           capture_write(slot->data, slot->len) &&
+           capture_write(pad, padlen) &&
+           capture_write(opt, optlen) &&
+           capture_write(&total, 4);
+}
+
+/* Drain the ring, return false on write errors */
+static bool capture_drain(void) {
+    int tail = host_atomic_get(&capture_tail);
+    int head = host_atomic_get(&capture_head);
+
+    while (tail != head) {
+        if (!capture_write_packet(&capture_ring[tail & (CAPTURE_SLOTS-1)])) {
+            return false;
+        }
+        tail++;
+        host_atomic_set(&capture_tail, tail);
+        head = host_atomic_get(&capture_head);
+    }
+    return true;
+}
+
+static int capture_thread_func(void *arg) {
+    bool ok = true;
+
+    while (capture_running && ok) {
+        host_semaphore_wait_timeout(capture_sem, CAPTURE_WAIT_MS);
+        ok = capture_drain();
+        if (ok) {
+            fflush(capture_file);
+        }
+    }
+    if (ok && capture_drain()) {
+        capture_write_stats();
+    }
+    enet_capture_enabled = false;
+    fclose(capture_file);
+    capture_file = NULL;
+    return 0;
+}
+
+/* Called on the emulation thread for every frame. Never blocks: if the *
+ * writer thread falls behind, frames are dropped and counted.          */
+void enet_capture_packet(const uint8_t *pkt, int len, bool out) {
+    int head = host_atomic_get(&capture_head);
+    capture_slot_t* slot;
+
+    host_atomic_add(&capture_seen, 1);
+    if (head - host_atomic_get(&capture_tail) >= CAPTURE_SLOTS) {
+        host_atomic_add(&capture_dropped, 1);
+        capture_lost++;
+        return;
+    }
+    if (len > CAPTURE_SNAPLEN) {
+        len = CAPTURE_SNAPLEN;
+    }
+    slot = &capture_ring[head & (CAPTURE_SLOTS-1)];
+    slot->counter = host_get_counter();
+    slot->len     = len;
+    slot->dropped = capture_lost;
+    slot->out     = out;
+    memcpy(slot->data, pkt, len);
+    capture_lost = 0;
+    host_atomic_set(&capture_head, head + 1);
+    host_semaphore_signal(capture_sem);
+}
+
+/* Files are rotated when they reach maxsize bytes, through maxfiles  *
+ * names or through CAPTURE_MAX_FILES if 0. Unlimited if maxsize is 0. */
+bool enet_capture_start(const char *path, uint64_t maxsize, int maxfiles) {
+    struct timespec ts;
+
+    if (capture_running) {
+        enet_capture_stop();
+    }
+    snprintf(capture_path, sizeof(capture_path), "%s", path);
+    capture_maxsize  = maxsize;
+    capture_maxfiles = maxfiles > 0 ? maxfiles : CAPTURE_MAX_FILES;
+    capture_index    = 0;
+    if (!capture_open()) {
+        return false;
+    }
+
+    timespec_get(&ts, TIME_UTC);
+    capture_epoch_ns      = (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    capture_counter_start = host_get_counter();
+    capture_counter_freq  = host_get_counter_frequency();
+
+    host_atomic_set(&capture_head, 0);
+    host_atomic_set(&capture_tail, 0);
+    host_atomic_set(&capture_dropped, 0);
+    host_atomic_set(&capture_seen, 0);
+    capture_lost = 0;
+
+    if (capture_sem == NULL) {
+        capture_sem = host_semaphore_create(0);
+    }
+    capture_running = true;
+    capture_thread  = host_thread_create(capture_thread_func, "EnetCaptureThread", NULL);
+    enet_capture_enabled = true;
+    return true;
+}
+
+void enet_capture_stop(void) {
+    if (capture_running) {
+        enet_capture_enabled = false;
+        capture_running = false;
+        host_semaphore_signal(capture_sem);
+        host_thread_wait(capture_thread);
+        Log_Printf(LOG_WARN, "[EN] Capture: Stopped (%d frames dropped)", host_atomic_get(&capture_dropped));
+    }
+}
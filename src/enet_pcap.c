@@ -13,6 +13,20 @@ const char Enet_pcap_fileid[] = "Previous enet_pcap.c";
 #if HAVE_PCAP
 #include <pcap.h>
 
+#if HAVE_LINUX_IF_PACKET_H
+#define PCAP_MMAP_RING 1
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <net/if.h>
+#include <net/ethernet.h>
+#include <arpa/inet.h>
+#include <linux/if_packet.h>
+#else
+#define PCAP_MMAP_RING 0
+#endif
+
 #include "configuration.h"
 #include "log.h"
 #include "ethernet.h"
@@ -75,8 +89,173 @@ static int tick_func(void *arg)
 }
 
 
+#if PCAP_MMAP_RING
+/* On Linux frames are received through a memory mapped TPACKET_V3 ring. *
+ * The kernel fills whole blocks and hands them over by setting their    *
+ * status, so the receive poll can take frames directly from the ring    *
+ * without a helper thread, a fixed sleep or a copy into the queue.      */
+#define RING_BLOCK_SIZE (1<<16)
+#define RING_BLOCK_NR   32
+#define RING_FRAME_SIZE 2048
+#define RING_BLOCK_TOV  1       /* retire partially filled blocks after 1 ms */
+
+static bool     pcap_ring;
+static int      ring_fd = -1;
+static uint8_t* ring_map;
+static uint32_t ring_block;
+static uint32_t ring_pkts_left;
+static struct tpacket3_hdr* ring_pkt;
+static uint8_t  ring_mac[6];
+
+static struct tpacket_block_desc* pcap_ring_block(uint32_t n) {
+    return (struct tpacket_block_desc*)(ring_map + (size_t)n * RING_BLOCK_SIZE);
+}
+
+static void pcap_ring_release(void) {
+    struct tpacket_block_desc* bd = pcap_ring_block(ring_block);
+    __sync_synchronize();
+    bd->hdr.bh1.block_status = TP_STATUS_KERNEL;
+    ring_block = (ring_block + 1) % RING_BLOCK_NR;
+    ring_pkts_left = 0;
+}
+
+static void pcap_ring_poll(void) {
+    struct tpacket_block_desc* bd;
+    uint8_t* data;
+    int len;
+    
+    if (ring_pkts_left == 0) {
+        bd = pcap_ring_block(ring_block);
+        if (!(bd->hdr.bh1.block_status & TP_STATUS_USER)) {
+            return;
+        }
+        __sync_synchronize();
+        ring_pkts_left = bd->hdr.bh1.num_pkts;
+        ring_pkt = (struct tpacket3_hdr*)((uint8_t*)bd + bd->hdr.bh1.offset_to_first_pkt);
+        if (ring_pkts_left == 0) {
+            pcap_ring_release();
+            return;
+        }
+    }
+    
+    while (ring_pkts_left > 0) {
+        data = (uint8_t*)ring_pkt + ring_pkt->tp_mac;
+        len  = ring_pkt->tp_snaplen;
+        ring_pkt = (struct tpacket3_hdr*)((uint8_t*)ring_pkt + ring_pkt->tp_next_offset);
+        ring_pkts_left--;
+        
+        /* Same selection as the PCAP filter expression */
+        if (len >= 14 && ((data[0]&0x01) || memcmp(data, ring_mac, 6) == 0)) {
+            if (len > 1516)
+                len = 1516;
+            Log_Printf(LOG_EN_PCAP_LEVEL, "[PCAP] Output packet with %i bytes from ring", len);
+            enet_receive(data, len);
+            break;
+        }
+    }
+    
+    if (ring_pkts_left == 0) {
+        pcap_ring_release();
+    }
+}
+
+static void pcap_ring_input(uint8_t *pkt, int pkt_len) {
+    if (send(ring_fd, pkt, pkt_len, 0) < 0) {
+        Log_Printf(LOG_WARN, "[PCAP] Error: Couldn't transmit packet: %s", strerror(errno));
+    }
+}
+
+static void pcap_ring_stop(void) {
+    munmap(ring_map, (size_t)RING_BLOCK_SIZE * RING_BLOCK_NR);
+    close(ring_fd);
+    ring_map = NULL;
+    ring_fd = -1;
+    pcap_ring = false;
+}
+
+static bool pcap_ring_start(const char* dev, uint8_t *mac) {
+    struct tpacket_req3 req;
+    struct sockaddr_ll sll;
+    struct packet_mreq mr;
+    int version = TPACKET_V3;
+    int ifindex;
+    
+    ifindex = if_nametoindex(dev);
+    if (ifindex == 0) {
+        return false;
+    }
+    ring_fd = socket(AF_PACKET, SOCK_RAW, htons(ETH_P_ALL));
+    if (ring_fd < 0) {
+        Log_Printf(LOG_WARN, "[PCAP] Ring: Couldn't open packet socket: %s", strerror(errno));
+        return false;
+    }
+    if (setsockopt(ring_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0) {
+        goto error;
+    }
+    
+    memset(&req, 0, sizeof(req));
+    req.tp_block_size = RING_BLOCK_SIZE;
+    req.tp_block_nr = RING_BLOCK_NR;
+    req.tp_frame_size = RING_FRAME_SIZE;
+    req.tp_frame_nr = (RING_BLOCK_SIZE / RING_FRAME_SIZE) * RING_BLOCK_NR;
+    req.tp_retire_blk_tov = RING_BLOCK_TOV;
+    if (setsockopt(ring_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) < 0) {
+        goto error;
+    }
+    ring_map = mmap(NULL, (size_t)RING_BLOCK_SIZE * RING_BLOCK_NR, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_LOCKED, ring_fd, 0);
+    if (ring_map == MAP_FAILED) {
+        ring_map = mmap(NULL, (size_t)RING_BLOCK_SIZE * RING_BLOCK_NR, PROT_READ | PROT_WRITE,
+                        MAP_SHARED, ring_fd, 0);
+    }
+    if (ring_map == MAP_FAILED) {
+        ring_map = NULL;
+        goto error;
+    }
+    
+    memset(&sll, 0, sizeof(sll));
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_ALL);
+    sll.sll_ifindex = ifindex;
+    if (bind(ring_fd, (struct sockaddr*)&sll, sizeof(sll)) < 0) {
+        goto error;
+    }
+    
+    memset(&mr, 0, sizeof(mr));
+    mr.mr_ifindex = ifindex;
+    mr.mr_type = PACKET_MR_PROMISC;
+    if (setsockopt(ring_fd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &mr, sizeof(mr)) < 0) {
+        Log_Printf(LOG_WARN, "[PCAP] Ring: Couldn't set promiscuous mode: %s", strerror(errno));
+    }
+    
+    memcpy(ring_mac, mac, 6);
+    ring_block = 0;
+    ring_pkts_left = 0;
+    pcap_ring = true;
+    Log_Printf(LOG_WARN, "[PCAP] Using TPACKET_V3 receive ring (%d blocks of %d bytes).", RING_BLOCK_NR, RING_BLOCK_SIZE);
+    return true;
+    
+error:
+    Log_Printf(LOG_WARN, "[PCAP] Ring: Setup failed (%s). Falling back to libpcap.", strerror(errno));
+    if (ring_map) {
+        munmap(ring_map, (size_t)RING_BLOCK_SIZE * RING_BLOCK_NR);
+        ring_map = NULL;
+    }
+    close(ring_fd);
+    ring_fd = -1;
+    return false;
+}
+#endif
+
+
 void enet_pcap_queue_poll(void)
 {
+#if PCAP_MMAP_RING
+    if (pcap_ring) {
+        pcap_ring_poll();
+        return;
+    }
+#endif
     if (pcap_started) {
         host_mutex_lock(pcap_mutex);
         if (QueuePeek(pcapq)>0)
@@ -92,6 +271,13 @@ void enet_pcap_queue_poll(void)
 }
 
 void enet_pcap_input(uint8_t *pkt, int pkt_len) {
+#if PCAP_MMAP_RING
+    if (pcap_ring) {
+        Log_Printf(LOG_EN_PCAP_LEVEL, "[PCAP] Input packet with %i bytes",pkt_len);
+        pcap_ring_input(pkt, pkt_len);
+        return;
+    }
+#endif
     if (pcap_started) {
         Log_Printf(LOG_EN_PCAP_LEVEL, "[PCAP] Input packet with %i bytes",enet_tx_buffer.size);
         host_mutex_lock(pcap_mutex);
@@ -103,6 +289,13 @@ void enet_pcap_input(uint8_t *pkt, int pkt_len) {
 }
 
 void enet_pcap_stop(void) {
+#if PCAP_MMAP_RING
+    if (pcap_ring) {
+        Log_Printf(LOG_WARN, "Stopping PCAP");
+        pcap_ring_stop();
+        return;
+    }
+#endif
     if (pcap_started) {
         Log_Printf(LOG_WARN, "Stopping PCAP");
         pcap_started=0;
@@ -129,6 +322,11 @@ void enet_pcap_start(uint8_t *mac) {
     bpf_u_int32 net = 0xffffffff;
 
     if (!pcap_started) {
+#if PCAP_MMAP_RING
+        if (pcap_ring) {
+            return;
+        }
+#endif
         Log_Printf(LOG_WARN, "Starting PCAP (%02x:%02x:%02x:%02x:%02x:%02x)",
                    mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]);
         
@@ -143,6 +341,11 @@ void enet_pcap_start(uint8_t *mac) {
         }
         Log_Printf(LOG_WARN, "Device: %s", dev);
         
+#if PCAP_MMAP_RING
+        if (pcap_ring_start(dev, mac)) {
+            return;
+        }
+#endif
         pcap_handle = pcap_open_live(dev, 1518, 1, 1, errbuf);
         
         if (pcap_handle == NULL) {
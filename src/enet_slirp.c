@@ -15,6 +15,7 @@ const char Enet_slirp_fileid[] = "Previous enet_slirp.c";
 #include "queue.h"
 #include "timing.h"
 #include "host.h"
+#include "hostprof.h"
 #include "libslirp.h"
 #include "rpc/rpc.h"
 
@@ -77,9 +78,11 @@ static void slirp_tick(void)
         
         ret2 = select(nfds + 1, &rfds, &wfds, &xfds, &tv);
         if(ret2>=0){
+            uint16_t tags = HostProf_Enter(HOSTPROF_SLIRP);
             host_mutex_lock(slirp_mutex);
             slirp_select_poll(&rfds, &wfds, &xfds);
             host_mutex_unlock(slirp_mutex);
+            HostProf_Leave(tags);
         }
     }
 }
@@ -107,6 +110,8 @@ static int tick_func(void *arg)
     uint64_t last_time = 0;
     uint64_t next_time = time + SLIRP_RIP_SEC;
 
+    HostProf_SetThread("slirp");
+
     while (slirp_started)
     {
         host_sleep_us(SLIRP_TICK_US);
@@ -0,0 +1,152 @@
+/*
+  Previous - enet_tap.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Send and receive Ethernet packets using a Linux TAP device.
+*/
+const char Enet_tap_fileid[] = "Previous enet_tap.c";
+
+#include "main.h"
+
+#if HAVE_LINUX_IF_TUN_H
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <sys/uio.h>
+#include <net/if.h>
+#include <linux/if_tun.h>
+
+#include "configuration.h"
+#include "log.h"
+#include "ethernet.h"
+#include "enet_tap.h"
+
+#define LOG_EN_TAP_LEVEL LOG_DEBUG
+
+/***************/
+/* --- TAP --- */
+
+#define TAP_DEVICE          "/dev/net/tun"
+#define TAP_DEFAULT_NAME    "tap0"
+#define TAP_FRAMESIZE_MIN   60      /* without CRC */
+#define TAP_FRAMESIZE_MAX   1518
+#define TAP_READ_BATCH      32      /* maximum number of frames to inspect per poll */
+
+static int tap_fd = -1;
+static int tap_started;
+static uint8_t tap_mac[6];
+static uint8_t tap_buf[TAP_FRAMESIZE_MAX];
+static uint8_t tap_pad[TAP_FRAMESIZE_MIN];
+
+
+/* The kernel delivers every frame seen on the bridge to the TAP device. *
+ * Drop frames that are neither broadcast, multicast nor addressed to us *
+ * before handing them to the emulated controller.                       */
+static bool tap_frame_for_me(const uint8_t *pkt) {
+    if (pkt[0]&0x01) { /* broadcast or multicast */
+        return true;
+    }
+    return memcmp(pkt, tap_mac, 6) == 0;
+}
+
+/* This function is called from the ethernet controller's receive state *
+ * when it is ready for a new frame. The TAP device is non-blocking, so  *
+ * frames are taken straight from the kernel queue without a helper      *
+ * thread or an intermediate packet queue.                               */
+void enet_tap_queue_poll(void)
+{
+    ssize_t len;
+    int i;
+
+    if (tap_started) {
+        for (i = 0; i < TAP_READ_BATCH; i++) {
+            len = read(tap_fd, tap_buf, sizeof(tap_buf));
+            if (len < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    Log_Printf(LOG_WARN, "[TAP] Error: Couldn't receive packet: %s", strerror(errno));
+                }
+                return;
+            }
+            if (len < 14 || !tap_frame_for_me(tap_buf)) {
+                continue;
+            }
+            Log_Printf(LOG_EN_TAP_LEVEL, "[TAP] Output packet with %i bytes", (int)len);
+            enet_receive(tap_buf, (int)len);
+            return;
+        }
+    }
+}
+
+void enet_tap_input(uint8_t *pkt, int pkt_len) {
+    struct iovec iov[2];
+    int iovcnt = 1;
+
+    if (tap_started) {
+        Log_Printf(LOG_EN_TAP_LEVEL, "[TAP] Input packet with %i bytes", pkt_len);
+
+        /* Pad short frames without copying them */
+        iov[0].iov_base = pkt;
+        iov[0].iov_len  = pkt_len;
+        if (pkt_len < TAP_FRAMESIZE_MIN) {
+            iov[1].iov_base = tap_pad;
+            iov[1].iov_len  = TAP_FRAMESIZE_MIN - pkt_len;
+            iovcnt = 2;
+        }
+        if (writev(tap_fd, iov, iovcnt) < 0) {
+            Log_Printf(LOG_WARN, "[TAP] Error: Couldn't transmit packet: %s", strerror(errno));
+        }
+    }
+}
+
+void enet_tap_stop(void) {
+    if (tap_started) {
+        Log_Printf(LOG_WARN, "Stopping TAP");
+        tap_started = 0;
+        close(tap_fd);
+        tap_fd = -1;
+    }
+}
+
+void enet_tap_uninit(void) {
+    enet_tap_stop();
+}
+
+void enet_tap_start(uint8_t *mac) {
+    struct ifreq ifr;
+    const char *dev;
+
+    if (!tap_started) {
+        Log_Printf(LOG_WARN, "Starting TAP (%02x:%02x:%02x:%02x:%02x:%02x)",
+                   mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]);
+
+        dev = ConfigureParams.Ethernet.szInterfaceName;
+        if (dev[0] == '\0') {
+            dev = TAP_DEFAULT_NAME;
+        }
+        Log_Printf(LOG_WARN, "Device: %s", dev);
+
+        tap_fd = open(TAP_DEVICE, O_RDWR | O_NONBLOCK);
+        if (tap_fd < 0) {
+            Log_Printf(LOG_WARN, "[TAP] Error: Couldn't open %s: %s", TAP_DEVICE, strerror(errno));
+            return;
+        }
+
+        memset(&ifr, 0, sizeof(ifr));
+        ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+        snprintf(ifr.ifr_name, IFNAMSIZ, "%s", dev);
+
+        if (ioctl(tap_fd, TUNSETIFF, &ifr) < 0) {
+            Log_Printf(LOG_WARN, "[TAP] Error: Couldn't attach to device %s: %s", dev, strerror(errno));
+            close(tap_fd);
+            tap_fd = -1;
+            return;
+        }
+
+        memcpy(tap_mac, mac, 6);
+        tap_started = 1;
+    }
+}
+#endif
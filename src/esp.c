@@ -16,6 +16,7 @@ const char Esp_fileid[] = "Previous esp.c";
 #include "sysReg.h"
 #include "dma.h"
 #include "scsi.h"
+#include "memorySnapShot.h"
 
 #define LOG_ESPDMA_LEVEL    LOG_DEBUG   /* Print debugging messages for ESP DMA registers */
 #define LOG_ESPCMD_LEVEL    LOG_DEBUG   /* Print debugging messages for ESP commands */
@@ -982,3 +983,27 @@ void ESP_Reset(void) {
     Log_Printf(LOG_WARN, "[ESP] Reset");
     esp_reset_hard();
 }
+
+void ESP_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&esp_dma, sizeof(esp_dma));
+    MemorySnapShot_Store(&esp_state, sizeof(esp_state));
+    MemorySnapShot_Store(&esp_io_state, sizeof(esp_io_state));
+    MemorySnapShot_Store(&esp_cmd_state, sizeof(esp_cmd_state));
+    MemorySnapShot_Store(&writetranscountl, sizeof(writetranscountl));
+    MemorySnapShot_Store(&writetranscounth, sizeof(writetranscounth));
+    MemorySnapShot_Store(fifo, sizeof(fifo));
+    MemorySnapShot_Store(command, sizeof(command));
+    MemorySnapShot_Store(&status, sizeof(status));
+    MemorySnapShot_Store(&selectbusid, sizeof(selectbusid));
+    MemorySnapShot_Store(&intstatus, sizeof(intstatus));
+    MemorySnapShot_Store(&selecttimeout, sizeof(selecttimeout));
+    MemorySnapShot_Store(&seqstep, sizeof(seqstep));
+    MemorySnapShot_Store(&syncperiod, sizeof(syncperiod));
+    MemorySnapShot_Store(&fifoflags, sizeof(fifoflags));
+    MemorySnapShot_Store(&syncoffset, sizeof(syncoffset));
+    MemorySnapShot_Store(&configuration, sizeof(configuration));
+    MemorySnapShot_Store(&clockconv, sizeof(clockconv));
+    MemorySnapShot_Store(&esptest, sizeof(esptest));
+    MemorySnapShot_Store(&esp_counter, sizeof(esp_counter));
+    MemorySnapShot_Store(&mode_dma, sizeof(mode_dma));
+}
@@ -19,8 +19,12 @@ const char Ethernet_fileid[] = "Previous ethernet.c";
 #include "ethernet.h"
 #include "enet_slirp.h"
 #include "enet_pcap.h"
+#include "enet_tap.h"
+#include "enet_capture.h"
 #include "cycInt.h"
 #include "statusbar.h"
+#include "memorySnapShot.h"
+#include "replay.h"
 
 #define LOG_EN_LEVEL        LOG_DEBUG
 #define LOG_EN_REG_LEVEL    LOG_DEBUG
@@ -97,6 +101,8 @@ static void (*enet_uninit)(void);
 
 void print_packet(uint8_t *pkt, int len, int out);
 
+static bool enet_from_host; /* enet_receive() is called from host interface */
+
 
 /* Interrupt functions */
 static void enet_tx_check_interrupt(void) {
@@ -416,8 +422,14 @@ static bool enet_packet_for_me(uint8_t *packet) {
 }
 
 void enet_receive(uint8_t *pkt, int len) {
+    if (enet_from_host) {
+        Replay_Record(REPLAY_ENET_FRAME, pkt, len);
+    }
     if (enet_packet_for_me(pkt)) {
         print_packet(pkt, len, 0);
+        if (enet_capture_enabled) {
+            enet_capture_packet(pkt, len, false);
+        }
         memcpy(enet_rx_buffer.data,pkt,len);
         len += 4; /* Checksum */
         if (len < ENET_FRAMESIZE_MIN) { /* Hack for short packets from SLIRP */
@@ -432,13 +444,18 @@ void enet_receive(uint8_t *pkt, int len) {
 
 static void enet_send(uint8_t *pkt, int len) {
     print_packet(pkt, len, 1);
+    if (enet_capture_enabled) {
+        enet_capture_packet(pkt, len, true);
+    }
     if (en_state == EN_LOOPBACK) {
         /* Loop back */
         Log_Printf(LOG_WARN, "[EN] Loopback packet.");
         enet_receive(pkt, len);
     } else {
-        /* Send to real world network */
-        enet_input(pkt, len);
+        /* Send to real world network, replays use recorded answers */
+        if (nReplayMode != REPLAY_PLAY) {
+            enet_input(pkt, len);
+        }
         /* Simultaneously receive packet on thin ethernet */
         if (en_state == EN_THINWIRE) {
             enet_receive(pkt, len);
@@ -447,6 +464,25 @@ static void enet_send(uint8_t *pkt, int len) {
 }
 
 
+/* Receive from real world network. During replay frames recorded at
+ * the same cycle are received instead. */
+static void enet_receive_host(void) {
+    static uint8_t pkt[EN_BUF_MAX];
+    int len;
+    
+    if (nReplayMode == REPLAY_PLAY) {
+        len = Replay_Fetch(REPLAY_ENET_FRAME, pkt, sizeof(pkt));
+        if (len > 0) {
+            enet_receive(pkt, len);
+        }
+        return;
+    }
+    enet_from_host = true;
+    enet_output();
+    enet_from_host = false;
+}
+
+
 /* Fujitsu ethernet controller */
 static int enet_state(void) {
     if (ConfigureParams.System.nMachineType == NEXT_CUBE030) {
@@ -500,7 +536,7 @@ static void enet_io(void) {
                     receiver_state = RECV_STATE_RECEIVING;
             } else if (en_state == EN_THINWIRE || en_state == EN_TWISTEDPAIR) {
                 /* Receive from real world network */
-                enet_output();
+                enet_receive_host();
                 break;
             } else
                 break;
@@ -664,7 +700,7 @@ static void new_enet_io(void) {
                     receiver_state = RECV_STATE_RECEIVING;
             } else if (en_state == EN_THINWIRE || en_state == EN_TWISTEDPAIR) {
                 /* Receive from real world network */
-                enet_output();
+                enet_receive_host();
                 break;
             } else
                 break;
@@ -728,7 +764,7 @@ static void new_enet_io(void) {
 void Ethernet_IO_Handler(void) {
     if (enet.reset&EN_RESET) {
         Log_Printf(LOG_WARN, "Stopping Ethernet Transmitter/Receiver");
-        /* Stop SLIRP/PCAP */
+        /* Stop SLIRP/PCAP/TAP */
         if (ConfigureParams.Ethernet.bEthernetConnected) {
             enet_stop();
         }
@@ -748,7 +784,7 @@ void enet_reset(void) {
     if (enet.reset&EN_RESET) {
         enet.tx_status=ConfigureParams.System.bTurbo?0:TXSTAT_READY;
     } else {
-        /* Start SLIRP/PCAP */
+        /* Start SLIRP/PCAP/TAP */
         if (ConfigureParams.Ethernet.bEthernetConnected) {
             enet_start(enet.mac_addr);
         }
@@ -771,12 +807,21 @@ void Ethernet_Reset(bool hard) {
     }
     
     if (init_done) {
-        /* Stop SLIRP/PCAP */
+        /* Stop SLIRP/PCAP/TAP */
         enet_stop();
         if (hard) {
             enet_uninit();
         }
     }
+#if HAVE_LINUX_IF_TUN_H
+    if (ConfigureParams.Ethernet.nHostInterface == ENET_TAP) {
+        enet_output = enet_tap_queue_poll;
+        enet_input  = enet_tap_input;
+        enet_start  = enet_tap_start;
+        enet_stop   = enet_tap_stop;
+        enet_uninit = enet_tap_uninit;
+    } else
+#endif
 #if HAVE_PCAP
     if (ConfigureParams.Ethernet.nHostInterface == ENET_PCAP) {
         enet_output = enet_pcap_queue_poll;
@@ -798,7 +843,26 @@ void Ethernet_Reset(bool hard) {
     enet_reset();
 }
 
+/* Save/Restore snapshot of Ethernet controller. Host connections are not
+ * saved, the host interface is restarted for the restored controller. */
+void Ethernet_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&enet, sizeof(enet));
+    MemorySnapShot_Store(&enet_tx_buffer, sizeof(enet_tx_buffer));
+    MemorySnapShot_Store(&enet_rx_buffer, sizeof(enet_rx_buffer));
+    MemorySnapShot_Store(&receiver_state, sizeof(receiver_state));
+    MemorySnapShot_Store(&tx_done, sizeof(tx_done));
+    MemorySnapShot_Store(&rx_chain, sizeof(rx_chain));
+    MemorySnapShot_Store(&old_size, sizeof(old_size));
+    MemorySnapShot_Store(&en_state, sizeof(en_state));
+    MemorySnapShot_Store(&saved_nibble, sizeof(saved_nibble));
+    
+    if (!bSave) {
+        enet_reset();
+    }
+}
+
 void Ethernet_UnInit(void) {
+    enet_capture_stop();
     if (enet_uninit) {
         enet_uninit();
     }
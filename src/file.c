@@ -29,6 +29,7 @@ const char File_fileid[] = "Hatari file.c";
 #include "file.h"
 #include "str.h"
 #include "file_archive.h"
+#include "hostprof.h"
 
 #ifdef HAVE_FLOCK
 # include <sys/file.h>
@@ -791,21 +792,28 @@ void File_UnLock(FILE *fp)
  */
 bool File_Read(uint8_t *data, uint32_t size, off_t offset, FILE *fp)
 {
+	uint16_t tags;
+	bool ok = false;
+
 	if (!fp || !data)
 	{
 		return false;
 	}
+	tags = HostProf_Enter(HOSTPROF_FILE);
 	if (fseeko(fp, offset, SEEK_SET))
 	{
 		fprintf(stderr, "File seek failed:\n  %s\n", strerror(errno));
-		return false;
 	}
-	if (fread(data, size, 1, fp) != 1)
+	else if (fread(data, size, 1, fp) != 1)
 	{
 		fprintf(stderr, "Error occured while reading file.\n");
-		return false;
 	}
-	return true;
+	else
+	{
+		ok = true;
+	}
+	HostProf_Leave(tags);
+	return ok;
 }
 
 
@@ -815,21 +823,28 @@ bool File_Read(uint8_t *data, uint32_t size, off_t offset, FILE *fp)
  */
 bool File_Write(uint8_t *data, uint32_t size, off_t offset, FILE *fp)
 {
+	uint16_t tags;
+	bool ok = false;
+
 	if (!fp || !data)
 	{
 		return false;
 	}
+	tags = HostProf_Enter(HOSTPROF_FILE);
 	if (fseeko(fp, offset, SEEK_SET))
 	{
 		fprintf(stderr, "File seek failed:\n  %s\n", strerror(errno));
-		return false;
 	}
-	if (fwrite(data, size, 1, fp) != 1)
+	else if (fwrite(data, size, 1, fp) != 1)
 	{
 		fprintf(stderr, "Error occured while writing file.\n");
-		return false;
 	}
-	return true;
+	else
+	{
+		ok = true;
+	}
+	HostProf_Leave(tags);
+	return ok;
 }
 
 
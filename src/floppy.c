@@ -18,6 +18,7 @@ const char Floppy_fileid[] = "Previous floppy.c";
 #include "cycInt.h"
 #include "file.h"
 #include "statusbar.h"
+#include "memorySnapShot.h"
 
 #define LOG_FLP_REG_LEVEL   LOG_DEBUG
 #define LOG_FLP_CMD_LEVEL   LOG_DEBUG
@@ -1200,6 +1201,29 @@ void Floppy_Reset(void) {
     Floppy_Init();
 }
 
+void Floppy_MemorySnapShot_Capture(bool bSave) {
+    int i;
+    FILE* dsk;
+    
+    MemorySnapShot_Store(&flp, sizeof(flp));
+    for (i = 0; i < FLP_MAX_DRIVES; i++) {
+        dsk = flpdrv[i].dsk;
+        MemorySnapShot_Store(&flpdrv[i], sizeof(flpdrv[i]));
+        flpdrv[i].dsk = dsk;
+    }
+    MemorySnapShot_Store(&flp_buffer, sizeof(flp_buffer));
+    MemorySnapShot_Store(&floppy_select, sizeof(floppy_select));
+    MemorySnapShot_Store(&flp_sector_counter, sizeof(flp_sector_counter));
+    MemorySnapShot_Store(&flp_io_drv, sizeof(flp_io_drv));
+    MemorySnapShot_Store(&flp_io_state, sizeof(flp_io_state));
+    MemorySnapShot_Store(&cmd_phase, sizeof(cmd_phase));
+    MemorySnapShot_Store(&cmd_size, sizeof(cmd_size));
+    MemorySnapShot_Store(&cmd_limit, sizeof(cmd_limit));
+    MemorySnapShot_Store(&command, sizeof(command));
+    MemorySnapShot_Store(cmd_data, sizeof(cmd_data));
+    MemorySnapShot_Store(&result_size, sizeof(result_size));
+}
+
 void set_floppy_select(uint8_t sel, bool osp) {
     if (sel) {
         Log_Printf(LOG_DEBUG,"[%s] Selecting floppy controller",osp?"OSP":"Floppy");
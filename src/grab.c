@@ -4,7 +4,7 @@
   This file is distributed under the GNU General Public License, version 2
   or at your option any later version. Read the file gpl.txt for details.
 
-  Grab video or sound output and save it to a PNG or AIFF file.
+  Grab video or sound output and save it to a PNG, AIFF, FLAC or AVI file.
 */
 const char Grab_fileid[] = "Previous grab.c";
 
@@ -18,6 +18,7 @@ const char Grab_fileid[] = "Previous grab.c";
 #include "m68000.h"
 #include "host.h"
 #include "screen.h"
+#include "video.h"
 #include "grab.h"
 
 #if HAVE_LIBPNG
@@ -38,6 +39,7 @@ struct grab_format {
 	int alpha;
 	int depth;
 	int print;
+	int level;
 };
 
 #if HAVE_LIBPNG
@@ -92,6 +94,11 @@ static bool Grab_MakePNG(FILE* fp, uint8_t* src_ptr, struct grab_format* format)
 					/* initialize the png structure */
 					png_init_io(png_ptr, fp);
 					
+					/* compression level, if not default */
+					if (format->level >= 0) {
+						png_set_compression_level(png_ptr, format->level);
+					}
+					
 					/* image data properties */
 					png_set_IHDR(png_ptr, info_ptr, format->w, format->h, format->depth, color_type,
 					             PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
@@ -402,35 +409,174 @@ static char* Grab_GetPath(const char* szName, int nCount, int nDigits) {
 }
 
 /**
- * Open file and save image data to it.
+ * Image files are encoded on worker threads. The caller opens the file
+ * and hands over the image buffer, so that saving screenshots and printed
+ * pages does not stall the emulation. Files are opened in order by the
+ * caller, so that concurrent workers never pick the same file name.
+ */
+#define GRAB_MAX_WORKERS 4
+
+struct grab_job {
+	FILE*    fp;
+	uint8_t* buf;
+	bool     png;
+	struct grab_format format;
+	struct grab_job*   next;
+};
+
+static lock_t           GrabJobLock;           /* Protect job queue */
+static lock_t           GrabWorkerLock;        /* Protect starting and stopping workers */
+static struct grab_job* GrabJobHead;
+static struct grab_job* GrabJobTail;
+static semaphore_t*     GrabJobSignal;
+static thread_t*        GrabWorker[GRAB_MAX_WORKERS];
+static int              GrabWorkers;
+static atomic_int       GrabWorkerQuit;
+
+/**
+ * Write image data to file and close it.
+ */
+static void Grab_WriteFile(struct grab_job* job) {
+	bool result;
+	
+#if HAVE_LIBPNG
+	if (job->png) {
+		result = Grab_MakePNG(job->fp, job->buf, &job->format);
+	} else
+#endif
+	{
+		result = Grab_MakeTIFF(job->fp, job->buf, &job->format);
+	}
+	if (result == false) {
+		Log_Printf(LOG_WARN, "[Grab] Error: Could not create image file");
+	}
+	File_Close(job->fp);
+}
+
+/**
+ * Worker thread. Runs until stopped and the queue is empty.
+ */
+static int Grab_WorkerThread(void* data) {
+	struct grab_job* job;
+	
+	while (true) {
+		host_semaphore_wait_timeout(GrabJobSignal, -1);
+		
+		host_lock(&GrabJobLock);
+		job = GrabJobHead;
+		if (job) {
+			GrabJobHead = job->next;
+			if (!GrabJobHead) {
+				GrabJobTail = NULL;
+			}
+		}
+		host_unlock(&GrabJobLock);
+		
+		if (job) {
+			Grab_WriteFile(job);
+			free(job->buf);
+			free(job);
+		} else if (host_atomic_get(&GrabWorkerQuit)) {
+			break;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Start worker threads. Leave one CPU for the emulation.
+ */
+static void Grab_StartWorkers(void) {
+	int i;
+	
+	GrabWorkers = host_num_cpus() - 1;
+	if (GrabWorkers < 1) {
+		GrabWorkers = 1;
+	} else if (GrabWorkers > GRAB_MAX_WORKERS) {
+		GrabWorkers = GRAB_MAX_WORKERS;
+	}
+	host_atomic_set(&GrabWorkerQuit, 0);
+	GrabJobSignal = host_semaphore_create(0);
+	for (i = 0; i < GrabWorkers; i++) {
+		GrabWorker[i] = host_thread_create(Grab_WorkerThread, "GrabWorkerThread", NULL);
+	}
+}
+
+/**
+ * Wait until all queued files are written and stop worker threads.
+ */
+static void Grab_StopWorkers(void) {
+	int i;
+	
+	host_lock(&GrabWorkerLock);
+	if (GrabWorkers == 0) {
+		host_unlock(&GrabWorkerLock);
+		return;
+	}
+	host_atomic_set(&GrabWorkerQuit, 1);
+	for (i = 0; i < GrabWorkers; i++) {
+		host_semaphore_signal(GrabJobSignal);
+	}
+	for (i = 0; i < GrabWorkers; i++) {
+		host_thread_wait(GrabWorker[i]);
+		GrabWorker[i] = NULL;
+	}
+	host_semaphore_destroy(GrabJobSignal);
+	GrabJobSignal = NULL;
+	GrabWorkers = 0;
+	host_unlock(&GrabWorkerLock);
+}
+
+/**
+ * Open file and queue image data for saving. Takes ownership of buffer.
  */
 static bool Grab_SaveFile(const char* szName, int nCount, int nDigits, uint8_t* buf, struct grab_format* format) {
-	bool result = false;
+	struct grab_job* job;
 	char* szPathName = NULL;
 	FILE* fp = NULL;
 	
 	szPathName = Grab_GetPath(szName, nCount, nDigits);
 	if (szPathName) {
 		fp = File_Open(szPathName, "wb");
-		if (fp) {
-#if HAVE_LIBPNG
-			if (ConfigureParams.Printer.nFileFormat == FORMAT_PNG) {
-				result = Grab_MakePNG(fp, buf, format);
-			} else
-#endif
-			{
-				result = Grab_MakeTIFF(fp, buf, format);
-			}
-			if (result == false) {
-				Log_Printf(LOG_WARN, "[Grab] Error: Could not create image file");
-			}
-			File_Close(fp);
-		} else {
+		if (!fp) {
 			Log_Printf(LOG_WARN, "[Grab] Error: Could not open file %s", szPathName);
 		}
 		free(szPathName);
 	}
-	return result;
+	
+	job = fp ? (struct grab_job*)malloc(sizeof(struct grab_job)) : NULL;
+	if (!job) {
+		File_Close(fp);
+		free(buf);
+		return false;
+	}
+	job->fp     = fp;
+	job->buf    = buf;
+#if HAVE_LIBPNG
+	job->png    = (ConfigureParams.Printer.nFileFormat == FORMAT_PNG);
+#else
+	job->png    = false;
+#endif
+	job->format = *format;
+	job->next   = NULL;
+	
+	/* Screenshots and prints can arrive from different threads */
+	host_lock(&GrabWorkerLock);
+	if (GrabWorkers == 0) {
+		Grab_StartWorkers();
+	}
+	host_lock(&GrabJobLock);
+	if (GrabJobTail) {
+		GrabJobTail->next = job;
+	} else {
+		GrabJobHead = job;
+	}
+	GrabJobTail = job;
+	host_unlock(&GrabJobLock);
+	host_semaphore_signal(GrabJobSignal);
+	host_unlock(&GrabWorkerLock);
+	
+	return true;
 }
 
 /**
@@ -446,6 +592,7 @@ static bool Grab_ScreenFormat(int slot, uint8_t* buf, struct grab_format* format
 	format->h     = screen_h;
 	format->dpi   = 72; /* Better use MegaPixel Display resolution (92 dpi)? */
 	format->print = 0;
+	format->level = -1;
 	
 	if (slot < 0) {
 		int m, xoff, yoff;
@@ -578,8 +725,9 @@ static void Grab_ScreenFromSlot(int slot) {
 			if (Grab_SaveFile("next_screen", 1000, 3, buffer, &format)) {
 				Statusbar_AddMessage("Saving screen to file", 0);
 			}
+		} else {
+			free(buffer);
 		}
-		free(buffer);
 	}
 }
 
@@ -603,7 +751,7 @@ void Grab_Screen(void) {
 }
 
 /**
- * Grab print.
+ * Grab print. Takes ownership of data.
  */
 void Grab_Print(uint8_t* data, int width, int height, int dpi) {
 	if (data) {
@@ -615,11 +763,701 @@ void Grab_Print(uint8_t* data, int width, int height, int dpi) {
 		format.alpha = 0;
 		format.depth = 1;
 		format.print = 1;
+		format.level = -1;
 		Grab_SaveFile("next_print", 1000000, 6, data, &format);
 	}
 }
 
 
+/*
+ AVI file output
+ 
+ Frames are grabbed at every VBL of the recorded display. The emulation
+ thread only copies the raw frame buffer and the sound samples produced
+ since the last frame into one of three ring buffers. A separate encoder
+ thread converts the frames to 24-bit RGB and writes them as PNG (if
+ libpng is available) or as uncompressed bitmaps. If the encoder falls
+ behind and no ring buffer is free, the frame is dropped and an empty
+ chunk is written in its place to keep video and sound in sync. Frames
+ that did not change since the last grab are stored as empty chunks too.
+ 
+ The file is limited to 2 GB, there is no support for OpenDML extensions.
+ 
+ All data is stored in little endian byte order.
+ 
+ RIFF Header           Byte Number
+ 0 - 11    "RIFF", length of file to follow, "AVI "
+ 12 - 23   "LIST", length of header list, "hdrl"
+ 24 - 87   "avih", 56, main AVI header
+ 88 - 99   "LIST", length of video stream list, "strl"
+ 100 - 163 "strh", 56, video stream header
+ 164 - 211 "strf", 40, bitmap info header
+ 212 - 223 "LIST", length of sound stream list, "strl"
+ 224 - 287 "strh", 56, sound stream header
+ 288 - 311 "strf", 16, wave format
+ 312 - 323 "LIST", length of movie data, "movi"
+ 324 - end "00dc" and "01wb" chunks, followed by "idx1" index chunk
+ */
+
+#define VIDEO_RING_SIZE   3                    /* Triple buffered frames */
+#define VIDEO_AUDIO_SIZE  (44100 * 4)          /* Up to one second of sound per frame */
+#define VIDEO_MAX_SIZE    0x7FF00000           /* Stay below 2 GB */
+#define VIDEO_MOVI_POS    320                  /* Index offsets are relative to "movi" */
+#define VIDEO_HEADER_SIZE 324
+
+enum {
+	VIDEO_MONO,
+	VIDEO_COLOR,
+	VIDEO_DIMENSION,
+	VIDEO_BLANK,
+	VIDEO_REPEAT
+};
+
+struct video_frame {
+	int      type;                             /* Frame type */
+	int      dropped;                          /* Frames dropped before this one */
+	uint8_t* vram;                             /* Copy of frame buffer */
+	uint8_t* audio;                            /* Sound samples (big endian) */
+	int      audio_len;
+};
+
+struct video_index {
+	uint32_t id;
+	uint32_t flags;
+	uint32_t offset;
+	uint32_t size;
+};
+
+static lock_t       GrabVideoLock;             /* Protect ring buffer and sound buffer */
+static thread_t*    VideoThread;
+static semaphore_t* VideoSignal;
+static atomic_int   VideoFilled;               /* Number of frames waiting for encoder */
+static atomic_int   VideoQuit;
+static atomic_int   VideoFrames;               /* Frames encoded since last report */
+static atomic_int   VideoDropped;              /* Frames dropped since last report */
+
+static struct video_frame VideoRing[VIDEO_RING_SIZE];
+static int      VideoWrite;                    /* Ring position of emulation thread */
+static int      VideoRead;                     /* Ring position of encoder thread */
+static int      VideoSlot;                     /* Recorded display */
+static int      VideoType;
+static int      VideoPitch;                    /* Frame buffer line length */
+static int      VideoSize;                     /* Frame buffer size */
+static bool     VideoValid;                    /* Last grabbed frame state */
+static bool     VideoEnabled;
+static uint32_t VideoGeneration;
+static int      VideoPending;                  /* Frames dropped since last grab */
+static int      VideoLost;                     /* Frames dropped since start */
+static uint8_t* VideoAudio;                    /* Sound samples since last grab */
+static int      VideoAudioLen;
+static int      VideoAudioLost;
+
+static FILE*    VideoFileHndl;                 /* Pointer to our AVI file, owned by encoder */
+static uint8_t* VideoPixels;                   /* Converted frame */
+static uint32_t VideoPos;                      /* Current file position */
+static uint32_t VideoFrameCount;
+static uint32_t VideoAudioBytes;
+static uint32_t VideoMaxChunk;
+static bool     VideoFull;
+static struct video_index* VideoIndex;
+static uint32_t VideoIndexCount;
+static uint32_t VideoIndexSize;
+
+volatile bool bRecordingVideo = false;         /* Is an AVI file open and recording? */
+
+
+static void avi_put16(uint8_t* p, uint16_t val) {
+	p[0] = val;
+	p[1] = val >> 8;
+}
+
+static void avi_put32(uint8_t* p, uint32_t val) {
+	p[0] = val;
+	p[1] = val >> 8;
+	p[2] = val >> 16;
+	p[3] = val >> 24;
+}
+
+static void avi_put4cc(uint8_t* p, const char* id) {
+	memcpy(p, id, 4);
+}
+
+static uint32_t avi_4cc(const char* id) {
+	return id[0] | (id[1] << 8) | (id[2] << 16) | ((uint32_t)id[3] << 24);
+}
+
+static void avi_chunk(uint8_t* p, const char* id, uint32_t size) {
+	avi_put4cc(p, id);
+	avi_put32(p + 4, size);
+}
+
+static void avi_list(uint8_t* p, uint32_t size, const char* type) {
+	avi_chunk(p, "LIST", size);
+	avi_put4cc(p + 8, type);
+}
+
+/**
+ * Build AVI header. Called when opening and again when closing the file.
+ */
+static void Grab_MakeAVIHeader(uint8_t* hdr, uint32_t movi_end) {
+	uint32_t usec = 1000000 / NEXT_VBL_FREQ;
+	uint32_t w    = NeXT_SCRN_W;
+	uint32_t h    = NeXT_SCRN_H;
+	
+	memset(hdr, 0, VIDEO_HEADER_SIZE);
+	
+	avi_chunk(hdr, "RIFF", VideoPos - 8);
+	avi_put4cc(hdr + 8, "AVI ");
+	avi_list(hdr + 12, 292, "hdrl");
+	
+	/* Main header */
+	avi_chunk(hdr + 24, "avih", 56);
+	avi_put32(hdr + 32, usec);                           /* Microseconds per frame */
+	avi_put32(hdr + 36, VideoMaxChunk * NEXT_VBL_FREQ);  /* Maximum bytes per second */
+	avi_put32(hdr + 44, 0x10);                           /* Has index */
+	avi_put32(hdr + 48, VideoFrameCount);                /* Total frames */
+	avi_put32(hdr + 56, 2);                              /* Streams */
+	avi_put32(hdr + 60, VideoMaxChunk);                  /* Suggested buffer size */
+	avi_put32(hdr + 64, w);
+	avi_put32(hdr + 68, h);
+	
+	/* Video stream header */
+	avi_list(hdr + 88, 116, "strl");
+	avi_chunk(hdr + 100, "strh", 56);
+	avi_put4cc(hdr + 108, "vids");
+#if HAVE_LIBPNG
+	avi_put4cc(hdr + 112, "MPNG");
+#else
+	avi_put4cc(hdr + 112, "DIB ");
+#endif
+	avi_put32(hdr + 128, 1);                             /* Scale */
+	avi_put32(hdr + 132, NEXT_VBL_FREQ);                 /* Rate */
+	avi_put32(hdr + 140, VideoFrameCount);               /* Length */
+	avi_put32(hdr + 144, VideoMaxChunk);                 /* Suggested buffer size */
+	avi_put32(hdr + 148, 0xFFFFFFFF);                    /* Default quality */
+	avi_put16(hdr + 160, w);
+	avi_put16(hdr + 162, h);
+	
+	/* Bitmap info header */
+	avi_chunk(hdr + 164, "strf", 40);
+	avi_put32(hdr + 172, 40);
+	avi_put32(hdr + 176, w);
+	avi_put32(hdr + 180, h);
+	avi_put16(hdr + 184, 1);                             /* Planes */
+	avi_put16(hdr + 186, 24);                            /* Bits per pixel */
+#if HAVE_LIBPNG
+	avi_put4cc(hdr + 188, "MPNG");
+#endif
+	avi_put32(hdr + 192, w * h * 3);                     /* Image size */
+	
+	/* Sound stream header */
+	avi_list(hdr + 212, 92, "strl");
+	avi_chunk(hdr + 224, "strh", 56);
+	avi_put4cc(hdr + 232, "auds");
+	avi_put32(hdr + 252, 4);                             /* Scale (block align) */
+	avi_put32(hdr + 256, 44100 * 4);                     /* Rate (bytes per second) */
+	avi_put32(hdr + 264, VideoAudioBytes / 4);           /* Length */
+	avi_put32(hdr + 268, 44100 * 4 / NEXT_VBL_FREQ * 2); /* Suggested buffer size */
+	avi_put32(hdr + 272, 0xFFFFFFFF);                    /* Default quality */
+	avi_put32(hdr + 276, 4);                             /* Sample size */
+	
+	/* Wave format */
+	avi_chunk(hdr + 288, "strf", 16);
+	avi_put16(hdr + 296, 1);                             /* PCM */
+	avi_put16(hdr + 298, 2);                             /* Stereo */
+	avi_put32(hdr + 300, 44100);                         /* Sample rate */
+	avi_put32(hdr + 304, 44100 * 4);                     /* Bytes per second */
+	avi_put16(hdr + 308, 4);                             /* Block align */
+	avi_put16(hdr + 310, 16);                            /* Bits per sample */
+	
+	/* Movie data */
+	avi_list(hdr + 312, movi_end - VIDEO_MOVI_POS, "movi");
+}
+
+/**
+ * Add chunk to index and advance file position.
+ */
+static bool Grab_IndexAVIChunk(const char* id, uint32_t size, bool key) {
+	if (VideoIndexCount == VideoIndexSize) {
+		struct video_index* index;
+		index = (struct video_index*)realloc(VideoIndex, (VideoIndexSize + 4096) * sizeof(struct video_index));
+		if (!index) {
+			return false;
+		}
+		VideoIndex = index;
+		VideoIndexSize += 4096;
+	}
+	VideoIndex[VideoIndexCount].id     = avi_4cc(id);
+	VideoIndex[VideoIndexCount].flags  = key ? 0x10 : 0;
+	VideoIndex[VideoIndexCount].offset = VideoPos - VIDEO_MOVI_POS;
+	VideoIndex[VideoIndexCount].size   = size;
+	VideoIndexCount++;
+	
+	VideoPos += 8 + size + (size & 1);
+	if (size > VideoMaxChunk) {
+		VideoMaxChunk = size;
+	}
+	return true;
+}
+
+/**
+ * Write chunk to AVI file. Chunk data is padded to even length.
+ */
+static bool Grab_WriteAVIChunk(const char* id, uint8_t* data, uint32_t size, bool key) {
+	uint8_t header[8];
+	uint8_t pad = 0;
+	
+	avi_chunk(header, id, size);
+	if (!File_Write(header, sizeof(header), VideoPos, VideoFileHndl)) {
+		return false;
+	}
+	if (size > 0 && fwrite(data, size, 1, VideoFileHndl) != 1) {
+		return false;
+	}
+	if ((size & 1) && fwrite(&pad, 1, 1, VideoFileHndl) != 1) {
+		return false;
+	}
+	return Grab_IndexAVIChunk(id, size, key);
+}
+
+#if HAVE_LIBPNG
+/**
+ * Write PNG compressed frame to AVI file. The image is written first,
+ * the chunk header is written when its size is known.
+ */
+static bool Grab_WriteAVIChunkPNG(uint8_t* pixels) {
+	struct grab_format format;
+	uint8_t  header[8];
+	uint8_t  pad = 0;
+	uint32_t size;
+	off_t    end;
+	
+	format.w     = NeXT_SCRN_W;
+	format.h     = NeXT_SCRN_H;
+	format.dpi   = 72;
+	format.rgb   = 1;
+	format.alpha = 0;
+	format.depth = 8;
+	format.print = 0;
+	format.level = 1; /* Favour speed over size */
+	
+	if (fseeko(VideoFileHndl, VideoPos + 8, SEEK_SET)) {
+		return false;
+	}
+	if (!Grab_MakePNG(VideoFileHndl, pixels, &format)) {
+		return false;
+	}
+	end  = ftello(VideoFileHndl);
+	size = (uint32_t)(end - (VideoPos + 8));
+	
+	avi_chunk(header, "00dc", size);
+	if (!File_Write(header, sizeof(header), VideoPos, VideoFileHndl)) {
+		return false;
+	}
+	if ((size & 1) && !File_Write(&pad, 1, end, VideoFileHndl)) {
+		return false;
+	}
+	return Grab_IndexAVIChunk("00dc", size, true);
+}
+#endif
+
+/**
+ * Convert frame to 24-bit pixels. Bitmaps are stored bottom-up in BGR order.
+ */
+static void Grab_ConvertVideoFrame(struct video_frame* frame, uint8_t* dst) {
+	uint8_t* src;
+	int x, y;
+#if HAVE_LIBPNG
+	const int r = 0, b = 2, bottom_up = 0;
+#else
+	const int r = 2, b = 0, bottom_up = 1;
+#endif
+	
+	if (frame->type == VIDEO_BLANK) {
+		memset(dst, 0, NeXT_SCRN_W * NeXT_SCRN_H * 3);
+		return;
+	}
+	for (y = 0; y < NeXT_SCRN_H; y++) {
+		src = frame->vram + (bottom_up ? (NeXT_SCRN_H - 1 - y) : y) * VideoPitch;
+		
+		switch (frame->type) {
+			case VIDEO_DIMENSION:
+				for (x = 0; x < NeXT_SCRN_W; x++, src += 4, dst += 3) {
+					dst[r] = src[2];
+					dst[1] = src[1];
+					dst[b] = src[0];
+				}
+				break;
+			case VIDEO_COLOR:
+				for (x = 0; x < NeXT_SCRN_W; x++, src += 2, dst += 3) {
+					dst[r] = ((src[0] & 0xf0) >> 4) * 0x11;
+					dst[1] = ((src[0] & 0x0f) >> 0) * 0x11;
+					dst[b] = ((src[1] & 0xf0) >> 4) * 0x11;
+				}
+				break;
+			default:
+				for (x = 0; x < NeXT_SCRN_W; x++, dst += 3) {
+					dst[0] = dst[1] = dst[2] = (~(src[x >> 2] >> (6 - 2 * (x & 3))) & 3) * 0x55;
+				}
+				break;
+		}
+	}
+}
+
+/**
+ * Encode one frame and the sound samples belonging to it.
+ */
+static void Grab_EncodeVideoFrame(struct video_frame* frame) {
+	bool ok = true;
+	int  i;
+	
+	if (VideoFull) {
+		return;
+	}
+	if (VideoPos > VIDEO_MAX_SIZE) {
+		Log_Printf(LOG_WARN, "[Grab] Error: Maximum video file size reached");
+		VideoFull = true;
+		return;
+	}
+	
+	/* Empty chunks keep the timing of dropped and unchanged frames */
+	for (i = 0; i < frame->dropped && ok; i++) {
+		ok = Grab_WriteAVIChunk("00dc", NULL, 0, false);
+		VideoFrameCount++;
+	}
+	if (ok) {
+		if (frame->type == VIDEO_REPEAT) {
+			ok = Grab_WriteAVIChunk("00dc", NULL, 0, false);
+		} else {
+			Grab_ConvertVideoFrame(frame, VideoPixels);
+#if HAVE_LIBPNG
+			ok = Grab_WriteAVIChunkPNG(VideoPixels);
+#else
+			ok = Grab_WriteAVIChunk("00dc", VideoPixels, NeXT_SCRN_W * NeXT_SCRN_H * 3, true);
+#endif
+		}
+		VideoFrameCount++;
+	}
+	
+	/* Sound samples are big endian, convert them */
+	if (ok && frame->audio_len > 0) {
+		for (i = 0; i < frame->audio_len - 1; i += 2) {
+			uint8_t tmp = frame->audio[i];
+			frame->audio[i] = frame->audio[i + 1];
+			frame->audio[i + 1] = tmp;
+		}
+		ok = Grab_WriteAVIChunk("01wb", frame->audio, frame->audio_len, true);
+		VideoAudioBytes += frame->audio_len;
+	}
+	
+	if (!ok) {
+		perror("[Grab] Grab_EncodeVideoFrame:");
+		VideoFull = true;
+	}
+}
+
+/**
+ * Write index and final header, then close the AVI file.
+ */
+static void Grab_CloseVideoFile(void) {
+	uint8_t  header[VIDEO_HEADER_SIZE];
+	uint8_t  entry[16];
+	uint32_t movi_end = VideoPos;
+	uint32_t i;
+	bool     ok;
+	
+	avi_chunk(header, "idx1", VideoIndexCount * 16);
+	ok = File_Write(header, 8, VideoPos, VideoFileHndl);
+	for (i = 0; i < VideoIndexCount && ok; i++) {
+		avi_put32(entry + 0,  VideoIndex[i].id);
+		avi_put32(entry + 4,  VideoIndex[i].flags);
+		avi_put32(entry + 8,  VideoIndex[i].offset);
+		avi_put32(entry + 12, VideoIndex[i].size);
+		ok = fwrite(entry, sizeof(entry), 1, VideoFileHndl) == 1;
+	}
+	VideoPos += 8 + VideoIndexCount * 16;
+	
+	Grab_MakeAVIHeader(header, movi_end);
+	if (!ok || !File_Write(header, sizeof(header), 0, VideoFileHndl)) {
+		perror("[Grab] Grab_CloseVideoFile:");
+	}
+	VideoFileHndl = File_Close(VideoFileHndl);
+	
+	free(VideoIndex);
+	VideoIndex      = NULL;
+	VideoIndexCount = 0;
+	VideoIndexSize  = 0;
+}
+
+/**
+ * Encoder thread. Encodes frames until recording stops and the ring is empty.
+ */
+static int Grab_VideoThread(void* data) {
+	while (true) {
+		while (host_atomic_get(&VideoFilled) > 0) {
+			Grab_EncodeVideoFrame(&VideoRing[VideoRead]);
+			VideoRead = (VideoRead + 1) % VIDEO_RING_SIZE;
+			host_atomic_add(&VideoFrames, 1);
+			host_atomic_add(&VideoFilled, -1);
+		}
+		if (host_atomic_get(&VideoQuit)) {
+			break;
+		}
+		host_semaphore_wait_timeout(VideoSignal, 100);
+	}
+	Grab_CloseVideoFile();
+	return 0;
+}
+
+/**
+ * Free ring and conversion buffers.
+ */
+static void Grab_FreeVideoBuffers(void) {
+	int i;
+	
+	for (i = 0; i < VIDEO_RING_SIZE; i++) {
+		free(VideoRing[i].vram);
+		free(VideoRing[i].audio);
+		VideoRing[i].vram  = NULL;
+		VideoRing[i].audio = NULL;
+	}
+	free(VideoAudio);
+	free(VideoPixels);
+	VideoAudio  = NULL;
+	VideoPixels = NULL;
+}
+
+/**
+ * Select recorded display and allocate buffers.
+ */
+static bool Grab_InitVideoBuffers(void) {
+	int i, pad;
+	
+	VideoSlot = (ConfigureParams.Screen.nMode == SCREEN_SINGLE) ? ConfigureParams.Screen.nSingleModeSlot : 0;
+	pad = ConfigureParams.System.bTurbo ? 0 : 32;
+	
+	if (VideoSlot > 0) {
+		if (!nd_vram_for_slot(VideoSlot)) {
+			return false;
+		}
+		VideoType  = VIDEO_DIMENSION;
+		VideoPitch = (NeXT_SCRN_W + 32) * 4;
+	} else if (ConfigureParams.System.bColor) {
+		VideoType  = VIDEO_COLOR;
+		VideoPitch = (NeXT_SCRN_W + pad) * 2;
+	} else {
+		VideoType  = VIDEO_MONO;
+		VideoPitch = (NeXT_SCRN_W + pad) / 4;
+	}
+	VideoSize = VideoPitch * NeXT_SCRN_H;
+	
+	for (i = 0; i < VIDEO_RING_SIZE; i++) {
+		VideoRing[i].vram  = (uint8_t*)malloc(VideoSize);
+		VideoRing[i].audio = (uint8_t*)malloc(VIDEO_AUDIO_SIZE);
+		if (!VideoRing[i].vram || !VideoRing[i].audio) {
+			return false;
+		}
+	}
+	VideoAudio  = (uint8_t*)malloc(VIDEO_AUDIO_SIZE);
+	VideoPixels = (uint8_t*)malloc(NeXT_SCRN_W * NeXT_SCRN_H * 3);
+	
+	return VideoAudio && VideoPixels;
+}
+
+/**
+ * Open AVI output file, write header and start encoder thread.
+ */
+static void Grab_OpenVideoFile(void) {
+	uint8_t header[VIDEO_HEADER_SIZE];
+	char* szPathName = NULL;
+	int i;
+	
+	if (!File_DirExists(ConfigureParams.Printer.szPrintToFileName)) {
+		return;
+	}
+	for (i = 0; i < 1000; i++) {
+		char szFileName[32];
+		snprintf(szFileName, sizeof(szFileName), "next_video_%03d", i);
+		szPathName = File_MakePath(ConfigureParams.Printer.szPrintToFileName, szFileName, "avi");
+		if (!File_Exists(szPathName)) {
+			break;
+		}
+		free(szPathName);
+		szPathName = NULL;
+	}
+	if (!szPathName) {
+		Log_Printf(LOG_WARN, "[Grab] Error: Maximum video grab count exceeded (%d)", i);
+		return;
+	}
+	
+	if (!Grab_InitVideoBuffers()) {
+		Log_Printf(LOG_WARN, "[Grab] Error: Cannot record video from slot %d", VideoSlot);
+		Grab_FreeVideoBuffers();
+		free(szPathName);
+		return;
+	}
+	
+	VideoFileHndl = File_Open(szPathName, "wb");
+	if (!VideoFileHndl) {
+		Log_Printf(LOG_WARN, "[Grab] Failed to create video file %s", szPathName);
+		Grab_FreeVideoBuffers();
+		free(szPathName);
+		return;
+	}
+	free(szPathName);
+	
+	VideoPos        = VIDEO_HEADER_SIZE;
+	VideoFrameCount = 0;
+	VideoAudioBytes = 0;
+	VideoMaxChunk   = 0;
+	VideoFull       = false;
+	Grab_MakeAVIHeader(header, VideoPos);
+	if (!File_Write(header, sizeof(header), 0, VideoFileHndl)) {
+		perror("[Grab] Grab_OpenVideoFile:");
+		VideoFileHndl = File_Close(VideoFileHndl);
+		Grab_FreeVideoBuffers();
+		return;
+	}
+	
+	VideoWrite     = 0;
+	VideoRead      = 0;
+	VideoValid     = false;
+	VideoPending   = 0;
+	VideoLost      = 0;
+	VideoAudioLen  = 0;
+	VideoAudioLost = 0;
+	host_atomic_set(&VideoFilled, 0);
+	host_atomic_set(&VideoQuit, 0);
+	host_atomic_set(&VideoFrames, 0);
+	host_atomic_set(&VideoDropped, 0);
+	
+	if (!VideoSignal) {
+		VideoSignal = host_semaphore_create(0);
+	}
+	VideoThread = host_thread_create(Grab_VideoThread, "GrabVideoThread", NULL);
+	
+	host_lock(&GrabVideoLock);
+	bRecordingVideo = true;
+	host_unlock(&GrabVideoLock);
+	
+	Log_Printf(LOG_WARN, "[Grab] Starting video record");
+	Statusbar_AddMessage("Start saving video to file", 0);
+}
+
+/**
+ * Stop recording, wait for the encoder to finish and close the AVI file.
+ */
+static void Grab_CloseVideo(void) {
+	int dropped;
+	
+	host_lock(&GrabVideoLock);
+	if (!bRecordingVideo) {
+		host_unlock(&GrabVideoLock);
+		return;
+	}
+	bRecordingVideo = false;
+	dropped = VideoLost;
+	host_unlock(&GrabVideoLock);
+	
+	host_atomic_set(&VideoQuit, 1);
+	host_semaphore_signal(VideoSignal);
+	host_thread_wait(VideoThread);
+	VideoThread = NULL;
+	
+	Grab_FreeVideoBuffers();
+	
+	Log_Printf(LOG_WARN, "[Grab] Stopping video record (%d frames, %d dropped, %d sound bytes lost)",
+	           VideoFrameCount, dropped, VideoAudioLost);
+	Statusbar_AddMessage("Stop saving video to file", 0);
+}
+
+/**
+ * Grab frame of recorded display. Called from the emulation thread at
+ * every VBL. This never waits for the encoder.
+ */
+void Grab_VideoFrame(void) {
+	struct video_frame* frame;
+	bool     enabled;
+	uint32_t generation;
+	
+	if (!bRecordingVideo) {
+		return;
+	}
+	host_lock(&GrabVideoLock);
+	if (bRecordingVideo) {
+		if (host_atomic_get(&VideoFilled) < VIDEO_RING_SIZE) {
+			frame = &VideoRing[VideoWrite];
+			
+			if (VideoSlot > 0) {
+				enabled    = nd_video_enabled(VideoSlot);
+				generation = nd_vram_generation(VideoSlot);
+			} else {
+				enabled    = Video_Enabled();
+				generation = NEXTVideoGeneration;
+			}
+			
+			if (VideoValid && VideoEnabled == enabled && (!enabled || VideoGeneration == generation)) {
+				frame->type = VIDEO_REPEAT;
+			} else if (!enabled) {
+				frame->type = VIDEO_BLANK;
+			} else {
+				if (VideoSlot > 0) {
+					memcpy(frame->vram, (uint8_t*)nd_vram_for_slot(VideoSlot) + ND_OFFSET, VideoSize);
+				} else {
+					memcpy(frame->vram, NEXTVideo, VideoSize);
+				}
+				frame->type = VideoType;
+			}
+			VideoValid      = true;
+			VideoEnabled    = enabled;
+			VideoGeneration = generation;
+			
+			frame->dropped   = VideoPending;
+			frame->audio_len = VideoAudioLen;
+			memcpy(frame->audio, VideoAudio, VideoAudioLen);
+			VideoPending  = 0;
+			VideoAudioLen = 0;
+			
+			VideoWrite = (VideoWrite + 1) % VIDEO_RING_SIZE;
+			host_atomic_add(&VideoFilled, 1);
+			host_semaphore_signal(VideoSignal);
+		} else {
+			/* Encoder is busy, drop this frame */
+			VideoPending++;
+			VideoLost++;
+			host_atomic_add(&VideoDropped, 1);
+		}
+	}
+	host_unlock(&GrabVideoLock);
+}
+
+/**
+ * Collect sound samples for the next frame.
+ */
+static void Grab_VideoSound(uint8_t* samples, int len) {
+	host_lock(&GrabVideoLock);
+	if (bRecordingVideo) {
+		if (len > VIDEO_AUDIO_SIZE - VideoAudioLen) {
+			VideoAudioLost += len - (VIDEO_AUDIO_SIZE - VideoAudioLen);
+			len = VIDEO_AUDIO_SIZE - VideoAudioLen;
+		}
+		memcpy(VideoAudio + VideoAudioLen, samples, len);
+		VideoAudioLen += len;
+	}
+	host_unlock(&GrabVideoLock);
+}
+
+/**
+ * Start/Stop recording video.
+ */
+void Grab_VideoToggle(void) {
+	if (bRecordingVideo) {
+		Grab_CloseVideo();
+	} else {
+		Grab_OpenVideoFile();
+	}
+}
+
 /*
  AIFF file output
  
@@ -650,11 +1488,35 @@ void Grab_Print(uint8_t* data, int width, int height, int dpi) {
  16 - end Data (Samples)
  */
 
-static lock_t GrabSoundLock;               /* Protect AIFF file and variables */
+/*
+ Sound samples are passed from the emulation thread to a writer thread
+ through a single producer, single consumer ring. The writer collects
+ samples until a batch is complete or a timeout expires and writes them
+ with one call. Headers with sizes are patched when the file is closed.
+ 
+ Samples can be saved as AIFF (see above), FLAC or raw 16-bit big endian
+ stereo PCM.
+ */
+
+#define SOUND_RING_SIZE   (4*1024*1024)         /* About 24 seconds */
+#define SOUND_RING_MASK   (SOUND_RING_SIZE-1)
+#define SOUND_BATCH_SIZE  (64*1024)             /* Preferred write size */
 
-static FILE*  AiffFileHndl;                /* Pointer to our AIFF file */
-static int    nAiffOutputBytes;            /* Number of sample bytes saved */
-volatile bool bRecordingAiff = false;      /* Is an AIFF file open and recording? */
+static lock_t GrabSoundLock;               /* Protect recording state */
+
+static FILE*  AiffFileHndl;                /* Pointer to our sound file, owned by writer */
+static uint32_t nAiffOutputBytes;          /* Number of sample bytes saved */
+volatile bool bRecordingAiff = false;      /* Is a sound file open and recording? */
+
+static uint8_t*     SoundRing;
+static atomic_int   SoundRead;             /* Ring position of writer thread */
+static atomic_int   SoundWrite;            /* Ring position of emulation thread */
+static atomic_int   SoundQuit;
+static atomic_int   SoundLost;             /* Bytes dropped since last report */
+static thread_t*    SoundThread;
+static semaphore_t* SoundSignal;
+static int          SoundFormat;
+static bool         SoundError;
 
 static uint8_t AiffHeader[54] =
 {
@@ -679,99 +1541,453 @@ static uint8_t AiffHeader[54] =
 };
 
 
+/*
+ FLAC file output
+ 
+ Blocks of 4096 stereo samples are coded as one frame with a subframe per
+ channel. Each subframe uses the fixed predictor (order 0 to 4) with the
+ smallest residual. Residuals are Rice coded in 16 partitions, or the
+ subframe is stored verbatim if that is shorter. Total samples in the
+ STREAMINFO block are patched when the file is closed, MD5 is left unset.
+ */
+
+#define FLAC_BLOCK_SIZE   4096
+#define FLAC_PARTITIONS   4                     /* Partition order */
+#define FLAC_FRAME_MAX    (32 + 2 * (FLAC_BLOCK_SIZE * 2 + 8))
+
+static uint8_t FlacHeader[42] =
+{
+	'f', 'L', 'a', 'C',      /* Stream marker */
+	0x80, 0, 0, 34,          /* Last metadata block, STREAMINFO, 34 bytes */
+	0x10, 0x00,              /* Minimum block size (4096) */
+	0x10, 0x00,              /* Maximum block size (4096) */
+	0, 0, 0,                 /* Minimum frame size (unknown) */
+	0, 0, 0,                 /* Maximum frame size (unknown) */
+	0x0a, 0xc4, 0x42,        /* 44100 Hz, 2 channels, 16 bit, */
+	0xf0, 0, 0, 0, 0,        /* total samples (patched when file is closed) */
+	0, 0, 0, 0, 0, 0, 0, 0,  /* MD5 signature (unset) */
+	0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static int16_t  FlacSamples[2][FLAC_BLOCK_SIZE];
+static int      FlacCount;
+static uint32_t FlacFrame;
+
+struct flac_bits {
+	uint8_t* p;
+	uint64_t acc;
+	int      n;
+};
+
+static void flac_put(struct flac_bits* b, uint32_t val, int bits) {
+	b->acc = (b->acc << bits) | (val & ((1ULL << bits) - 1));
+	b->n  += bits;
+	while (b->n >= 8) {
+		b->n -= 8;
+		*b->p++ = (uint8_t)(b->acc >> b->n);
+	}
+}
+
+static void flac_put_rice(struct flac_bits* b, int32_t val, int k) {
+	uint32_t u = ((uint32_t)val << 1) ^ (uint32_t)(val >> 31);
+	uint32_t q = u >> k;
+	while (q >= 32) {
+		flac_put(b, 0, 32);
+		q -= 32;
+	}
+	flac_put(b, 1, q + 1);
+	if (k) {
+		flac_put(b, u, k);
+	}
+}
+
+static uint8_t flac_crc8(const uint8_t* p, int len) {
+	uint8_t crc = 0;
+	int i;
+	while (len--) {
+		crc ^= *p++;
+		for (i = 0; i < 8; i++) {
+			crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static uint16_t flac_crc16(const uint8_t* p, int len) {
+	uint16_t crc = 0;
+	int i;
+	while (len--) {
+		crc ^= (uint16_t)*p++ << 8;
+		for (i = 0; i < 8; i++) {
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x8005) : (uint16_t)(crc << 1);
+		}
+	}
+	return crc;
+}
+
+static inline int32_t flac_residual(const int16_t* x, int i, int order) {
+	switch (order) {
+		case 0:  return x[i];
+		case 1:  return x[i] - x[i-1];
+		case 2:  return x[i] - 2*x[i-1] + x[i-2];
+		case 3:  return x[i] - 3*x[i-1] + 3*x[i-2] - x[i-3];
+		default: return x[i] - 4*x[i-1] + 6*x[i-2] - 4*x[i-3] + x[i-4];
+	}
+}
+
+/**
+ * Code one channel of the current block as fixed predictor or verbatim subframe.
+ */
+static void flac_subframe(struct flac_bits* b, const int16_t* x, int n) {
+	uint64_t sum, best = UINT64_MAX;
+	uint64_t bits = 2 + 4;
+	int      param[1 << FLAC_PARTITIONS];
+	int      porder, parts, psize;
+	int      order = 0, o, i, j, k, start;
+	
+	for (o = 0; o <= 4 && o < n; o++) {
+		for (sum = 0, i = o; i < n; i++) {
+			sum += abs(flac_residual(x, i, o));
+		}
+		if (sum < best) {
+			best  = sum;
+			order = o;
+		}
+	}
+	
+	/* Use partitions if block size allows it */
+	for (porder = FLAC_PARTITIONS; porder > 0; porder--) {
+		if ((n & ((1 << porder) - 1)) == 0 && (n >> porder) > order) {
+			break;
+		}
+	}
+	parts = 1 << porder;
+	psize = n >> porder;
+	
+	/* Choose Rice parameters from the mean residual and count bits */
+	for (j = 0; j < parts; j++) {
+		start = j ? j * psize : order;
+		for (sum = 0, i = start; i < (j + 1) * psize; i++) {
+			sum += abs(flac_residual(x, i, order));
+		}
+		for (k = 0; k < 14 && ((uint64_t)((j + 1) * psize - start) << k) < sum; k++) {}
+		param[j] = k;
+		bits += 4;
+		for (i = start; i < (j + 1) * psize; i++) {
+			int32_t r = flac_residual(x, i, order);
+			bits += ((((uint32_t)r << 1) ^ (uint32_t)(r >> 31)) >> k) + 1 + k;
+		}
+	}
+	
+	if (bits + order * 16 >= (uint64_t)n * 16) {
+		flac_put(b, 0x02, 8);               /* Verbatim subframe */
+		for (i = 0; i < n; i++) {
+			flac_put(b, (uint16_t)x[i], 16);
+		}
+		return;
+	}
+	
+	flac_put(b, 0x10 | (order << 1), 8);    /* Fixed subframe */
+	for (i = 0; i < order; i++) {
+		flac_put(b, (uint16_t)x[i], 16);
+	}
+	flac_put(b, 0, 2);                      /* Rice coding, 4 bit parameters */
+	flac_put(b, porder, 4);
+	for (j = 0; j < parts; j++) {
+		flac_put(b, param[j], 4);
+		for (i = j ? j * psize : order; i < (j + 1) * psize; i++) {
+			flac_put_rice(b, flac_residual(x, i, order), param[j]);
+		}
+	}
+}
+
+/**
+ * Code collected samples as one frame and write it.
+ */
+static bool Grab_WriteFlacFrame(void) {
+	static uint8_t frame[FLAC_FRAME_MAX];
+	struct flac_bits b = { frame, 0, 0 };
+	uint16_t crc;
+	int len;
+	
+	if (FlacCount == 0) {
+		return true;
+	}
+	flac_put(&b, 0xFFF8, 16);               /* Sync code, fixed block size */
+	flac_put(&b, FlacCount == FLAC_BLOCK_SIZE ? 12 : 7, 4);
+	flac_put(&b, 9, 4);                     /* 44.1 kHz */
+	flac_put(&b, 1, 4);                     /* Left and right channel */
+	flac_put(&b, 4, 3);                     /* 16 bit */
+	flac_put(&b, 0, 1);
+	
+	/* Frame number in UTF-8 coding */
+	if (FlacFrame < 0x80) {
+		flac_put(&b, FlacFrame, 8);
+	} else {
+		int bytes = FlacFrame < 0x800 ? 2 : FlacFrame < 0x10000 ? 3 : FlacFrame < 0x200000 ? 4 :
+		            FlacFrame < 0x4000000 ? 5 : 6;
+		flac_put(&b, (0xFF00 >> bytes) | (FlacFrame >> (6 * (bytes - 1))), 8);
+		while (--bytes) {
+			flac_put(&b, 0x80 | ((FlacFrame >> (6 * (bytes - 1))) & 0x3F), 8);
+		}
+	}
+	if (FlacCount != FLAC_BLOCK_SIZE) {
+		flac_put(&b, FlacCount - 1, 16);
+	}
+	flac_put(&b, flac_crc8(frame, (int)(b.p - frame)), 8);
+	
+	flac_subframe(&b, FlacSamples[0], FlacCount);
+	flac_subframe(&b, FlacSamples[1], FlacCount);
+	if (b.n) {
+		flac_put(&b, 0, 8 - b.n);
+	}
+	len = (int)(b.p - frame);
+	crc = flac_crc16(frame, len);
+	flac_put(&b, crc, 16);
+	
+	FlacFrame++;
+	FlacCount = 0;
+	return fwrite(frame, len + 2, 1, AiffFileHndl) == 1;
+}
+
 /**
- * Write sizes to AIFF header, then close the AIFF file.
+ * Add big endian stereo samples to FLAC frames.
+ */
+static bool Grab_WriteFlac(uint8_t* samples, int len) {
+	int i;
+	
+	for (i = 0; i + 4 <= len; i += 4) {
+		FlacSamples[0][FlacCount] = (int16_t)((samples[i + 0] << 8) | samples[i + 1]);
+		FlacSamples[1][FlacCount] = (int16_t)((samples[i + 2] << 8) | samples[i + 3]);
+		if (++FlacCount == FLAC_BLOCK_SIZE) {
+			if (!Grab_WriteFlacFrame()) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+
+/**
+ * Write samples from the ring. Called from writer thread.
+ */
+static void Grab_WriteSound(uint8_t* samples, int len) {
+	bool ok;
+	
+	if (SoundError) {
+		return;
+	}
+	if (SoundFormat == SOUNDGRAB_FLAC) {
+		ok = Grab_WriteFlac(samples, len);
+	} else {
+		ok = fwrite(samples, len, 1, AiffFileHndl) == 1;
+	}
+	if (!ok) {
+		perror("[Grab] Grab_WriteSound:");
+		Log_Printf(LOG_WARN, "[Grab] Error: Writing sound file failed, recording stopped");
+		SoundError = true;
+		return;
+	}
+	nAiffOutputBytes += len;
+}
+
+/**
+ * Write sizes to file header, then close the sound file. Called from
+ * writer thread.
  */
 static void Grab_CloseSoundFile(void)
 {
 	uint32_t nAiffFileBytes;
 	uint32_t nAiffDataBytes;
 	uint32_t nAiffSamples;
+	uint32_t nFlacSamples;
+	bool ok = true;
+	
+	switch (SoundFormat) {
+		case SOUNDGRAB_AIFF:
+			/* Update headers with sizes */
+			nAiffFileBytes = 46+nAiffOutputBytes; /* length of headers minus 8 bytes plus length of data */
+			nAiffDataBytes = 8+nAiffOutputBytes;  /* length of data plus 8 bytes */
+			nAiffSamples   = nAiffOutputBytes/4;  /* length of data divided by bytes per sample frame */
+			
+			/* Patch length of file in header structure */
+			AiffHeader[4] = (uint8_t)((nAiffFileBytes >> 24) & 0xff);
+			AiffHeader[5] = (uint8_t)((nAiffFileBytes >> 16) & 0xff);
+			AiffHeader[6] = (uint8_t)((nAiffFileBytes >>  8) & 0xff);
+			AiffHeader[7] = (uint8_t)((nAiffFileBytes >>  0) & 0xff);
+			
+			/* Patch number of samples in header structure */
+			AiffHeader[22] = (uint8_t)((nAiffSamples >> 24) & 0xff);
+			AiffHeader[23] = (uint8_t)((nAiffSamples >> 16) & 0xff);
+			AiffHeader[24] = (uint8_t)((nAiffSamples >>  8) & 0xff);
+			AiffHeader[25] = (uint8_t)((nAiffSamples >>  0) & 0xff);
+			
+			/* Patch length of data in header structure */
+			AiffHeader[42] = (uint8_t)((nAiffDataBytes >> 24) & 0xff);
+			AiffHeader[43] = (uint8_t)((nAiffDataBytes >> 16) & 0xff);
+			AiffHeader[44] = (uint8_t)((nAiffDataBytes >>  8) & 0xff);
+			AiffHeader[45] = (uint8_t)((nAiffDataBytes >>  0) & 0xff);
+			
+			/* Write updated header to file */
+			ok = File_Write(AiffHeader, sizeof(AiffHeader), 0, AiffFileHndl);
+			break;
+		case SOUNDGRAB_FLAC:
+			if (!SoundError) {
+				ok = Grab_WriteFlacFrame();
+			}
+			nFlacSamples = nAiffOutputBytes/4;
+			
+			/* Patch total samples in STREAMINFO */
+			FlacHeader[22] = (uint8_t)((nFlacSamples >> 24) & 0xff);
+			FlacHeader[23] = (uint8_t)((nFlacSamples >> 16) & 0xff);
+			FlacHeader[24] = (uint8_t)((nFlacSamples >>  8) & 0xff);
+			FlacHeader[25] = (uint8_t)((nFlacSamples >>  0) & 0xff);
+			
+			ok = File_Write(FlacHeader, sizeof(FlacHeader), 0, AiffFileHndl) && ok;
+			break;
+		default:
+			break;
+	}
+	if (!ok)
+	{
+		perror("[Grab] Grab_CloseSoundFile:");
+	}
+	
+	/* Close file */
+	AiffFileHndl = File_Close(AiffFileHndl);
+}
+
+/**
+ * Writer thread. Writes samples in batches until recording stops and
+ * the ring is empty.
+ */
+static int Grab_SoundThread(void* data) {
+	int read, fill, len;
+	bool timeout = false;
 	
+	while (true) {
+		read = host_atomic_get(&SoundRead);
+		fill = (host_atomic_get(&SoundWrite) - read) & SOUND_RING_MASK;
+		if (fill >= SOUND_BATCH_SIZE || (fill > 0 && timeout) || (fill > 0 && host_atomic_get(&SoundQuit))) {
+			len = SOUND_RING_SIZE - read;
+			if (len > fill) {
+				len = fill;
+			}
+			Grab_WriteSound(SoundRing + read, len);
+			host_atomic_set(&SoundRead, (read + len) & SOUND_RING_MASK);
+			continue;
+		}
+		if (host_atomic_get(&SoundQuit)) {
+			break;
+		}
+		timeout = host_semaphore_wait_timeout(SoundSignal, 500) != 0;
+	}
+	Grab_CloseSoundFile();
+	return 0;
+}
+
+/**
+ * Stop writer thread and close sound file.
+ */
+static void Grab_CloseSound(void)
+{
+	host_lock(&GrabSoundLock);
 	if (bRecordingAiff)
 	{
 		bRecordingAiff = false;
+		host_unlock(&GrabSoundLock);
 		
-		/* Update headers with sizes */
-		nAiffFileBytes = 46+nAiffOutputBytes; /* length of headers minus 8 bytes plus length of data */
-		nAiffDataBytes = 8+nAiffOutputBytes;  /* length of data plus 8 bytes */
-		nAiffSamples   = nAiffOutputBytes/2;  /* length of data divided by bytes per sample */
-		
-		/* Patch length of file in header structure */
-		AiffHeader[4] = (uint8_t)((nAiffFileBytes >> 24) & 0xff);
-		AiffHeader[5] = (uint8_t)((nAiffFileBytes >> 16) & 0xff);
-		AiffHeader[6] = (uint8_t)((nAiffFileBytes >>  8) & 0xff);
-		AiffHeader[7] = (uint8_t)((nAiffFileBytes >>  0) & 0xff);
+		host_atomic_set(&SoundQuit, 1);
+		host_semaphore_signal(SoundSignal);
+		host_thread_wait(SoundThread);
+		SoundThread = NULL;
 		
-		/* Patch number of samples in header structure */
-		AiffHeader[22] = (uint8_t)((nAiffSamples >> 24) & 0xff);
-		AiffHeader[23] = (uint8_t)((nAiffSamples >> 16) & 0xff);
-		AiffHeader[24] = (uint8_t)((nAiffSamples >>  8) & 0xff);
-		AiffHeader[25] = (uint8_t)((nAiffSamples >>  0) & 0xff);
-
-		/* Patch length of data in header structure */
-		AiffHeader[42] = (uint8_t)((nAiffDataBytes >> 24) & 0xff);
-		AiffHeader[43] = (uint8_t)((nAiffDataBytes >> 16) & 0xff);
-		AiffHeader[44] = (uint8_t)((nAiffDataBytes >>  8) & 0xff);
-		AiffHeader[45] = (uint8_t)((nAiffDataBytes >>  0) & 0xff);
-		
-		/* Write updated header to file */
-		if (!File_Write(AiffHeader, sizeof(AiffHeader), 0, AiffFileHndl))
-		{
-			perror("[Grab] Grab_CloseSoundFile:");
-		}
-		
-		/* Close file */
-		AiffFileHndl = File_Close(AiffFileHndl);
+		free(SoundRing);
+		SoundRing = NULL;
 		
 		/* And inform user */
-		Log_Printf(LOG_WARN, "[Grab] Stopping sound record");
+		Log_Printf(LOG_WARN, "[Grab] Stopping sound record (%u bytes)", nAiffOutputBytes);
 		Statusbar_AddMessage("Stop saving sound to file", 0);
+	} else {
+		host_unlock(&GrabSoundLock);
 	}
 }
 
 /**
- * Open AIFF output file and write header.
+ * Open sound output file, write header and start writer thread.
  */
-static void Grab_OpenSoundFile(void)
+static void Grab_OpenSound(void)
 {
+	static const char* ext[] = { "aiff", "flac", "raw" };
 	int i;
 	char szFileName[32];
 	char *szPathName = NULL;
 	
-	if (bRecordingAiff) {
-		Grab_CloseSoundFile();
-	}
-	
 	nAiffOutputBytes = 0;
+	FlacCount  = 0;
+	FlacFrame  = 0;
+	SoundError = false;
+	SoundFormat = ConfigureParams.Sound.nGrabFormat;
+	if (SoundFormat < SOUNDGRAB_AIFF || SoundFormat > SOUNDGRAB_RAW) {
+		SoundFormat = SOUNDGRAB_AIFF;
+	}
 	
 	if (File_DirExists(ConfigureParams.Printer.szPrintToFileName)) {
 		
 		/* Build file name */
 		for (i = 0; i < 1000; i++) {
 			snprintf(szFileName, sizeof(szFileName), "next_sound_%03d", i);
-			szPathName = File_MakePath(ConfigureParams.Printer.szPrintToFileName, szFileName, "aiff");
+			szPathName = File_MakePath(ConfigureParams.Printer.szPrintToFileName, szFileName, ext[SoundFormat]);
 			
 			if (File_Exists(szPathName)) {
 				free(szPathName);
 				continue;
 			}
 			
+			SoundRing = malloc(SOUND_RING_SIZE);
+			if (!SoundRing) {
+				Log_Printf(LOG_WARN, "[Grab] Error: Not enough memory for sound recording");
+				free(szPathName);
+				return;
+			}
+			
 			/* Create our file */
 			AiffFileHndl = File_Open(szPathName, "wb");
 			if (AiffFileHndl) {
+				bool ok = true;
 				
 				/* Write header to file */
-				if (File_Write(AiffHeader, sizeof(AiffHeader), 0, AiffFileHndl)) {
+				if (SoundFormat == SOUNDGRAB_AIFF) {
+					ok = File_Write(AiffHeader, sizeof(AiffHeader), 0, AiffFileHndl);
+				} else if (SoundFormat == SOUNDGRAB_FLAC) {
+					ok = File_Write(FlacHeader, sizeof(FlacHeader), 0, AiffFileHndl);
+				}
+				if (ok) {
+					host_atomic_set(&SoundRead, 0);
+					host_atomic_set(&SoundWrite, 0);
+					host_atomic_set(&SoundQuit, 0);
+					host_atomic_set(&SoundLost, 0);
+					if (!SoundSignal) {
+						SoundSignal = host_semaphore_create(0);
+					}
+					SoundThread = host_thread_create(Grab_SoundThread, "GrabSoundThread", NULL);
+					host_lock(&GrabSoundLock);
 					bRecordingAiff = true;
+					host_unlock(&GrabSoundLock);
 					Log_Printf(LOG_WARN, "[Grab] Starting sound record");
 					Statusbar_AddMessage("Start saving sound to file", 0);
 				} else {
-					perror("[Grab] Grab_OpenSoundFile:");
+					perror("[Grab] Grab_OpenSound:");
+					AiffFileHndl = File_Close(AiffFileHndl);
 				}
 			} else {
 				Log_Printf(LOG_WARN, "[Grab] Failed to create sound file %s: ", szPathName);
 			}
+			if (!bRecordingAiff) {
+				free(SoundRing);
+				SoundRing = NULL;
+			}
 			free(szPathName);
 			return;
 		}
@@ -781,44 +1997,82 @@ static void Grab_OpenSoundFile(void)
 }
 
 /**
- * Update AIFF file with current samples.
+ * Pass samples to sound file writer.
  */
 void Grab_Sound(uint8_t* samples, int len)
 {
+	int write, fill, n, i;
+	
 	host_lock(&GrabSoundLock);
 	if (bRecordingAiff)
 	{
-		/* Append samples to our AIFF file */
-		if (fwrite(samples, len, 1, AiffFileHndl) != 1)
-		{
-			perror("[Grab] Grab_Sound:");
-			Grab_CloseSoundFile();
+		write = host_atomic_get(&SoundWrite);
+		fill  = (write - host_atomic_get(&SoundRead)) & SOUND_RING_MASK;
+		if (len > SOUND_RING_MASK - fill) {
+			host_atomic_add(&SoundLost, len);
+		} else {
+			for (i = 0; i < len; i += n) {
+				n = SOUND_RING_SIZE - write;
+				if (n > len - i) {
+					n = len - i;
+				}
+				memcpy(SoundRing + write, samples + i, n);
+				write = (write + n) & SOUND_RING_MASK;
+			}
+			host_atomic_set(&SoundWrite, write);
+			
+			if (fill < SOUND_BATCH_SIZE && fill + len >= SOUND_BATCH_SIZE) {
+				host_semaphore_signal(SoundSignal);
+			}
 		}
-
-		/* Add samples to AIFF file length counter */
-		nAiffOutputBytes += len;
 	}
 	host_unlock(&GrabSoundLock);
+	
+	if (bRecordingVideo) {
+		Grab_VideoSound(samples, len);
+	}
 }
 
 /**
  * Start/Stop recording sound.
  */
 void Grab_SoundToggle(void) {
-	host_lock(&GrabSoundLock);
 	if (bRecordingAiff) {
-		Grab_CloseSoundFile();
+		Grab_CloseSound();
 	} else {
-		Grab_OpenSoundFile();
+		Grab_OpenSound();
 	}
-	host_unlock(&GrabSoundLock);
 }
 
+/**
+ * Report encoded and dropped frames and recorded sound.
+ */
+const char* Grab_Report(uint64_t realTime, uint64_t hostTime) {
+	static char report[96];
+	char* r     = report;
+	int frames  = host_atomic_set(&VideoFrames, 0);
+	int dropped = host_atomic_set(&VideoDropped, 0);
+	int lost    = host_atomic_set(&SoundLost, 0);
+	
+	*r = '\0';
+	if (bRecordingVideo) {
+		r += sprintf(r, "encoded:%d dropped:%d ", frames, dropped);
+	}
+	if (bRecordingAiff) {
+		r += sprintf(r, "sound:%u lost:%d ", nAiffOutputBytes, lost);
+	}
+	if (r == report) {
+		sprintf(r, "idle");
+	}
+	return report;
+}
+
+
 /**
  * Stop any recording activities.
  */
 void Grab_Stop(void) {
-	host_lock(&GrabSoundLock);
-	Grab_CloseSoundFile();
-	host_unlock(&GrabSoundLock);
+	Grab_CloseSound();
+	Grab_CloseVideo();
+	Grab_StopWorkers();
 }
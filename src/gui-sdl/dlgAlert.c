@@ -22,6 +22,7 @@ const char DlgAlert_fileid[] = "Hatari dlgAlert.c";
 
 #include "main.h"
 #include "dialog.h"
+#include "log.h"
 #include "screen.h"
 #include "sdlscreen.h"
 #include "sdlgui.h"
@@ -178,6 +179,10 @@ static bool DlgAlert_ShowDlg(const char *text)
  */
 bool DlgAlert_Notice(const char *text)
 {
+	if (bHeadless) {
+		Log_Printf(LOG_WARN, "%s", text);
+		return true;
+	}
 #ifdef ALERT_HOOKS
 	if (!Main_UnPauseEmulation())
 		Main_PauseEmulation(true);
@@ -204,6 +209,11 @@ bool DlgAlert_Notice(const char *text)
  */
 bool DlgAlert_Query(const char *text)
 {
+	if (bHeadless) {
+		/* Nobody to ask, accept */
+		Log_Printf(LOG_WARN, "%s (OK)", text);
+		return true;
+	}
 #ifdef ALERT_HOOKS
 	if(!bInFullScreen)
 		return HookedAlertQuery(text);
@@ -146,7 +146,10 @@ void DlgEthernet_Main(void)
 		enetdlg[DLGENET_PCAP].state |= SG_SELECTED;
 		snprintf(pcap_interface, PCAP_INTERFACE_LEN, "PCAP: %.12s", ConfigureParams.Ethernet.szInterfaceName);
 	} else {
-		enetdlg[DLGENET_SLIRP].state |= SG_SELECTED;
+		/* TAP has no button, leave it selected unless user picks another */
+		if (ConfigureParams.Ethernet.nHostInterface == ENET_SLIRP) {
+			enetdlg[DLGENET_SLIRP].state |= SG_SELECTED;
+		}
 		snprintf(pcap_interface, sizeof(pcap_interface), "PCAP");
 	}
 #endif
@@ -229,7 +232,7 @@ void DlgEthernet_Main(void)
 #if HAVE_PCAP
 	if (enetdlg[DLGENET_PCAP].state & SG_SELECTED) {
 		ConfigureParams.Ethernet.nHostInterface = ENET_PCAP;
-	} else {
+	} else if (enetdlg[DLGENET_SLIRP].state & SG_SELECTED) {
 		ConfigureParams.Ethernet.nHostInterface = ENET_SLIRP;
 	}
 #endif
@@ -60,6 +60,7 @@ static char sc_names[SHORTCUT_KEYS][20] = {
 	"Cold reset",
 	"Grab screen",
 	"Recording on/off",
+	"Video rec on/off",
 	"Sound on/off",
 	"Debug 68k",
 	"Debug i860",
@@ -222,14 +223,14 @@ static void Dialog_ShortcutDlg(void)
 #define DLGKEYMAIN_SYMBOLIC  5
 #define DLGKEYMAIN_SWAP      8
 #define DLGKEYMAIN_DEFINE    12
-#define DLGKEYMAIN_EXIT      49
+#define DLGKEYMAIN_EXIT      52
 
 static char key_names[SHORTCUT_KEYS][2][16];
 
 /* The keyboard dialog: */
 static SGOBJ keyboarddlg[] =
 {
-	{ SGBOX, 0, 0, 0,0, 49,32, NULL },
+	{ SGBOX, 0, 0, 0,0, 49,33, NULL },
 	{ SGTEXT, 0, 0, 16,1, 16,1, "Keyboard options" },
 
 	{ SGBOX, 0, 0, 2,3, 22,7, NULL },
@@ -241,7 +242,7 @@ static SGOBJ keyboarddlg[] =
 	{ SGTEXT, 0, 0, 27,4, 12,1, "Key options:" },
 	{ SGCHECKBOX, 0, 0, 27,6, 18,1, "Swap cmd and alt" },
 
-	{ SGBOX,  0, 0,  2,11, 45,16, NULL },
+	{ SGBOX,  0, 0,  2,11, 45,17, NULL },
 	{ SGTEXT, 0, 0,  4,12, 10,1, "Shortcuts:" },
 	{ SGTEXT, 0, 0, 18,12, 10,1, "ctrl-alt-X  or  Fn" },
 	{ SGBUTTON, 0, 0, 38,12, 8,1, "Change" },
@@ -267,23 +268,26 @@ static SGOBJ keyboarddlg[] =
 	{ SGTEXT, 0, 0,  6,20, 20,1, sc_names[SHORTCUT_RECORD] },
 	{ SGTEXT, 0, 0, 26,20,  8,1, key_names[SHORTCUT_RECORD][0] },
 	{ SGTEXT, 0, 0, 34,20, 11,1, key_names[SHORTCUT_RECORD][1] },
-	{ SGTEXT, 0, 0,  6,21, 20,1, sc_names[SHORTCUT_FULLSCREEN] },
-	{ SGTEXT, 0, 0, 26,21,  8,1, key_names[SHORTCUT_FULLSCREEN][0] },
-	{ SGTEXT, 0, 0, 34,21, 11,1, key_names[SHORTCUT_FULLSCREEN][1] },
-	{ SGTEXT, 0, 0,  6,22, 20,1, sc_names[SHORTCUT_STATUSBAR] },
-	{ SGTEXT, 0, 0, 26,22,  8,1, key_names[SHORTCUT_STATUSBAR][0] },
-	{ SGTEXT, 0, 0, 34,22, 11,1, key_names[SHORTCUT_STATUSBAR][1] },
-	{ SGTEXT, 0, 0,  6,23, 20,1, sc_names[SHORTCUT_TITLEBAR] },
-	{ SGTEXT, 0, 0, 26,23,  8,1, key_names[SHORTCUT_TITLEBAR][0] },
-	{ SGTEXT, 0, 0, 34,23, 11,1, key_names[SHORTCUT_TITLEBAR][1] },
-	{ SGTEXT, 0, 0,  6,24, 20,1, sc_names[SHORTCUT_SOUND] },
-	{ SGTEXT, 0, 0, 26,24,  8,1, key_names[SHORTCUT_SOUND][0] },
-	{ SGTEXT, 0, 0, 34,24, 11,1, key_names[SHORTCUT_SOUND][1] },
-	{ SGTEXT, 0, 0,  6,25, 20,1, sc_names[SHORTCUT_QUIT] },
-	{ SGTEXT, 0, 0, 26,25,  8,1, key_names[SHORTCUT_QUIT][0] },
-	{ SGTEXT, 0, 0, 34,25, 11,1, key_names[SHORTCUT_QUIT][1] },
-
-	{ SGBUTTON, SG_DEFAULT, 0, 14,29, 21,1, "Back to main menu" },
+	{ SGTEXT, 0, 0,  6,21, 20,1, sc_names[SHORTCUT_VIDEO] },
+	{ SGTEXT, 0, 0, 26,21,  8,1, key_names[SHORTCUT_VIDEO][0] },
+	{ SGTEXT, 0, 0, 34,21, 11,1, key_names[SHORTCUT_VIDEO][1] },
+	{ SGTEXT, 0, 0,  6,22, 20,1, sc_names[SHORTCUT_FULLSCREEN] },
+	{ SGTEXT, 0, 0, 26,22,  8,1, key_names[SHORTCUT_FULLSCREEN][0] },
+	{ SGTEXT, 0, 0, 34,22, 11,1, key_names[SHORTCUT_FULLSCREEN][1] },
+	{ SGTEXT, 0, 0,  6,23, 20,1, sc_names[SHORTCUT_STATUSBAR] },
+	{ SGTEXT, 0, 0, 26,23,  8,1, key_names[SHORTCUT_STATUSBAR][0] },
+	{ SGTEXT, 0, 0, 34,23, 11,1, key_names[SHORTCUT_STATUSBAR][1] },
+	{ SGTEXT, 0, 0,  6,24, 20,1, sc_names[SHORTCUT_TITLEBAR] },
+	{ SGTEXT, 0, 0, 26,24,  8,1, key_names[SHORTCUT_TITLEBAR][0] },
+	{ SGTEXT, 0, 0, 34,24, 11,1, key_names[SHORTCUT_TITLEBAR][1] },
+	{ SGTEXT, 0, 0,  6,25, 20,1, sc_names[SHORTCUT_SOUND] },
+	{ SGTEXT, 0, 0, 26,25,  8,1, key_names[SHORTCUT_SOUND][0] },
+	{ SGTEXT, 0, 0, 34,25, 11,1, key_names[SHORTCUT_SOUND][1] },
+	{ SGTEXT, 0, 0,  6,26, 20,1, sc_names[SHORTCUT_QUIT] },
+	{ SGTEXT, 0, 0, 26,26,  8,1, key_names[SHORTCUT_QUIT][0] },
+	{ SGTEXT, 0, 0, 34,26, 11,1, key_names[SHORTCUT_QUIT][1] },
+
+	{ SGBUTTON, SG_DEFAULT, 0, 14,30, 21,1, "Back to main menu" },
 	{ SGSTOP, 0, 0, 0,0, 0,0, NULL }
 };
 
@@ -32,9 +32,130 @@ static struct audio_t audio_dsp;
 /*-----------------------------------------------------------------------*/
 /**
  * Sound playback functions.
+ *
+ * Samples are passed to the audio callback through a single producer,
+ * single consumer ring. The callback resamples with a ratio slightly off
+ * 1.0 to keep the ring fill near a target of two device buffers. This
+ * absorbs drift between emulated time and the device clock without
+ * underruns or growing latency. Sound output is only held back when the
+ * ring is filled beyond twice the target.
  */
+#define AUDIO_RING_FRAMES  0x4000   /* about 370 ms at 44.1 kHz */
+#define AUDIO_RING_MASK    (AUDIO_RING_FRAMES - 1)
+#define AUDIO_FRAME_SIZE   4        /* 16-bit big-endian stereo */
+#define AUDIO_MAX_DRIFT    0.005    /* maximum resampling correction */
+
+static struct {
+	uint8_t       data[AUDIO_RING_FRAMES * AUDIO_FRAME_SIZE];
+	SDL_AtomicInt read;
+	SDL_AtomicInt write;
+	SDL_AtomicInt underruns;
+	SDL_AtomicInt overruns;
+	SDL_AtomicInt drift;     /* resampling correction in ppm */
+	int           target;    /* ring fill to keep in frames */
+	uint32_t      phase;     /* 16.16 position between read and read + 1 */
+	double        fill;      /* smoothed ring fill */
+	double        integral;
+} ring;
+
 static int Audio_Buffer_Size;
 
+static int Audio_Ring_Fill(void) {
+	return (SDL_GetAtomicInt(&ring.write) - SDL_GetAtomicInt(&ring.read)) & AUDIO_RING_MASK;
+}
+
+static void Audio_Ring_SetTarget(void) {
+	ring.target = 2 * Audio_Buffer_Size / AUDIO_FRAME_SIZE;
+	if (ring.target < 1024) {
+		ring.target = 1024;
+	} else if (ring.target > AUDIO_RING_FRAMES / 4) {
+		ring.target = AUDIO_RING_FRAMES / 4;
+	}
+	ring.fill = ring.target;
+	ring.integral = 0.0;
+}
+
+static inline int16_t Audio_Ring_Sample(int frame, int c) {
+	uint8_t* p = &ring.data[(frame & AUDIO_RING_MASK) * AUDIO_FRAME_SIZE + c * 2];
+	return (int16_t)((p[0] << 8) | p[1]);
+}
+
+/* Adjust resampling ratio towards keeping the ring fill at target */
+static uint32_t Audio_Ring_Step(int fill) {
+	double error, drift;
+	
+	ring.fill     += (fill - ring.fill) * 0.05;
+	error          = (ring.fill - ring.target) / ring.target;
+	ring.integral += error * 0.0001;
+	if (ring.integral > AUDIO_MAX_DRIFT) {
+		ring.integral = AUDIO_MAX_DRIFT;
+	} else if (ring.integral < -AUDIO_MAX_DRIFT) {
+		ring.integral = -AUDIO_MAX_DRIFT;
+	}
+	drift = error * 0.02 + ring.integral;
+	if (drift > AUDIO_MAX_DRIFT) {
+		drift = AUDIO_MAX_DRIFT;
+	} else if (drift < -AUDIO_MAX_DRIFT) {
+		drift = -AUDIO_MAX_DRIFT;
+	}
+	SDL_SetAtomicInt(&ring.drift, (int)(drift * 1000000.0));
+	return (uint32_t)((1.0 + drift) * 65536.0 + 0.5);
+}
+
+/* Audio thread: resample from ring into the device stream */
+static void SDLCALL Audio_Output_Callback(void* userdata, SDL_AudioStream* stream, int additional, int total) {
+	uint8_t  out[1024 * AUDIO_FRAME_SIZE];
+	int      read  = SDL_GetAtomicInt(&ring.read);
+	int      avail = (SDL_GetAtomicInt(&ring.write) - read) & AUDIO_RING_MASK;
+	uint32_t step  = Audio_Ring_Step(avail);
+	int      frames, i, c, s0, s1;
+	bool     underrun = false;
+	
+	frames = (additional + AUDIO_FRAME_SIZE - 1) / AUDIO_FRAME_SIZE;
+	
+	while (frames > 0) {
+		int n = frames < 1024 ? frames : 1024;
+		for (i = 0; i < n; i++) {
+			if (avail < 2) {
+				memset(&out[i * AUDIO_FRAME_SIZE], 0, AUDIO_FRAME_SIZE);
+				underrun = true;
+				continue;
+			}
+			for (c = 0; c < 2; c++) {
+				s0 = Audio_Ring_Sample(read, c);
+				s1 = Audio_Ring_Sample(read + 1, c);
+				/* 15 bit fraction keeps the product within int */
+				s0 += ((s1 - s0) * (int)((ring.phase & 0xFFFF) >> 1)) >> 15;
+				out[i * AUDIO_FRAME_SIZE + c * 2 + 0] = s0 >> 8;
+				out[i * AUDIO_FRAME_SIZE + c * 2 + 1] = s0;
+			}
+			ring.phase += step;
+			read  = (read + (ring.phase >> 16)) & AUDIO_RING_MASK;
+			avail -= ring.phase >> 16;
+			ring.phase &= 0xFFFF;
+		}
+		SDL_SetAtomicInt(&ring.read, read);
+		SDL_PutAudioStreamData(stream, out, n * AUDIO_FRAME_SIZE);
+		frames -= n;
+	}
+	if (underrun) {
+		SDL_AddAtomicInt(&ring.underruns, 1);
+	}
+}
+
+const char* Audio_Report(uint64_t realTime, uint64_t hostTime) {
+	static char report[96];
+	int underruns = SDL_SetAtomicInt(&ring.underruns, 0);
+	int overruns  = SDL_SetAtomicInt(&ring.overruns, 0);
+	if (audio_playback.stream) {
+		snprintf(report, sizeof(report), "fill:%d/%d underruns:%d overruns:%d drift:%dppm",
+		         Audio_Ring_Fill(), ring.target, underruns, overruns, SDL_GetAtomicInt(&ring.drift));
+	} else {
+		snprintf(report, sizeof(report), "idle");
+	}
+	return report;
+}
+
 void Audio_FormatChanged(bool recording) {
 	if (!recording && audio_playback.stream) {
 		SDL_AudioSpec spec = { 0 };
@@ -45,33 +166,62 @@ void Audio_FormatChanged(bool recording) {
 			Audio_Buffer_Size = 4096;
 		}
 		Log_Printf(LOG_WARN, "[Audio] Output buffer size: %d byte", Audio_Buffer_Size);
+		SDL_LockAudioStream(audio_playback.stream);
+		Audio_Ring_SetTarget();
+		SDL_UnlockAudioStream(audio_playback.stream);
 	}
 }
 
 void Audio_Output_Queue_Put(uint8_t* data, int len) {
+	int write, space, n;
+	
 	if (audio_playback.stream && len > 0) {
-		SDL_PutAudioStreamData(audio_playback.stream, data, len);
+		write = SDL_GetAtomicInt(&ring.write);
+		space = AUDIO_RING_MASK - Audio_Ring_Fill();
+		len  /= AUDIO_FRAME_SIZE;
+		if (len > space) {
+			SDL_AddAtomicInt(&ring.overruns, 1);
+			len = space;
+		}
+		while (len > 0) {
+			n = AUDIO_RING_FRAMES - write;
+			if (n > len) {
+				n = len;
+			}
+			memcpy(&ring.data[write * AUDIO_FRAME_SIZE], data, n * AUDIO_FRAME_SIZE);
+			data += n * AUDIO_FRAME_SIZE;
+			write = (write + n) & AUDIO_RING_MASK;
+			len  -= n;
+		}
+		SDL_SetAtomicInt(&ring.write, write);
 	}
 }
 
 int Audio_Output_Queue_Size(void) {
+	int fill;
+	
 	if (audio_playback.stream) {
-		if (SDL_GetAudioStreamAvailable(audio_playback.stream) > Audio_Buffer_Size) {
-			return SDL_GetAudioStreamQueued(audio_playback.stream);
+		/* Wait until the ring drains to the fill level the drift
+		 * controller aims for, so it does not have to fight pacing */
+		fill = Audio_Ring_Fill();
+		if (fill > ring.target) {
+			return (fill - ring.target) * AUDIO_FRAME_SIZE;
 		}
 	}
 	return 0;
 }
 
 void Audio_Output_Queue_Flush(void) {
-	if (audio_playback.stream) {
-		SDL_FlushAudioStream(audio_playback.stream);
-	}
+	/* Samples in the ring are available to the callback immediately */
 }
 
 void Audio_Output_Queue_Clear(void) {
 	if (audio_playback.stream) {
+		SDL_LockAudioStream(audio_playback.stream);
+		SDL_SetAtomicInt(&ring.read, SDL_GetAtomicInt(&ring.write));
+		ring.phase = 0;
 		SDL_ClearAudioStream(audio_playback.stream);
+		SDL_UnlockAudioStream(audio_playback.stream);
 	}
 }
 
@@ -151,7 +301,8 @@ void Audio_Output_Enable(bool bEnable) {
 /**
  * Initialise the audio subsystem.
  */
-static void Audio_Open(struct audio_t* audio, SDL_AudioDeviceID dev, int channels, int freq) {
+static void Audio_Open(struct audio_t* audio, SDL_AudioDeviceID dev, int channels, int freq,
+                       SDL_AudioStreamCallback callback) {
 	if (audio->stream == NULL) {
 		SDL_AudioSpec request = {SDL_AUDIO_S16BE, channels, freq};
 		
@@ -164,7 +315,7 @@ static void Audio_Open(struct audio_t* audio, SDL_AudioDeviceID dev, int channel
 			}
 		}
 		/* Open streaming device */
-		audio->stream = SDL_OpenAudioDeviceStream(dev, &request, NULL, NULL);
+		audio->stream = SDL_OpenAudioDeviceStream(dev, &request, callback, NULL);
 		if (audio->stream == NULL) {
 			Log_Printf(LOG_WARN, "[Audio] Could not open audio device: %s", SDL_GetError());
 			Statusbar_AddMessage("Error: Can't open audio output device. No sound.", 5000);
@@ -175,17 +326,17 @@ static void Audio_Open(struct audio_t* audio, SDL_AudioDeviceID dev, int channel
 }
 
 void Audio_Output_Init(int channels, int freq) {
-	Audio_Open(&audio_playback, SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, channels, freq);
+	Audio_Open(&audio_playback, SDL_AUDIO_DEVICE_DEFAULT_PLAYBACK, channels, freq, Audio_Output_Callback);
 	Audio_FormatChanged(false);
 }
 
 void Audio_Input_InitAndEnable(int channels, int freq) {
-	Audio_Open(&audio_recording, SDL_AUDIO_DEVICE_DEFAULT_RECORDING, channels, freq);
+	Audio_Open(&audio_recording, SDL_AUDIO_DEVICE_DEFAULT_RECORDING, channels, freq, NULL);
 	Audio_Enable(&audio_recording, true);
 }
 
 void Audio_DSP_InitAndEnable(int channels, int freq) {
-	Audio_Open(&audio_dsp, SDL_AUDIO_DEVICE_DEFAULT_RECORDING, channels, freq);
+	Audio_Open(&audio_dsp, SDL_AUDIO_DEVICE_DEFAULT_RECORDING, channels, freq, NULL);
 	Audio_Enable(&audio_dsp, true);
 }
 
@@ -219,7 +370,8 @@ void Audio_DSP_UnInit(void) {
  */
 static void Audio_Handle_Connect(struct audio_t* audio, SDL_AudioDeviceID dev) {
 	if (audio->freq > 0 && audio->stream == NULL) {
-		Audio_Open(audio, dev, audio->chan, audio->freq);
+		Audio_Open(audio, dev, audio->chan, audio->freq,
+		           audio == &audio_playback ? Audio_Output_Callback : NULL);
 		Audio_Enable(audio, audio->enabled);
 	}
 }
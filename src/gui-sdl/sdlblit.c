@@ -0,0 +1,363 @@
+/*
+  Previous - sdlblit.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Pixel format conversion from the NeXT and NeXTdimension framebuffers to
+  32-bit host pixels. Vectorised kernels for SSSE3, AVX2 and NEON are
+  selected at runtime. The table driven C kernels are used on all other
+  hosts and for pixel formats the vector kernels can not handle.
+*/
+const char SDLblit_fileid[] = "Previous sdlblit.c";
+
+#include "main.h"
+#include "sdlblit.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BLIT_X86 1
+#include <immintrin.h>
+#if defined(__GNUC__)
+#define BLIT_TARGET(x) __attribute__((target(x)))
+#else
+#define BLIT_TARGET(x)
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define BLIT_NEON 1
+#include <arm_neon.h>
+#endif
+
+
+typedef void (*blit_bw_row_t)(const uint8_t* src, uint8_t* dst, int w);
+typedef void (*blit_color_row_t)(const uint16_t* src, uint32_t* dst, int w);
+
+static BLIT_KERNEL      blit_kernel;
+static SDL_PixelFormat  blit_format;
+
+static uint32_t BW2RGB[0x100][4];
+static uint32_t COL2RGB[0x10000];
+
+/* Tables for the vector kernels */
+static uint32_t bw_pixel[4];            /* host pixel for each 2-bit value */
+static uint8_t  col_shuffle[16];        /* expanded RGBX byte for each destination byte */
+static uint32_t col_alpha;              /* constant bits of each color pixel */
+static bool     col_vector;             /* color kernels can handle the format */
+
+#if BLIT_X86 || BLIT_NEON
+static const uint8_t blit_nibble[16] = {
+	0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+	0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+#endif
+
+
+static uint32_t col2rgb(const SDL_PixelFormatDetails* fmt, int col) {
+	int r = ((col >> 12) & 0x0F) * 0x11;
+	int g = ((col >>  8) & 0x0F) * 0x11;
+	int b = ((col >>  4) & 0x0F) * 0x11;
+	return SDL_MapRGB(fmt, NULL, r, g, b);
+}
+
+/* Position of a color channel within a pixel in memory */
+static int blit_byte(int shift) {
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+	return 3 - shift / 8;
+#else
+	return shift / 8;
+#endif
+}
+
+
+/*
+ C kernels
+ */
+static void bw_row_c(const uint8_t* src, uint8_t* dst, int w) {
+	int x;
+	for (x = 0; x < w / 4; x++) {
+		memcpy(dst, BW2RGB[*src++], 16);
+		dst += 16;
+	}
+}
+
+static void color_row_c(const uint16_t* src, uint32_t* dst, int w) {
+	int x;
+	for (x = 0; x < w; x++) {
+		*dst++ = COL2RGB[*src++];
+	}
+}
+
+static blit_bw_row_t    blit_bw_row    = bw_row_c;
+static blit_color_row_t blit_color_row = color_row_c;
+
+
+#if BLIT_X86
+/*
+ SSSE3 kernels
+
+ Color: Each pixel is a big-endian RGBX word with 4 bits per channel. The
+ nibbles are expanded to bytes with pshufb, interleaved to RGBX byte order
+ and moved to their place in the host pixel with another pshufb.
+
+ BW: The C kernel already does one 16 byte load and store per source byte.
+ It is bound by stores and shuffle based versions only add work.
+ */
+BLIT_TARGET("ssse3")
+static void color_row_ssse3(const uint16_t* src, uint32_t* dst, int w) {
+	const __m128i nib   = _mm_loadu_si128((const __m128i*)blit_nibble);
+	const __m128i shuf  = _mm_loadu_si128((const __m128i*)col_shuffle);
+	const __m128i alpha = _mm_set1_epi32(col_alpha);
+	const __m128i mask  = _mm_set1_epi8(0x0F);
+	__m128i v, hi, lo;
+	int i;
+
+	for (i = 0; i + 8 <= w; i += 8) {
+		v  = _mm_loadu_si128((const __m128i*)(src + i));
+		hi = _mm_shuffle_epi8(nib, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+		lo = _mm_shuffle_epi8(nib, _mm_and_si128(v, mask));
+		_mm_storeu_si128((__m128i*)(dst + i),
+		                 _mm_or_si128(_mm_shuffle_epi8(_mm_unpacklo_epi8(hi, lo), shuf), alpha));
+		_mm_storeu_si128((__m128i*)(dst + i + 4),
+		                 _mm_or_si128(_mm_shuffle_epi8(_mm_unpackhi_epi8(hi, lo), shuf), alpha));
+	}
+	color_row_c(src + i, dst + i, w - i);
+}
+
+/*
+ AVX2 kernels
+
+ Color is the same as SSSE3, but on two independent 128-bit lanes. The
+ lanes are reordered before each store.
+ */
+BLIT_TARGET("avx2")
+static void bw_row_avx2(const uint8_t* src, uint8_t* dst, int w) {
+	const __m256i lut   = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)bw_pixel));
+	const __m256i shift = _mm256_setr_epi32(6, 4, 2, 0, 14, 12, 10, 8);
+	const __m256i mask  = _mm256_set1_epi32(3);
+	__m256i v;
+	int n = w / 4;
+	int i;
+
+	/* Eight pixels from two source bytes, picked from the table with vpermd */
+	for (i = 0; i + 2 <= n; i += 2) {
+		v = _mm256_set1_epi32(src[i] | (src[i+1] << 8));
+		v = _mm256_and_si256(_mm256_srlv_epi32(v, shift), mask);
+		_mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(lut, v));
+		dst += 32;
+	}
+	bw_row_c(src + i, dst, (n - i) * 4);
+}
+
+BLIT_TARGET("avx2")
+static void color_row_avx2(const uint16_t* src, uint32_t* dst, int w) {
+	const __m256i nib   = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)blit_nibble));
+	const __m256i shuf  = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)col_shuffle));
+	const __m256i alpha = _mm256_set1_epi32(col_alpha);
+	const __m256i mask  = _mm256_set1_epi8(0x0F);
+	__m256i v, hi, lo, a, b;
+	int i;
+
+	for (i = 0; i + 16 <= w; i += 16) {
+		v  = _mm256_loadu_si256((const __m256i*)(src + i));
+		hi = _mm256_shuffle_epi8(nib, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+		lo = _mm256_shuffle_epi8(nib, _mm256_and_si256(v, mask));
+		a  = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_unpacklo_epi8(hi, lo), shuf), alpha);
+		b  = _mm256_or_si256(_mm256_shuffle_epi8(_mm256_unpackhi_epi8(hi, lo), shuf), alpha);
+		_mm256_storeu_si256((__m256i*)(dst + i), _mm256_permute2x128_si256(a, b, 0x20));
+		_mm256_storeu_si256((__m256i*)(dst + i + 8), _mm256_permute2x128_si256(a, b, 0x31));
+	}
+	color_row_c(src + i, dst + i, w - i);
+}
+#endif /* BLIT_X86 */
+
+
+#if BLIT_NEON
+/*
+ NEON color kernel, same method as SSSE3 using tbl for the table lookups
+ */
+static void color_row_neon(const uint16_t* src, uint32_t* dst, int w) {
+	const uint8x16_t nib   = vld1q_u8(blit_nibble);
+	const uint8x16_t shuf  = vld1q_u8(col_shuffle);
+	const uint8x16_t alpha = vreinterpretq_u8_u32(vdupq_n_u32(col_alpha));
+	const uint8x16_t mask  = vdupq_n_u8(0x0F);
+	uint8x16_t v, hi, lo;
+	uint8x16x2_t p;
+	int i;
+
+	for (i = 0; i + 8 <= w; i += 8) {
+		v  = vld1q_u8((const uint8_t*)(src + i));
+		hi = vqtbl1q_u8(nib, vshrq_n_u8(v, 4));
+		lo = vqtbl1q_u8(nib, vandq_u8(v, mask));
+		p  = vzipq_u8(hi, lo);
+		vst1q_u8((uint8_t*)(dst + i),     vorrq_u8(vqtbl1q_u8(p.val[0], shuf), alpha));
+		vst1q_u8((uint8_t*)(dst + i + 4), vorrq_u8(vqtbl1q_u8(p.val[1], shuf), alpha));
+	}
+	color_row_c(src + i, dst + i, w - i);
+}
+#endif /* BLIT_NEON */
+
+
+/*
+ Kernel selection
+ */
+static bool blit_kernel_supported(BLIT_KERNEL kernel) {
+	switch (kernel) {
+		case BLIT_KERNEL_C:
+			return true;
+#if BLIT_X86
+		case BLIT_KERNEL_SSSE3:
+			return SDL_HasSSE41(); /* SDL has no check for SSSE3, SSE4.1 implies it */
+		case BLIT_KERNEL_AVX2:
+			return SDL_HasAVX2();
+#endif
+#if BLIT_NEON
+		case BLIT_KERNEL_NEON:
+			return SDL_HasNEON();
+#endif
+		default:
+			return false;
+	}
+}
+
+bool Blit_SelectKernel(BLIT_KERNEL kernel) {
+	if (!blit_kernel_supported(kernel)) {
+		return false;
+	}
+	blit_kernel    = kernel;
+	blit_bw_row    = bw_row_c;
+	blit_color_row = color_row_c;
+
+	switch (kernel) {
+#if BLIT_X86
+		case BLIT_KERNEL_SSSE3:
+			blit_color_row = col_vector ? color_row_ssse3 : color_row_c;
+			break;
+		case BLIT_KERNEL_AVX2:
+			blit_bw_row    = bw_row_avx2;
+			blit_color_row = col_vector ? color_row_avx2 : color_row_c;
+			break;
+#endif
+#if BLIT_NEON
+		case BLIT_KERNEL_NEON:
+			blit_color_row = col_vector ? color_row_neon : color_row_c;
+			break;
+#endif
+		default:
+			break;
+	}
+	return true;
+}
+
+BLIT_KERNEL Blit_GetKernel(void) {
+	return blit_kernel;
+}
+
+const char* Blit_KernelName(BLIT_KERNEL kernel) {
+	switch (kernel) {
+		case BLIT_KERNEL_C:     return "C";
+		case BLIT_KERNEL_SSSE3: return "SSSE3";
+		case BLIT_KERNEL_AVX2:  return "AVX2";
+		case BLIT_KERNEL_NEON:  return "NEON";
+		default:                return "unknown";
+	}
+}
+
+/*
+ Build lookup tables for the given pixel format and select the fastest kernel
+ */
+void Blit_Init(SDL_PixelFormat format) {
+	const SDL_PixelFormatDetails* fmt = SDL_GetPixelFormatDetails(format);
+	int i, c;
+
+	blit_format = format;
+
+	for (i = 0; i < 4; i++) {
+		c = (~i & 3) * 0x55;
+		bw_pixel[i] = SDL_MapRGB(fmt, NULL, c, c, c);
+	}
+	for (i = 0; i < 0x100; i++) {
+		BW2RGB[i][0] = bw_pixel[(i>>6)&3];
+		BW2RGB[i][1] = bw_pixel[(i>>4)&3];
+		BW2RGB[i][2] = bw_pixel[(i>>2)&3];
+		BW2RGB[i][3] = bw_pixel[(i>>0)&3];
+	}
+	for (i = 0; i < 0x10000; i++) {
+		COL2RGB[SDL_Swap16BE(i)] = col2rgb(fmt, i);
+	}
+
+	/* Vector color kernels need 8-bit channels on byte boundaries */
+	col_vector = fmt->bytes_per_pixel == 4 &&
+	             fmt->Rbits == 8 && fmt->Gbits == 8 && fmt->Bbits == 8 &&
+	             (fmt->Rshift % 8) == 0 && (fmt->Gshift % 8) == 0 && (fmt->Bshift % 8) == 0;
+	if (col_vector) {
+		memset(col_shuffle, 0x80, sizeof(col_shuffle));
+		for (i = 0; i < 4; i++) {
+			col_shuffle[i * 4 + blit_byte(fmt->Rshift)] = i * 4 + 0;
+			col_shuffle[i * 4 + blit_byte(fmt->Gshift)] = i * 4 + 1;
+			col_shuffle[i * 4 + blit_byte(fmt->Bshift)] = i * 4 + 2;
+		}
+		col_alpha = SDL_MapRGB(fmt, NULL, 0, 0, 0);
+	}
+
+	for (i = BLIT_KERNEL_COUNT - 1; i > BLIT_KERNEL_C; i--) {
+		if (Blit_SelectKernel((BLIT_KERNEL)i)) {
+			break;
+		}
+	}
+	if (i == BLIT_KERNEL_C) {
+		Blit_SelectKernel(BLIT_KERNEL_C);
+	}
+}
+
+uint32_t Blit_MapColor(uint16_t col) {
+	return COL2RGB[SDL_Swap16BE(col)];
+}
+
+
+/*
+ BW format is 2 bit per pixel
+ */
+void Blit_BW(const uint8_t* src, int src_pitch, void* dst, int dst_pitch, int w, int h) {
+	uint8_t* d = (uint8_t*)dst;
+	int y;
+
+	for (y = 0; y < h; y++) {
+		blit_bw_row(src, d, w);
+		src += src_pitch;
+		d   += dst_pitch;
+	}
+}
+
+/*
+ Color format is 4 bit per pixel, big-endian: RGBX
+ */
+void Blit_Color(const uint16_t* src, int src_pitch, void* dst, int dst_pitch, int w, int h) {
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	int y;
+
+	for (y = 0; y < h; y++) {
+		blit_color_row((const uint16_t*)s, (uint32_t*)d, w);
+		s += src_pitch;
+		d += dst_pitch;
+	}
+}
+
+/*
+ Dimension format is 8 bit per pixel, big-endian: BBGGRRAA
+ */
+void Blit_Dimension(const uint32_t* src, int src_pitch, void* dst, int dst_pitch, int w, int h) {
+	const uint8_t* s = (const uint8_t*)src;
+	uint8_t* d = (uint8_t*)dst;
+	int y;
+
+	if (blit_format == SDL_PIXELFORMAT_BGRA32) {
+		/* Same byte order, copy rows */
+		for (y = 0; y < h; y++) {
+			memcpy(d, s, w * 4);
+			s += src_pitch;
+			d += dst_pitch;
+		}
+	} else {
+		SDL_ConvertPixels(w, h, SDL_PIXELFORMAT_BGRA32, src, src_pitch, blit_format, dst, dst_pitch);
+	}
+}
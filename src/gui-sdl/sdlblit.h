@@ -0,0 +1,39 @@
+/*
+  Previous - sdlblit.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_SDLBLIT_H
+#define PREV_SDLBLIT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <SDL3/SDL.h>
+
+typedef enum {
+	BLIT_KERNEL_C,
+	BLIT_KERNEL_SSSE3,
+	BLIT_KERNEL_AVX2,
+	BLIT_KERNEL_NEON,
+	BLIT_KERNEL_COUNT
+} BLIT_KERNEL;
+
+extern void Blit_Init(SDL_PixelFormat format);
+extern bool Blit_SelectKernel(BLIT_KERNEL kernel);
+extern BLIT_KERNEL Blit_GetKernel(void);
+extern const char* Blit_KernelName(BLIT_KERNEL kernel);
+extern uint32_t Blit_MapColor(uint16_t col);
+
+extern void Blit_BW(const uint8_t* src, int src_pitch, void* dst, int dst_pitch, int w, int h);
+extern void Blit_Color(const uint16_t* src, int src_pitch, void* dst, int dst_pitch, int w, int h);
+extern void Blit_Dimension(const uint32_t* src, int src_pitch, void* dst, int dst_pitch, int w, int h);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PREV_SDLBLIT_H */
@@ -459,9 +459,10 @@ void UI_Init(void) {
 	 * window grouping when you have multiple Previous SDL windows open */
 	SDL_SetAppMetadataProperty(SDL_PROP_APP_METADATA_IDENTIFIER_STRING, "com.sourceforge.previous");
 
-	/* Init SDL's video subsystem. Note: Audio subsystem
-	   will be initialized later (failure not fatal). */
-	if (SDL_Init(SDL_INIT_VIDEO) == false)
+	/* Init SDL's video subsystem, or only events if we run without
+	   display. Note: Audio subsystem will be initialized later
+	   (failure not fatal). */
+	if (SDL_Init(bHeadless ? SDL_INIT_EVENTS : SDL_INIT_VIDEO) == false)
 	{
 		Main_ErrorExit("Could not initialize the SDL library:", SDL_GetError(), -1);
 	}
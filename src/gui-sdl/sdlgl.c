@@ -0,0 +1,287 @@
+/*
+  Previous - sdlgl.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Draw the NeXT framebuffer with OpenGL. The raw 2-bit monochrome or 16-bit
+  RGBX video memory is uploaded as a small 8-bit texture and expanded to
+  RGB in a fragment shader, so no pixel conversion is done on the CPU. This
+  works alongside SDL's OpenGL renderer, which still draws the user
+  interface on top.
+*/
+const char SDLgl_fileid[] = "Previous sdlgl.c";
+
+#include "main.h"
+#include "log.h"
+#include "screen.h"
+#include "sdlgl.h"
+
+#include <SDL3/SDL_opengl.h>
+
+
+/* OpenGL functions used by the shader path, loaded at runtime */
+#define SCREENGL_FUNCTIONS \
+	GLFUNC(void,      GetIntegerv,        (GLenum pname, GLint* data)) \
+	GLFUNC(GLboolean, IsEnabled,          (GLenum cap)) \
+	GLFUNC(void,      Enable,             (GLenum cap)) \
+	GLFUNC(void,      Disable,            (GLenum cap)) \
+	GLFUNC(void,      Viewport,           (GLint x, GLint y, GLsizei w, GLsizei h)) \
+	GLFUNC(void,      GenTextures,        (GLsizei n, GLuint* textures)) \
+	GLFUNC(void,      BindTexture,        (GLenum target, GLuint texture)) \
+	GLFUNC(void,      TexParameteri,      (GLenum target, GLenum pname, GLint param)) \
+	GLFUNC(void,      TexImage2D,         (GLenum target, GLint level, GLint internalformat, GLsizei w, GLsizei h, GLint border, GLenum format, GLenum type, const void* pixels)) \
+	GLFUNC(void,      TexSubImage2D,      (GLenum target, GLint level, GLint x, GLint y, GLsizei w, GLsizei h, GLenum format, GLenum type, const void* pixels)) \
+	GLFUNC(void,      PixelStorei,        (GLenum pname, GLint param)) \
+	GLFUNC(void,      ActiveTexture,      (GLenum texture)) \
+	GLFUNC(void,      Begin,              (GLenum mode)) \
+	GLFUNC(void,      End,                (void)) \
+	GLFUNC(void,      TexCoord2f,         (GLfloat s, GLfloat t)) \
+	GLFUNC(void,      Vertex2f,           (GLfloat x, GLfloat y)) \
+	GLFUNC(GLuint,    CreateShader,       (GLenum type)) \
+	GLFUNC(void,      ShaderSource,       (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)) \
+	GLFUNC(void,      CompileShader,      (GLuint shader)) \
+	GLFUNC(void,      GetShaderiv,        (GLuint shader, GLenum pname, GLint* params)) \
+	GLFUNC(void,      GetShaderInfoLog,   (GLuint shader, GLsizei size, GLsizei* length, GLchar* log)) \
+	GLFUNC(void,      DeleteShader,       (GLuint shader)) \
+	GLFUNC(GLuint,    CreateProgram,      (void)) \
+	GLFUNC(void,      AttachShader,       (GLuint program, GLuint shader)) \
+	GLFUNC(void,      LinkProgram,        (GLuint program)) \
+	GLFUNC(void,      GetProgramiv,       (GLuint program, GLenum pname, GLint* params)) \
+	GLFUNC(void,      UseProgram,         (GLuint program)) \
+	GLFUNC(GLint,     GetUniformLocation, (GLuint program, const GLchar* name)) \
+	GLFUNC(void,      Uniform1i,          (GLint location, GLint v0)) \
+	GLFUNC(void,      Uniform2f,          (GLint location, GLfloat v0, GLfloat v1))
+
+#define GLFUNC(ret, name, args) ret (APIENTRY *name) args;
+static struct {
+	SCREENGL_FUNCTIONS
+} gl;
+#undef GLFUNC
+
+
+static const char* vertexShader =
+	"varying vec2 pos;\n"
+	"void main() {\n"
+	"	pos = gl_MultiTexCoord0.xy;\n"
+	"	gl_Position = gl_Vertex;\n"
+	"}\n";
+
+/* BW: 4 pixels per byte, most significant bits first, 0 is white */
+static const char* bwShader =
+	"uniform sampler2D vram;\n"
+	"uniform vec2 size;\n"
+	"varying vec2 pos;\n"
+	"void main() {\n"
+	"	float x = floor(pos.x);\n"
+	"	float y = floor(pos.y);\n"
+	"	float b = floor(texture2D(vram, vec2((floor(x / 4.0) + 0.5) / size.x, (y + 0.5) / size.y)).r * 255.0 + 0.5);\n"
+	"	float v = mod(floor(b / exp2(6.0 - 2.0 * mod(x, 4.0))), 4.0);\n"
+	"	gl_FragColor = vec4(vec3((3.0 - v) / 3.0), 1.0);\n"
+	"}\n";
+
+/* Color: big-endian RGBX, 4 bits per channel, bytes in luminance and alpha */
+static const char* colorShader =
+	"uniform sampler2D vram;\n"
+	"uniform vec2 size;\n"
+	"varying vec2 pos;\n"
+	"void main() {\n"
+	"	vec4 t = texture2D(vram, vec2((floor(pos.x) + 0.5) / size.x, (floor(pos.y) + 0.5) / size.y));\n"
+	"	float hi = floor(t.r * 255.0 + 0.5);\n"
+	"	float lo = floor(t.a * 255.0 + 0.5);\n"
+	"	gl_FragColor = vec4(floor(hi / 16.0) / 15.0, mod(hi, 16.0) / 15.0, floor(lo / 16.0) / 15.0, 1.0);\n"
+	"}\n";
+
+static bool   glInited;
+static bool   glFailed;
+static GLuint glTexture;
+static GLuint glProgram[2];     /* BW and color */
+static GLint  glSize[2];
+static int    texWidth;
+static bool   texColor;
+
+
+static bool ScreenGL_Load(void) {
+#define GLFUNC(ret, name, args) \
+	gl.name = (ret (APIENTRY *) args)SDL_GL_GetProcAddress("gl" #name); \
+	if (gl.name == NULL) { \
+		Log_Printf(LOG_WARN, "[Screen] OpenGL function gl" #name " not available"); \
+		return false; \
+	}
+	SCREENGL_FUNCTIONS
+#undef GLFUNC
+	return true;
+}
+
+static GLuint ScreenGL_Compile(GLenum type, const char* source) {
+	GLuint shader;
+	GLint  status;
+	char   log[512];
+
+	shader = gl.CreateShader(type);
+	gl.ShaderSource(shader, 1, &source, NULL);
+	gl.CompileShader(shader);
+	gl.GetShaderiv(shader, GL_COMPILE_STATUS, &status);
+	if (!status) {
+		gl.GetShaderInfoLog(shader, sizeof(log), NULL, log);
+		Log_Printf(LOG_WARN, "[Screen] Shader compilation failed: %s", log);
+		gl.DeleteShader(shader);
+		return 0;
+	}
+	return shader;
+}
+
+static GLuint ScreenGL_Link(const char* fragment, GLint* size) {
+	GLuint program, vs, fs;
+	GLint  status;
+
+	vs = ScreenGL_Compile(GL_VERTEX_SHADER, vertexShader);
+	fs = ScreenGL_Compile(GL_FRAGMENT_SHADER, fragment);
+	if (!vs || !fs) {
+		return 0;
+	}
+	program = gl.CreateProgram();
+	gl.AttachShader(program, vs);
+	gl.AttachShader(program, fs);
+	gl.LinkProgram(program);
+	gl.DeleteShader(vs);
+	gl.DeleteShader(fs);
+	gl.GetProgramiv(program, GL_LINK_STATUS, &status);
+	if (!status) {
+		Log_Printf(LOG_WARN, "[Screen] Shader linking failed");
+		return 0;
+	}
+	gl.UseProgram(program);
+	gl.Uniform1i(gl.GetUniformLocation(program, "vram"), 0);
+	*size = gl.GetUniformLocation(program, "size");
+	return program;
+}
+
+/* Called with the renderer's context current */
+static bool ScreenGL_Init(void) {
+	GLint program, texture;
+
+	if (!ScreenGL_Load()) {
+		return false;
+	}
+	gl.GetIntegerv(GL_CURRENT_PROGRAM, &program);
+	gl.GetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+
+	glProgram[0] = ScreenGL_Link(bwShader, &glSize[0]);
+	glProgram[1] = ScreenGL_Link(colorShader, &glSize[1]);
+
+	gl.GenTextures(1, &glTexture);
+	gl.BindTexture(GL_TEXTURE_2D, glTexture);
+	gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	gl.TexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	texWidth = 0;
+
+	gl.UseProgram(program);
+	gl.BindTexture(GL_TEXTURE_2D, texture);
+
+	if (!glProgram[0] || !glProgram[1]) {
+		return false;
+	}
+	Log_Printf(LOG_WARN, "[Screen] Converting framebuffer pixels with OpenGL shaders");
+	return true;
+}
+
+
+/*
+ Check if the renderer uses OpenGL
+ */
+bool ScreenGL_Supported(SDL_Renderer* renderer) {
+	const char* name = SDL_GetRendererName(renderer);
+	return name && !strcmp(name, "opengl");
+}
+
+/*
+ Draw video memory to the given viewport (OpenGL window coordinates).
+ SDL_FlushRenderer() must be called before. Returns false if shaders
+ can not be used.
+ */
+bool ScreenGL_Draw(const uint8_t* vram, int pitch, bool color, const SDL_Rect* viewport) {
+	GLint program, texture, active, vp[4], align, rowlen;
+	GLboolean blend, scissor;
+	GLenum format = color ? GL_LUMINANCE_ALPHA : GL_LUMINANCE;
+	int w = color ? pitch / 2 : pitch;
+
+	if (glFailed) {
+		return false;
+	}
+	if (!glInited) {
+		glInited = true;
+		if (!ScreenGL_Init()) {
+			Log_Printf(LOG_WARN, "[Screen] OpenGL shaders not available, using software conversion");
+			glFailed = true;
+			return false;
+		}
+	}
+
+	/* Save the state of SDL's renderer */
+	gl.GetIntegerv(GL_CURRENT_PROGRAM, &program);
+	gl.GetIntegerv(GL_ACTIVE_TEXTURE, &active);
+	gl.ActiveTexture(GL_TEXTURE0);
+	gl.GetIntegerv(GL_TEXTURE_BINDING_2D, &texture);
+	gl.GetIntegerv(GL_VIEWPORT, vp);
+	gl.GetIntegerv(GL_UNPACK_ALIGNMENT, &align);
+	gl.GetIntegerv(GL_UNPACK_ROW_LENGTH, &rowlen);
+	blend   = gl.IsEnabled(GL_BLEND);
+	scissor = gl.IsEnabled(GL_SCISSOR_TEST);
+
+	/* Upload raw video memory: 1 byte per texel for BW, 2 bytes for color */
+	gl.BindTexture(GL_TEXTURE_2D, glTexture);
+	gl.PixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	gl.PixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	if (w != texWidth || color != texColor) {
+		gl.TexImage2D(GL_TEXTURE_2D, 0, format, w, NeXT_SCRN_H, 0, format, GL_UNSIGNED_BYTE, vram);
+		texWidth = w;
+		texColor = color;
+	} else {
+		gl.TexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, w, NeXT_SCRN_H, format, GL_UNSIGNED_BYTE, vram);
+	}
+
+	/* Draw a quad, texture coordinates are in NeXT pixels */
+	gl.Disable(GL_BLEND);
+	gl.Disable(GL_SCISSOR_TEST);
+	gl.Viewport(viewport->x, viewport->y, viewport->w, viewport->h);
+	gl.UseProgram(glProgram[color ? 1 : 0]);
+	gl.Uniform2f(glSize[color ? 1 : 0], (GLfloat)w, (GLfloat)NeXT_SCRN_H);
+	gl.Begin(GL_TRIANGLE_STRIP);
+	gl.TexCoord2f(0.0f, (GLfloat)NeXT_SCRN_H);
+	gl.Vertex2f(-1.0f, -1.0f);
+	gl.TexCoord2f((GLfloat)NeXT_SCRN_W, (GLfloat)NeXT_SCRN_H);
+	gl.Vertex2f(1.0f, -1.0f);
+	gl.TexCoord2f(0.0f, 0.0f);
+	gl.Vertex2f(-1.0f, 1.0f);
+	gl.TexCoord2f((GLfloat)NeXT_SCRN_W, 0.0f);
+	gl.Vertex2f(1.0f, 1.0f);
+	gl.End();
+
+	/* Restore state */
+	gl.UseProgram(program);
+	gl.BindTexture(GL_TEXTURE_2D, texture);
+	gl.ActiveTexture(active);
+	gl.Viewport(vp[0], vp[1], vp[2], vp[3]);
+	gl.PixelStorei(GL_UNPACK_ALIGNMENT, align);
+	gl.PixelStorei(GL_UNPACK_ROW_LENGTH, rowlen);
+	if (blend) {
+		gl.Enable(GL_BLEND);
+	}
+	if (scissor) {
+		gl.Enable(GL_SCISSOR_TEST);
+	}
+	return true;
+}
+
+/*
+ Forget all OpenGL objects. Call when the renderer is destroyed.
+ */
+void ScreenGL_Reset(void) {
+	glInited  = false;
+	glFailed  = false;
+	glTexture = 0;
+	texWidth  = 0;
+}
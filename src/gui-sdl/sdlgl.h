@@ -0,0 +1,25 @@
+/*
+  Previous - sdlgl.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_SDLGL_H
+#define PREV_SDLGL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#include <SDL3/SDL.h>
+
+extern bool ScreenGL_Supported(SDL_Renderer* renderer);
+extern bool ScreenGL_Draw(const uint8_t* vram, int pitch, bool color, const SDL_Rect* viewport);
+extern void ScreenGL_Reset(void);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* PREV_SDLGL_H */
@@ -14,6 +14,15 @@ const char SDLhost_fileid[] = "Previous sdlhost.c";
 
 #include "host.h"
 
+#if defined(__linux__)
+#include <time.h>
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define HOST_HAVE_TSC 1
+#endif
+#endif
+
 
 void host_lock(lock_t* lock) {
 	SDL_LockSpinlock(lock);
@@ -105,12 +114,131 @@ void host_sleep_us(uint64_t us) {
 	SDL_DelayNS(us * 1000);
 }
 
+/* Clock source for host_get_counter(). On Linux the invariant TSC is read
+ * directly if the kernel trusts it as its own clocksource. Otherwise the
+ * raw monotonic clock is read through the vDSO. Elsewhere the SDL
+ * performance counter is used. */
+enum {
+	HOST_CLOCK_NONE,
+	HOST_CLOCK_SDL,
+	HOST_CLOCK_RAW,
+	HOST_CLOCK_TSC
+};
+
+static SDL_InitState hostClockInit;
+static int           hostClock = HOST_CLOCK_NONE;
+static uint64_t      hostClockFrequency;
+
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_RAW)
+static inline uint64_t host_clock_raw(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+	return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
+
+#if HOST_HAVE_TSC
+static bool host_clock_tsc_usable(void) {
+	unsigned int eax, ebx, ecx, edx;
+	char source[16] = "";
+	FILE* f;
+	
+	/* Invariant TSC runs at constant rate in all power states */
+	if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1 << 8))) {
+		return false;
+	}
+	/* The kernel checked that it is synchronized between cores */
+	f = fopen("/sys/devices/system/clocksource/clocksource0/current_clocksource", "r");
+	if (f) {
+		if (!fgets(source, sizeof(source), f)) {
+			source[0] = '\0';
+		}
+		fclose(f);
+	}
+	return strncmp(source, "tsc", 3) == 0;
+}
+
+/* Measure TSC frequency against the raw monotonic clock. The clock is read
+ * between two TSC reads and the narrowest of several tries is used, which
+ * bounds the error to the time of one undisturbed clock read. */
+static uint64_t host_clock_tsc_calibrate(void) {
+	uint64_t tsc[2], ns[2], t0, t1, ns0, best;
+	int i, j;
+	
+	for (i = 0; i < 2; i++) {
+		if (i) {
+			SDL_DelayNS(20000000);
+		}
+		best = UINT64_MAX;
+		for (j = 0; j < 8; j++) {
+			t0  = __rdtsc();
+			ns0 = host_clock_raw();
+			t1  = __rdtsc();
+			if (t1 - t0 < best) {
+				best   = t1 - t0;
+				ns[i]  = ns0;
+				tsc[i] = t0 + best / 2;
+			}
+		}
+	}
+	return (uint64_t)((double)(tsc[1] - tsc[0]) * 1e9 / (double)(ns[1] - ns[0]) + 0.5);
+}
+#endif
+
+static void host_clock_init(void) {
+	if (!SDL_ShouldInit(&hostClockInit)) {
+		return;
+	}
+#if HOST_HAVE_TSC
+	if (host_clock_tsc_usable()) {
+		hostClockFrequency = host_clock_tsc_calibrate();
+		hostClock          = HOST_CLOCK_TSC;
+	} else
+#endif
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_RAW)
+	{
+		hostClockFrequency = 1000000000ULL;
+		hostClock          = HOST_CLOCK_RAW;
+	}
+#else
+	{
+		hostClockFrequency = SDL_GetPerformanceFrequency();
+		hostClock          = HOST_CLOCK_SDL;
+	}
+#endif
+	SDL_SetInitialized(&hostClockInit, true);
+}
+
 uint64_t host_get_counter(void) {
-	return SDL_GetPerformanceCounter();
+	switch (hostClock) {
+#if HOST_HAVE_TSC
+		case HOST_CLOCK_TSC:
+			return __rdtsc();
+#endif
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_RAW)
+		case HOST_CLOCK_RAW:
+			return host_clock_raw();
+#endif
+		case HOST_CLOCK_SDL:
+			return SDL_GetPerformanceCounter();
+		default:
+			host_clock_init();
+			return host_get_counter();
+	}
 }
 
 uint64_t host_get_counter_frequency(void) {
-	return SDL_GetPerformanceFrequency();
+	host_clock_init();
+	return hostClockFrequency;
+}
+
+const char* host_get_counter_name(void) {
+	host_clock_init();
+	switch (hostClock) {
+		case HOST_CLOCK_TSC: return "TSC";
+		case HOST_CLOCK_RAW: return "CLOCK_MONOTONIC_RAW";
+		default:             return "SDL performance counter";
+	}
 }
 
 int host_num_cpus(void) {
@@ -17,6 +17,7 @@ const char SDLkeymap_fileid[] = "Previous sdlkeymap.c";
 #include "kms.h"
 #include "adb.h"
 #include "tablet.h"
+#include "replay.h"
 
 #define  LOG_KEYMAP_LEVEL   LOG_DEBUG
 
@@ -50,6 +51,7 @@ void Keymap_InitShortcutDefaultKeys(void)
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_COLDRESET]     = SDLK_C;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_SCREENSHOT]    = SDLK_G;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_RECORD]        = SDLK_R;
+	ConfigureParams.Shortcut.withModifier[SHORTCUT_VIDEO]         = SDLK_V;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_SOUND]         = SDLK_S;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_QUIT]          = SDLK_Q;
 	ConfigureParams.Shortcut.withModifier[SHORTCUT_DIMENSION]     = SDLK_N;
@@ -564,12 +566,106 @@ void Keymap_MouseWheel(const SDL_MouseWheelEvent *sdlwheel)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Input events for the emulated machine. They are passed as bytes, so that
+ * they can be recorded and replayed.
+ */
+enum {
+	KEYMAP_INPUT_KEY_DOWN,     /* modifiers, key */
+	KEYMAP_INPUT_KEY_UP,       /* modifiers, key */
+	KEYMAP_INPUT_MOUSE_MOVE,   /* xrel, yrel, x, y as 16 bit little endian */
+	KEYMAP_INPUT_MOUSE_BUTTON, /* left, down */
+	KEYMAP_INPUT_NUM
+};
+
+static const int KeymapInputLen[KEYMAP_INPUT_NUM] = { 3, 3, 9, 3 };
+
+static int Keymap_GetInt16(const uint8_t *p)
+{
+	return (int16_t)(p[0] | (p[1] << 8));
+}
+
+static void Keymap_PutInt16(uint8_t *p, int v)
+{
+	if      (v < INT16_MIN) v = INT16_MIN;
+	else if (v > INT16_MAX) v = INT16_MAX;
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+}
+
+static void Keymap_GuestInput(const uint8_t *in)
+{
+	bool bADB = ConfigureParams.System.bADB && ConfigureParams.System.bTurbo;
+	bool bTablet = ConfigureParams.Tablet.nTabletType && bTabletEnabled;
+
+	switch (in[0]) {
+		case KEYMAP_INPUT_KEY_DOWN:
+			if (bADB) {
+				adb_keydown(in[2]);
+			} else {
+				kms_keydown(in[1], in[2]);
+			}
+			break;
+		case KEYMAP_INPUT_KEY_UP:
+			if (bADB) {
+				adb_keyup(in[2]);
+			} else {
+				kms_keyup(in[1], in[2]);
+			}
+			break;
+		case KEYMAP_INPUT_MOUSE_MOVE:
+			if (bTablet) {
+				tablet_pen_move(Keymap_GetInt16(in+1), Keymap_GetInt16(in+3),
+				                Keymap_GetInt16(in+5), Keymap_GetInt16(in+7));
+			} else if (bADB) {
+				adb_mouse_move(Keymap_GetInt16(in+1), Keymap_GetInt16(in+3));
+			} else {
+				kms_mouse_move(Keymap_GetInt16(in+1), Keymap_GetInt16(in+3));
+			}
+			break;
+		case KEYMAP_INPUT_MOUSE_BUTTON:
+			if (bTablet) {
+				tablet_pen_button(in[1], in[2]);
+			} else if (bADB) {
+				adb_mouse_button(in[1], in[2]);
+			} else {
+				kms_mouse_button(in[1], in[2]);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+static void Keymap_Input(const uint8_t *in)
+{
+	/* Host input is ignored while replaying recorded input */
+	if (nReplayMode == REPLAY_PLAY)
+		return;
+
+	Replay_Record(REPLAY_INPUT, in, KeymapInputLen[in[0]]);
+	Keymap_GuestInput(in);
+}
+
+/**
+ * Deliver recorded input event
+ */
+void Keymap_ReplayInput(const uint8_t *data, int len)
+{
+	if (len > 0 && data[0] < KEYMAP_INPUT_NUM && len == KeymapInputLen[data[0]]) {
+		Keymap_GuestInput(data);
+	}
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * User pressed a key down
  */
 void Keymap_KeyDown(const SDL_KeyboardEvent *sdlkey)
 {
+	uint8_t in[3] = { KEYMAP_INPUT_KEY_DOWN };
 	uint8_t key;
 
 	if (ConfigureParams.Keyboard.nKeymapType == KEYMAP_SYMBOLIC) {
@@ -580,11 +676,9 @@ void Keymap_KeyDown(const SDL_KeyboardEvent *sdlkey)
 
 	Log_Printf(LOG_KEYMAP_LEVEL, "[Keymap] Press Keycode: $%02x\n", key);
 
-	if (ConfigureParams.System.bADB && ConfigureParams.System.bTurbo) {
-		adb_keydown(key);
-	} else {
-		kms_keydown(Keymap_GetModifiers(sdlkey->mod), key);
-	}
+	in[1] = Keymap_GetModifiers(sdlkey->mod);
+	in[2] = key;
+	Keymap_Input(in);
 }
 
 
@@ -594,6 +688,7 @@ void Keymap_KeyDown(const SDL_KeyboardEvent *sdlkey)
  */
 void Keymap_KeyUp(const SDL_KeyboardEvent *sdlkey)
 {
+	uint8_t in[3] = { KEYMAP_INPUT_KEY_UP };
 	uint8_t key;
 
 	if (ConfigureParams.Keyboard.nKeymapType == KEYMAP_SYMBOLIC) {
@@ -604,11 +699,9 @@ void Keymap_KeyUp(const SDL_KeyboardEvent *sdlkey)
 
 	Log_Printf(LOG_KEYMAP_LEVEL, "[Keymap] Release Keycode: $%02x\n", key);
 
-	if (ConfigureParams.System.bADB && ConfigureParams.System.bTurbo) {
-		adb_keyup(key);
-	} else {
-		kms_keyup(Keymap_GetModifiers(sdlkey->mod), key);
-	}
+	in[1] = Keymap_GetModifiers(sdlkey->mod);
+	in[2] = key;
+	Keymap_Input(in);
 }
 
 
@@ -618,13 +711,13 @@ void Keymap_KeyUp(const SDL_KeyboardEvent *sdlkey)
  */
 void Keymap_MouseMove(const SDL_MouseMotionEvent *sdlmotion)
 {
-	if (ConfigureParams.Tablet.nTabletType && bTabletEnabled) {
-		tablet_pen_move(sdlmotion->xrel, sdlmotion->yrel, sdlmotion->x, sdlmotion->y);
-	} else if (ConfigureParams.System.bADB && ConfigureParams.System.bTurbo) {
-		adb_mouse_move(sdlmotion->xrel, sdlmotion->yrel);
-	} else {
-		kms_mouse_move(sdlmotion->xrel, sdlmotion->yrel);
-	}
+	uint8_t in[9] = { KEYMAP_INPUT_MOUSE_MOVE };
+
+	Keymap_PutInt16(in+1, (int)sdlmotion->xrel);
+	Keymap_PutInt16(in+3, (int)sdlmotion->yrel);
+	Keymap_PutInt16(in+5, (int)sdlmotion->x);
+	Keymap_PutInt16(in+7, (int)sdlmotion->y);
+	Keymap_Input(in);
 }
 
 
@@ -634,13 +727,8 @@ void Keymap_MouseMove(const SDL_MouseMotionEvent *sdlmotion)
  */
 void Keymap_MouseDown(bool left)
 {
-	if (ConfigureParams.Tablet.nTabletType && bTabletEnabled) {
-		tablet_pen_button(left, true);
-	} else if (ConfigureParams.System.bADB && ConfigureParams.System.bTurbo) {
-		adb_mouse_button(left, true);
-	} else {
-		kms_mouse_button(left, true);
-	}
+	uint8_t in[3] = { KEYMAP_INPUT_MOUSE_BUTTON, left, true };
+	Keymap_Input(in);
 }
 
 
@@ -650,13 +738,8 @@ void Keymap_MouseDown(bool left)
  */
 void Keymap_MouseUp(bool left)
 {
-	if (ConfigureParams.Tablet.nTabletType && bTabletEnabled) {
-		tablet_pen_button(left, false);
-	} else if (ConfigureParams.System.bADB && ConfigureParams.System.bTurbo) {
-		adb_mouse_button(left, false);
-	} else {
-		kms_mouse_button(left, false);
-	}
+	uint8_t in[3] = { KEYMAP_INPUT_MOUSE_BUTTON, left, false };
+	Keymap_Input(in);
 }
 
 
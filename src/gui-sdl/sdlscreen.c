@@ -10,8 +10,11 @@ const char SDLscreen_fileid[] = "Previous sdlscreen.c";
 
 #include "main.h"
 #include "configuration.h"
+#include "log.h"
 #include "screen.h"
 #include "sdlscreen.h"
+#include "sdlblit.h"
+#include "sdlgl.h"
 #include "statusbar.h"
 #include "sdlstatusbar.h"
 #include "event.h"
@@ -20,6 +23,7 @@ const char SDLscreen_fileid[] = "Previous sdlscreen.c";
 #include "video.h"
 #include "keymap.h"
 #include "m68000.h"
+#include "hostprof.h"
 
 
 /* NeXT screen resolution */
@@ -57,49 +61,35 @@ static int           initScreenHeight; /* Save screen height at last init */
 static uint32_t      mask;             /* green screen mask for transparent UI areas */
 static void*         uiBuffer;         /* uiBuffer used for user interface texture */
 static SDL_SpinLock  uiBufferLock;     /* Lock for concurrent access to UI buffer between m68k thread and repainter */
+static bool          shaderConvert;    /* Convert NeXT framebuffer with OpenGL shaders */
+static SDL_AtomicInt framesPresented;  /* Frames shown since last report */
+static SDL_AtomicInt framesSkipped;    /* Frames skipped because nothing changed */
+
+typedef struct {
+	bool     valid;
+	int      slot;
+	bool     enabled;
+	uint32_t generation;
+} FRAME_STATE;
+
+static FRAME_STATE   fbState;          /* Last frame blitted to fbTexture */
+static FRAME_STATE   groupState[NUM_MONITORS];
 #ifdef ENABLE_RENDERING_THREAD
 static volatile bool doRepaint;        /* Repaint thread runs while true */
 static SDL_Thread*   repaintThread;
 #endif
 
 
-static uint32_t BW2RGB[0x100][4];
-static uint32_t COL2RGB[0x10000];
-
-static uint32_t bw2rgb(SDL_Surface* surf, int bw) {
-	int c = (~bw & 3) * 0x55;
-	return SDL_MapSurfaceRGB(surf, c, c, c);
-}
-
-static uint32_t col2rgb(SDL_Surface* surf, int col) {
-	int r = ((col >> 12) & 0x0F) * 0x11;
-	int g = ((col >>  8) & 0x0F) * 0x11;
-	int b = ((col >>  4) & 0x0F) * 0x11;
-	return SDL_MapSurfaceRGB(surf, r, g, b);
-}
-
 /*
  BW format is 2 bit per pixel
  */
 static void blitBW(SDL_Texture* tex) {
 	void* pixels;
-	uint8_t* src;
-	uint8_t* dst;
-	int pitch, src_padding, dst_padding, x, y;
+	int pitch, src_pitch;
 
 	SDL_LockTexture(tex, NULL, &pixels, &pitch);
-	src = NEXTVideo;
-	dst = (uint8_t*)pixels;
-	src_padding = ConfigureParams.System.bTurbo ? 0 : (32 / 4);
-	dst_padding = pitch - NeXT_SCRN_W * 4;
-	for (y = 0; y < NeXT_SCRN_H; y++) {
-		for (x = 0; x < NeXT_SCRN_W / 4; x++) {
-			memcpy(dst, BW2RGB[*src++], 16);
-			dst += 16;
-		}
-		src += src_padding;
-		dst += dst_padding;
-	}
+	src_pitch = (NeXT_SCRN_W + (ConfigureParams.System.bTurbo ? 0 : 32)) / 4;
+	Blit_BW(NEXTVideo, src_pitch, pixels, pitch, NeXT_SCRN_W, NeXT_SCRN_H);
 	SDL_UnlockTexture(tex);
 }
 
@@ -108,22 +98,11 @@ static void blitBW(SDL_Texture* tex) {
  */
 static void blitColor(SDL_Texture* tex) {
 	void* pixels;
-	uint16_t* src;
-	uint32_t* dst;
-	int pitch, src_padding, dst_padding, x, y;
+	int pitch, src_pitch;
 
 	SDL_LockTexture(tex, NULL, &pixels, &pitch);
-	src = (uint16_t*)NEXTVideo;
-	dst = (uint32_t*)pixels;
-	src_padding = ConfigureParams.System.bTurbo ? 0 : 32;
-	dst_padding = pitch / 4 - NeXT_SCRN_W;
-	for (y = 0; y < NeXT_SCRN_H; y++) {
-		for (x = 0; x < NeXT_SCRN_W; x++) {
-			*dst++ = COL2RGB[*src++];
-		}
-		src += src_padding;
-		dst += dst_padding;
-	}
+	src_pitch = (NeXT_SCRN_W + (ConfigureParams.System.bTurbo ? 0 : 32)) * 2;
+	Blit_Color((uint16_t*)NEXTVideo, src_pitch, pixels, pitch, NeXT_SCRN_W, NeXT_SCRN_H);
 	SDL_UnlockTexture(tex);
 }
 
@@ -134,19 +113,16 @@ void Screen_BlitDimension(uint32_t* vram, SDL_Texture* tex) {
 	void* src;
 	void* dst;
 	int src_pitch, dst_pitch;
-	SDL_PixelFormat src_format, dst_format;
 
 #if ND_STEP
 	src = &vram[0];
 #else
 	src = &vram[4];
 #endif
-	src_pitch  = (NeXT_SCRN_W + 32) * 4;
-	src_format = SDL_PIXELFORMAT_BGRA32;
-	dst_format = tex->format;
+	src_pitch = (NeXT_SCRN_W + 32) * 4;
 
 	SDL_LockTexture(tex, NULL, &dst, &dst_pitch);
-	SDL_ConvertPixels(NeXT_SCRN_W, NeXT_SCRN_H, src_format, src, src_pitch, dst_format, dst, dst_pitch);
+	Blit_Dimension(src, src_pitch, dst, dst_pitch, NeXT_SCRN_W, NeXT_SCRN_H);
 	SDL_UnlockTexture(tex);
 }
 
@@ -157,17 +133,63 @@ void Screen_Blank(SDL_Texture* tex) {
 	void* pixels;
 	int   pitch;
 	SDL_LockTexture(tex, NULL, &pixels, &pitch);
-	SDL_memset4(pixels, COL2RGB[0], pitch * NeXT_SCRN_H / 4);
+	SDL_memset4(pixels, Blit_MapColor(0x0000), pitch * NeXT_SCRN_H / 4);
 	SDL_UnlockTexture(tex);
 }
 
 /*
- Blit NeXT framebuffer to texture.
+ Check if video memory or blanking changed since the frame was last drawn.
+ The generation is read before blitting, so writes during the blit are
+ caught by the next check.
  */
-static bool blitScreen(int slot, SDL_Texture* tex) {
+static bool frameChanged(int slot, FRAME_STATE* state) {
+	bool     enabled;
+	uint32_t generation;
+
+	if (slot > 0) {
+		enabled    = nd_video_enabled(slot);
+		generation = nd_vram_generation(slot);
+	} else {
+		enabled    = Video_Enabled();
+		generation = NEXTVideoGeneration;
+	}
+	if (state->valid && state->slot == slot && state->enabled == enabled &&
+	    (!enabled || state->generation == generation)) {
+		return false;
+	}
+	state->valid      = true;
+	state->slot       = slot;
+	state->enabled    = enabled;
+	state->generation = generation;
+	return true;
+}
+
+/*
+ Count presented and skipped frames for the status report.
+ */
+void Screen_CountFrame(bool presented) {
+	SDL_AddAtomicInt(presented ? &framesPresented : &framesSkipped, 1);
+}
+
+const char* Screen_Report(uint64_t realTime, uint64_t hostTime) {
+	static char report[64];
+	int presented = SDL_SetAtomicInt(&framesPresented, 0);
+	int skipped   = SDL_SetAtomicInt(&framesSkipped, 0);
+	snprintf(report, sizeof(report), "presented:%d skipped:%d", presented, skipped);
+	return report;
+}
+
+/*
+ Blit NeXT framebuffer to texture. Returns false if there is no framebuffer
+ or if it did not change since the last blit.
+ */
+static bool blitScreen(int slot, SDL_Texture* tex, FRAME_STATE* state) {
 	if (slot > 0) {
 		uint32_t* vram = nd_vram_for_slot(slot);
 		if (vram) {
+			if (!frameChanged(slot, state)) {
+				return false;
+			}
 			if (nd_video_enabled(slot)) {
 				Screen_BlitDimension(vram, tex);
 			} else {
@@ -177,6 +199,9 @@ static bool blitScreen(int slot, SDL_Texture* tex) {
 		}
 	} else {
 		if (NEXTVideo) {
+			if (!frameChanged(slot, state)) {
+				return false;
+			}
 			if (Video_Enabled()) {
 				if (ConfigureParams.System.bColor) {
 					blitColor(tex);
@@ -206,15 +231,51 @@ static void blitUserInterface(SDL_Texture* tex) {
 	SDL_UnlockTexture(tex);
 }
 
+/*
+ Draw the NeXT framebuffer directly from video memory using OpenGL shaders.
+ */
+static bool Screen_ShaderRepaint(void) {
+	SDL_FRect logical;
+	SDL_Rect  viewport;
+	int       out_w, out_h, src_pitch;
+	float     sx, sy;
+
+	/* Let SDL submit pending commands before we touch the OpenGL state */
+	SDL_FlushRenderer(sdlRenderer);
+
+	/* Map the framebuffer rectangle to OpenGL window coordinates */
+	SDL_GetRenderLogicalPresentationRect(sdlRenderer, &logical);
+	SDL_GetCurrentRenderOutputSize(sdlRenderer, &out_w, &out_h);
+	sx = logical.w / width;
+	sy = logical.h / height;
+	viewport.x = (int)(logical.x + fbRect.x * sx);
+	viewport.w = (int)(fbRect.w * sx);
+	viewport.h = (int)(fbRect.h * sy);
+	viewport.y = out_h - ((int)(logical.y + fbRect.y * sy) + viewport.h);
+
+	if (ConfigureParams.System.bColor) {
+		src_pitch = (NeXT_SCRN_W + (ConfigureParams.System.bTurbo ? 0 : 32)) * 2;
+	} else {
+		src_pitch = (NeXT_SCRN_W + (ConfigureParams.System.bTurbo ? 0 : 32)) / 4;
+	}
+	return ScreenGL_Draw(NEXTVideo, src_pitch, ConfigureParams.System.bColor, &viewport);
+}
+
 /*
  Blits the NeXT framebuffer to the fbTexture, blends with the GUI surface and shows it.
  */
 static bool Screen_SingleRepaint(void) {
 	bool updateScreen = false;
+	bool useShader = false;
 
-	/* Blit the NeXT framebuffer to texture */
+	/* Blit the NeXT framebuffer to texture or leave it to the shaders */
 	if (bEmulationActive) {
-		updateScreen = blitScreen(ConfigureParams.Screen.nSingleModeSlot, fbTexture);
+		if (shaderConvert && ConfigureParams.Screen.nSingleModeSlot == 0 && NEXTVideo && Video_Enabled()) {
+			useShader = true;
+			updateScreen = frameChanged(0, &fbState);
+		} else {
+			updateScreen = blitScreen(ConfigureParams.Screen.nSingleModeSlot, fbTexture, &fbState);
+		}
 	}
 
 	/* Copy UI surface to texture */
@@ -226,11 +287,21 @@ static bool Screen_SingleRepaint(void) {
 	if (updateScreen) {
 		SDL_RenderClear(sdlRenderer);
 		/* Render NeXT framebuffer texture */
-		SDL_RenderTexture(sdlRenderer, fbTexture, NULL, &fbRect);
+		if (!useShader || !Screen_ShaderRepaint()) {
+			if (useShader) {
+				shaderConvert = false;
+				fbState.valid = false;
+				blitScreen(0, fbTexture, &fbState);
+			}
+			SDL_RenderTexture(sdlRenderer, fbTexture, NULL, &fbRect);
+		}
 		SDL_RenderTexture(sdlRenderer, uiTexture, NULL, &uiRect);
 		/* Sleeps until next VSYNC if enabled in ScreenInit */
 		SDL_RenderPresent(sdlRenderer);
 	}
+	if (bEmulationActive) {
+		Screen_CountFrame(updateScreen);
+	}
 
 	return updateScreen;
 }
@@ -243,7 +314,7 @@ static bool Screen_GroupRepaint(void) {
 	if (bEmulationActive) {
 		for (i = 0; i < NUM_MONITORS; i++) {
 			if (groupTexture[i]) {
-				if (blitScreen(i * 2, groupTexture[i])) {
+				if (blitScreen(i * 2, groupTexture[i], &groupState[i])) {
 					updateScreen = true;
 				}
 			}
@@ -268,20 +339,34 @@ static bool Screen_GroupRepaint(void) {
 		/* Sleeps until next VSYNC if enabled in ScreenInit */
 		SDL_RenderPresent(sdlRenderer);
 	}
+	if (bEmulationActive) {
+		Screen_CountFrame(updateScreen);
+	}
 	
 	return updateScreen;
 }
 
 bool Screen_Repaint(void) {
+	uint16_t tags;
+	bool updated;
+
+	if (bHeadless) {
+		return false;
+	}
+	tags = HostProf_Enter(HOSTPROF_REPAINT);
 	if (initScreenMode == SCREEN_GROUP) {
-		return Screen_GroupRepaint();
+		updated = Screen_GroupRepaint();
+	} else {
+		updated = Screen_SingleRepaint();
 	}
-	return Screen_SingleRepaint();
+	HostProf_Leave(tags);
+	return updated;
 }
 
 #ifdef ENABLE_RENDERING_THREAD
 static int repainter(void* unused) {
 	SDL_SetCurrentThreadPriority(SDL_THREAD_PRIORITY_NORMAL);
+	HostProf_SetThread("repaint");
 
 	/* Enter repaint loop */
 	while (doRepaint) {
@@ -311,6 +396,8 @@ static void Screen_ForceRepaint(void) {
  * Set Previous window title. Use NULL for default
  */
 static void Screen_SetTitle(const char *title) {
+	if (bHeadless)
+		return;
 	if (title)
 		SDL_SetWindowTitle(sdlWindow, title);
 	else
@@ -327,6 +414,11 @@ static void Screen_ModeChanged(void) {
 		return;
 	}
 
+	if (bHeadless) {
+		/* no windows */
+		return;
+	}
+
 	/* Do not use multiple windows in full screen mode */
 	if (bInFullScreen) {
 		saveScreenMode = ConfigureParams.Screen.nMode;
@@ -490,33 +582,35 @@ void Screen_Reset(void) {
 		SDL_Rect windowBounds;
 		uint32_t r, g, b, a;
 
-		fprintf(stderr, "SDL screen request: %d x %d (%s)\n", width, height, bInFullScreen ? "fullscreen" : "windowed");
+		if (!bHeadless) {
+			fprintf(stderr, "SDL screen request: %d x %d (%s)\n", width, height, bInFullScreen ? "fullscreen" : "windowed");
 
-		Screen_GetWindowBounds(&windowBounds);
+			Screen_GetWindowBounds(&windowBounds);
 
-		SDL_SetWindowAspectRatio(sdlWindow, (float)width/height, (float)width/height);
+			SDL_SetWindowAspectRatio(sdlWindow, (float)width/height, (float)width/height);
 
-		if (bInFullScreen) {
-			/* If we are in full screen change saved window sizes */
-			saveWindowBounds = windowBounds;
-			SDL_SetRenderLogicalPresentation(sdlRenderer, width, height, SDL_LOGICAL_PRESENTATION_LETTERBOX);
-		} else {
-			/* Set new window size */
-			SDL_SetRenderLogicalPresentation(sdlRenderer, width, height, SDL_LOGICAL_PRESENTATION_STRETCH);
-			SDL_SetWindowSize(sdlWindow, windowBounds.w, windowBounds.h);
-			SDL_SetWindowPosition(sdlWindow, windowBounds.x, windowBounds.y);
-		}
+			if (bInFullScreen) {
+				/* If we are in full screen change saved window sizes */
+				saveWindowBounds = windowBounds;
+				SDL_SetRenderLogicalPresentation(sdlRenderer, width, height, SDL_LOGICAL_PRESENTATION_LETTERBOX);
+			} else {
+				/* Set new window size */
+				SDL_SetRenderLogicalPresentation(sdlRenderer, width, height, SDL_LOGICAL_PRESENTATION_STRETCH);
+				SDL_SetWindowSize(sdlWindow, windowBounds.w, windowBounds.h);
+				SDL_SetWindowPosition(sdlWindow, windowBounds.x, windowBounds.y);
+			}
 
-		/* (Re-)initialise UI texture */
-		if (uiTexture) {
-			SDL_DestroyTexture(uiTexture);
-			uiTexture = NULL;
-		}
-		uiTexture = SDL_CreateTexture(sdlRenderer, format, SDL_TEXTUREACCESS_STREAMING, width, height);
-		if (!uiTexture) {
-			Main_ErrorExit("Failed to create texture:", SDL_GetError(), -1);
+			/* (Re-)initialise UI texture */
+			if (uiTexture) {
+				SDL_DestroyTexture(uiTexture);
+				uiTexture = NULL;
+			}
+			uiTexture = SDL_CreateTexture(sdlRenderer, format, SDL_TEXTUREACCESS_STREAMING, width, height);
+			if (!uiTexture) {
+				Main_ErrorExit("Failed to create texture:", SDL_GetError(), -1);
+			}
+			SDL_SetTextureBlendMode(uiTexture, SDL_BLENDMODE_BLEND);
 		}
-		SDL_SetTextureBlendMode(uiTexture, SDL_BLENDMODE_BLEND);
 
 		/* Get color masks */
 		SDL_GetMasksForPixelFormat(format, &d, &r, &g, &b, &a);
@@ -549,7 +643,7 @@ void Screen_Reset(void) {
 	}
 
 	/* Create framebuffer textures and start with blank screen */
-	for (i = 0; i < NUM_MONITORS; i++) {
+	for (i = 0; i < NUM_MONITORS && !bHeadless; i++) {
 		if (ConfigureParams.Screen.nGroupModePos[i] < 0 || ConfigureParams.Screen.nMode != SCREEN_GROUP) {
 			if (groupTexture[i]) {
 				SDL_DestroyTexture(groupTexture[i]);
@@ -560,7 +654,7 @@ void Screen_Reset(void) {
 			Screen_Blank(groupTexture[i]);
 		}
 	}
-	if (ConfigureParams.Screen.nMode == SCREEN_GROUP) {
+	if (ConfigureParams.Screen.nMode == SCREEN_GROUP || bHeadless) {
 		if (fbTexture) {
 			SDL_DestroyTexture(fbTexture);
 			fbTexture = NULL;
@@ -570,6 +664,12 @@ void Screen_Reset(void) {
 		Screen_Blank(fbTexture);
 	}
 
+	/* Redraw all framebuffers on next repaint */
+	fbState.valid = false;
+	for (i = 0; i < NUM_MONITORS; i++) {
+		groupState[i].valid = false;
+	}
+
 	/* Save mode and sizes */
 	initScreenMode   = ConfigureParams.Screen.nMode;
 	initScreenWidth  = width;
@@ -581,6 +681,10 @@ void Screen_Reset(void) {
 		Statusbar_Update(sdlscrn);
 	}
 
+	if (bHeadless) {
+		return;
+	}
+
 #ifdef ENABLE_RENDERING_THREAD
 	/* Start repaint thread */
 	doRepaint = true;
@@ -596,9 +700,18 @@ void Screen_Reset(void) {
  * Init Screen, create window, renderer and textures
  */
 void Screen_Init(void) {
-	int i;
-
 	SDL_WindowFlags flags = SDL_WINDOW_RESIZABLE | SDL_WINDOW_HIGH_PIXEL_DENSITY;
+
+	if (bHeadless) {
+		/* No window and renderer, keep the user interface surface for the statusbar */
+		Screen_Reset();
+		Blit_Init(sdlscrn->format);
+		Log_Printf(LOG_WARN, "[Screen] Running headless, no window created");
+		return;
+	}
+	if (ConfigureParams.Screen.bShaderConvert) {
+		SDL_SetHint(SDL_HINT_RENDER_DRIVER, "opengl");
+	}
 	if (SDL_CreateWindowAndRenderer(PROG_NAME, width, height, flags, &sdlWindow, &sdlRenderer) == false) {
 		Main_ErrorExit("Failed to create window and renderer:", SDL_GetError(), -1);
 	}
@@ -609,15 +722,14 @@ void Screen_Init(void) {
 	/* Initialise textures and screen surface */
 	Screen_Reset();
 
-	/* Setup lookup tables */
-	for (i = 0; i < 0x100; i++) {
-		BW2RGB[i][0] = bw2rgb(sdlscrn, i>>6);
-		BW2RGB[i][1] = bw2rgb(sdlscrn, i>>4);
-		BW2RGB[i][2] = bw2rgb(sdlscrn, i>>2);
-		BW2RGB[i][3] = bw2rgb(sdlscrn, i>>0);
-	}
-	for (i = 0; i < 0x10000; i++) {
-		COL2RGB[SDL_Swap16BE(i)] = col2rgb(sdlscrn, i);
+	/* Setup lookup tables and pixel conversion kernels */
+	Blit_Init(sdlscrn->format);
+	Log_Printf(LOG_WARN, "[Screen] Using %s pixel conversion", Blit_KernelName(Blit_GetKernel()));
+	if (ConfigureParams.Screen.bShaderConvert) {
+		shaderConvert = ScreenGL_Supported(sdlRenderer);
+		if (!shaderConvert) {
+			Log_Printf(LOG_WARN, "[Screen] OpenGL renderer not available, shader conversion disabled");
+		}
 	}
 
 	/* Set title, cursor visibility and mouse grab */
@@ -647,6 +759,9 @@ void Screen_UnInit(void) {
 #endif
 	free(uiBuffer);
 	SDL_DestroySurface(sdlscrn);
+	if (bHeadless) {
+		return;
+	}
 	SDL_DestroyTexture(uiTexture);
 	if (fbTexture) {
 		SDL_DestroyTexture(fbTexture);
@@ -657,6 +772,7 @@ void Screen_UnInit(void) {
 		}
 	}
 	SDL_DestroyRenderer(sdlRenderer);
+	ScreenGL_Reset();
 	SDL_DestroyWindow(sdlWindow);
 }
 
@@ -667,7 +783,7 @@ void Screen_UnInit(void) {
 void Screen_EnterFullScreen(void) {
 	bool bWasRunning;
 
-	if (!bInFullScreen) {
+	if (!bInFullScreen && !bHeadless) {
 		/* Hold things... */
 		bWasRunning = Main_PauseEmulation(false);
 		bInFullScreen = true;
@@ -736,6 +852,9 @@ void Screen_ReturnFromFullScreen(void) {
  * Set mouse grab.
  */
 void Screen_SetMouseGrab(bool grab) {
+	if (bHeadless) {
+		return;
+	}
 	/* If emulation is active, set the mouse cursor mode now: */
 	if (grab) {
 		if (bEmulationActive) {
@@ -766,7 +885,7 @@ void Screen_SetMouseGrab(bool grab) {
  * Show main window
  */
 void Screen_ShowMainWindow(void) {
-	if (!bInFullScreen) {
+	if (!bInFullScreen && !bHeadless) {
 		SDL_RestoreWindow(sdlWindow);
 		SDL_RaiseWindow(sdlWindow);
 	}
@@ -779,7 +898,7 @@ void Screen_ShowMainWindow(void) {
 void Screen_SizeChanged(void) {
 	int h;
 
-	if (!bInFullScreen) {
+	if (!bInFullScreen && !bHeadless) {
 		SDL_GetWindowSize(sdlWindow, NULL, &h);
 		nd_sdl_resize((float)h/height);
 	}
@@ -790,7 +909,7 @@ void Screen_SizeChanged(void) {
  * Set visibilty of title bar.
  */
 void Screen_TitlebarChanged(void) {
-	if (sdlscrn && !bInFullScreen) {
+	if (sdlscrn && !bInFullScreen && !bHeadless) {
 		SDL_SetWindowBordered(sdlWindow, ConfigureParams.Screen.bShowTitlebar);
 		nd_sdl_titlebar(ConfigureParams.Screen.bShowTitlebar);
 	}
@@ -823,6 +942,10 @@ void Screen_StatusbarUpdate(void) {
 void Screen_UpdateRects(SDL_Surface *screen, int numrects, SDL_Rect *rects) {
 	bool doUIblit = true;
 
+	if (bHeadless) {
+		return;
+	}
+
 	while (numrects--) {
 		doUIblit = (rects->y < statusBar.y);
 		if (doUIblit) {
@@ -869,6 +992,9 @@ void Screen_UpdateRect(SDL_Surface *screen, int32_t x, int32_t y, int32_t w, int
 bool Screen_ShowCursor(bool show) {
 	bool bOldVisibility;
 	
+	if (bHeadless) {
+		return false;
+	}
 	bOldVisibility = SDL_CursorVisible();
 	if (bOldVisibility != show) {
 		if (show) {
@@ -885,6 +1011,9 @@ bool Screen_ShowCursor(bool show) {
  * Set mouse cursor to the center of the screen.
  */
 void Screen_CenterCursor(void) {
+	if (bHeadless) {
+		return;
+	}
 	SDL_WarpMouseInWindow(sdlWindow, sdlscrn->w/2, sdlscrn->h/2);
 	GuiEvent_WarpMouse();
 }
@@ -21,6 +21,7 @@ extern void Screen_UpdateRects(SDL_Surface *screen, int numrects, SDL_Rect *rect
 extern void Screen_UpdateRect(SDL_Surface *screen, int32_t x, int32_t y, int32_t w, int32_t h);
 extern void Screen_BlitDimension(uint32_t* vram, SDL_Texture* tex);
 extern void Screen_Blank(SDL_Texture* tex);
+extern void Screen_CountFrame(bool presented);
 
 extern bool Screen_Repaint(void);
 extern void Screen_SizeChanged(void);
@@ -0,0 +1,182 @@
+/*
+  Previous - hostprof.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Sampling profiler for host time spent in emulated subsystems.
+
+  Threads name themselves with HostProf_SetThread() and tag the emulated
+  subsystem they are running with HostProf_Enter()/HostProf_Leave(). While
+  profiling, SIGPROF is raised periodically by a CPU time interval timer.
+  The signal handler counts a sample for the thread and subsystem tags
+  active in the interrupted thread. On stop the counts are written as
+  folded stacks ("thread;subsystem;subsystem count" lines), which can be
+  turned into a flame graph with flamegraph.pl or loaded into speedscope.
+*/
+const char HostProf_fileid[] = "Previous hostprof.c";
+
+#include "config.h"
+
+#if HAVE_SETITIMER
+#include <signal.h>
+#include <sys/time.h>
+#endif
+
+#include <inttypes.h>
+
+#include "main.h"
+#include "host.h"
+#include "hostprof.h"
+
+#define HOSTPROF_THREADS 16
+#define HOSTPROF_TAGS    0x1000
+
+static const char* SubsystemNames[HOSTPROF_MAX] = {
+	NULL, "cycint", "dsp", "i860", "mmu", "scsi", "file", "slirp", "repaint"
+};
+
+HOSTPROF_TLS volatile uint16_t HostProf_Tags;
+static HOSTPROF_TLS volatile int ThreadSlot;
+
+/* Slot 0 is for threads which have not named themselves */
+static const char* ThreadNames[HOSTPROF_THREADS] = { "other" };
+static int ThreadCount = 1;
+static lock_t ThreadLock;
+
+/* Kept allocated so that a late signal can never touch freed memory */
+static uint32_t Samples[HOSTPROF_THREADS][HOSTPROF_TAGS];
+static volatile bool bProfiling;
+static char* Filename;
+static FILE* OutFile;
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Name the calling thread for the profile. Threads with the same name
+ * share their samples.
+ */
+void HostProf_SetThread(const char* name) {
+	int i;
+
+	host_lock(&ThreadLock);
+	for (i = 1; i < ThreadCount; i++) {
+		if (strcmp(ThreadNames[i], name) == 0) {
+			break;
+		}
+	}
+	if (i == ThreadCount && ThreadCount < HOSTPROF_THREADS) {
+		ThreadNames[ThreadCount++] = name;
+	}
+	host_unlock(&ThreadLock);
+
+	ThreadSlot = (i < HOSTPROF_THREADS) ? i : 0;
+	HostProf_Tags = 0;
+}
+
+#if HAVE_SETITIMER
+/*-----------------------------------------------------------------------*/
+/**
+ * SIGPROF handler, count a sample for the interrupted thread.
+ */
+static void HostProf_Sample(int sig) {
+	if (bProfiling) {
+		Samples[ThreadSlot][HostProf_Tags]++;
+	}
+}
+#endif
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Start sampling given number of times per second of CPU time used.
+ * Samples are written to the given file when profiling is stopped.
+ */
+bool HostProf_Start(const char* filename, int hz) {
+#if HAVE_SETITIMER
+	struct sigaction action;
+	struct itimerval timer;
+
+	if (bProfiling) {
+		fprintf(stderr, "Host profiling is already running.\n");
+		return false;
+	}
+	if (hz <= 0 || hz > 10000) {
+		hz = 997;
+	}
+	OutFile = fopen(filename, "w");
+	if (!OutFile) {
+		fprintf(stderr, "ERROR: can't open '%s' for writing host profile\n", filename);
+		return false;
+	}
+	memset(Samples, 0, sizeof(Samples));
+	free(Filename);
+	Filename = strdup(filename);
+
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = HostProf_Sample;
+	action.sa_flags = SA_RESTART;
+	sigemptyset(&action.sa_mask);
+	if (sigaction(SIGPROF, &action, NULL) != 0) {
+		perror("ERROR: installing SIGPROF handler failed");
+		fclose(OutFile);
+		return false;
+	}
+	bProfiling = true;
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = 1000000 / hz;
+	timer.it_value = timer.it_interval;
+	if (setitimer(ITIMER_PROF, &timer, NULL) != 0) {
+		perror("ERROR: starting profiling timer failed");
+		bProfiling = false;
+		fclose(OutFile);
+		return false;
+	}
+	fprintf(stderr, "Host profiling started at %d Hz.\n", hz);
+	return true;
+#else
+	fprintf(stderr, "Host profiling is not supported on this platform.\n");
+	return false;
+#endif
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Stop sampling and write collected samples as folded stacks.
+ */
+void HostProf_Stop(void) {
+#if HAVE_SETITIMER
+	struct itimerval timer;
+	FILE* out = OutFile;
+	uint64_t total = 0;
+	int t, tags, shift, sub;
+
+	if (!bProfiling) {
+		return;
+	}
+	memset(&timer, 0, sizeof(timer));
+	setitimer(ITIMER_PROF, &timer, NULL);
+	bProfiling = false;
+	/* Keep the handler: a SIGPROF still pending on another thread
+	 * would terminate the emulator with the default action */
+
+	for (t = 0; t < ThreadCount; t++) {
+		for (tags = 0; tags < HOSTPROF_TAGS; tags++) {
+			if (!Samples[t][tags]) {
+				continue;
+			}
+			fputs(ThreadNames[t], out);
+			for (shift = 8; shift >= 0; shift -= 4) {
+				sub = (tags >> shift) & 0xf;
+				if (sub && sub < HOSTPROF_MAX) {
+					fprintf(out, ";%s", SubsystemNames[sub]);
+				}
+			}
+			fprintf(out, " %u\n", Samples[t][tags]);
+			total += Samples[t][tags];
+		}
+	}
+	fclose(out);
+	fprintf(stderr, "Host profiling stopped, %"PRIu64" samples written to '%s'.\n", total, Filename);
+#endif
+}
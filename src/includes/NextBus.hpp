@@ -37,6 +37,7 @@ extern void nextbus_board_bput(uaecptr addr, uae_u32 val);
 
 extern void NextBus_Reset(void);
 extern void NextBus_Pause(bool pause);
+extern void NextBus_MemorySnapShot_Capture(bool bSave);
 
 #ifdef __cplusplus
 }
@@ -71,6 +72,7 @@ public:
     
     virtual void   reset(void);
     virtual void   pause(bool pause);
+    virtual void   snapshot(bool save);
 };
 
 class NextBusBoard : public NextBusSlot {
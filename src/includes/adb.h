@@ -111,5 +111,6 @@ extern void adb_mouse_button(bool left, bool down);
 extern void adb_mouse_move(int x, int y);
 
 extern void adb_reset(void);
+extern void ADB_MemorySnapShot_Capture(bool bSave);
 
 #endif /* PREV_ADB_H */
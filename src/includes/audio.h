@@ -16,6 +16,7 @@ extern void Audio_Output_Queue_Put(uint8_t* data, int len);
 extern void Audio_Output_Queue_Flush(void);
 extern void Audio_Output_Queue_Clear(void);
 extern int  Audio_Output_Queue_Size(void);
+extern const char* Audio_Report(uint64_t realTime, uint64_t hostTime);
 
 extern void Audio_Input_InitAndEnable(int channels, int freq);
 extern void Audio_Input_UnInit(void);
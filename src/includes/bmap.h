@@ -22,5 +22,6 @@ extern int bmap_hreq_enable;
 extern int bmap_txdn_enable;
 
 extern void BMAP_Reset(void);
+extern void BMAP_MemorySnapShot_Capture(bool bSave);
 
 #endif /* PREV_BMAP_H */
@@ -65,10 +65,18 @@ typedef struct
 
 
 /* Sound configuration */
+typedef enum
+{
+  SOUNDGRAB_AIFF,
+  SOUNDGRAB_FLAC,
+  SOUNDGRAB_RAW
+} SOUNDGRABFORMAT;
+
 typedef struct
 {
   bool bEnableMicrophone;
   bool bEnableSound;
+  SOUNDGRABFORMAT nGrabFormat;    /* File format for recorded sound */
 } CNF_SOUND;
 
 /* Dialog Keyboard */
@@ -94,6 +102,7 @@ typedef enum {
   SHORTCUT_COLDRESET,
   SHORTCUT_SCREENSHOT,
   SHORTCUT_RECORD,
+  SHORTCUT_VIDEO,
   SHORTCUT_SOUND,
   SHORTCUT_DEBUG_M68K,
   SHORTCUT_DEBUG_I860,
@@ -258,7 +267,8 @@ typedef struct {
 typedef enum
 {
   ENET_SLIRP,
-  ENET_PCAP
+  ENET_PCAP,
+  ENET_TAP
 } ENET_INTERFACE;
 
 typedef struct {
@@ -287,6 +297,7 @@ typedef struct
   bool bFullScreen;
   bool bShowStatusbar;
   bool bShowTitlebar;
+  bool bShaderConvert;
 } CNF_SCREEN;
 
 
@@ -369,6 +380,7 @@ typedef struct
   bool bCompatibleCpu;            /* Prefetch mode */
   MACHINETYPE nMachineType;
   bool bRealtime;                 /* TRUE if realtime sources shoud be used */
+  bool bMaxSpeed;                 /* TRUE to run as fast as possible */
   DSPTYPE nDSPType;               /* how to "emulate" DSP */
   bool bDSPMemoryExpansion;
   FPUTYPE n_FPUType;
@@ -43,6 +43,7 @@ extern uint64_t nCyclesMainCounter;
 
 extern void CycInt_Reset(void);
 extern void CycInt_AddCycles(int Cycles);
+extern int  CycInt_Idle(void);
 extern void CycInt_AddCyclesEvent(uint64_t Cycles, event_id i);
 extern void CycInt_UpdateCyclesEvent(uint64_t Cycles, event_id i);
 extern void CycInt_AddTimeEvent(uint64_t RealTime, uint64_t FastTime, event_id i);
@@ -51,6 +52,7 @@ extern void CycInt_AddCycleTimeEvent(uint64_t CycleTime, uint64_t FastTime, even
 extern void CycInt_UpdateCycleTimeEvent(uint64_t CycleTime, uint64_t FastTime, event_id i);
 extern void CycInt_RemovePendingEvent(event_id i);
 extern bool CycInt_EventPending(event_id i);
+extern void CycInt_MemorySnapShot_Capture(bool bSave);
 
 #ifdef __cplusplus
 }
@@ -41,6 +41,7 @@ extern void tdma_esp_flush_buffer(void);
 
 /* Reset function */
 extern void DMA_Reset(void);
+extern void DMA_MemorySnapShot_Capture(bool bSave);
 
 /* Device functions */
 extern void dma_esp_write_memory(void);
@@ -0,0 +1,17 @@
+/*
+  Previous - enet_capture.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_ENET_CAPTURE_H
+#define PREV_ENET_CAPTURE_H
+
+extern volatile bool enet_capture_enabled;
+
+extern void enet_capture_packet(const uint8_t *pkt, int len, bool out);
+extern bool enet_capture_start(const char *path, uint64_t maxsize, int maxfiles);
+extern void enet_capture_stop(void);
+
+#endif /* PREV_ENET_CAPTURE_H */
@@ -0,0 +1,17 @@
+/*
+  Previous - enet_tap.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_ENET_TAP_H
+#define PREV_ENET_TAP_H
+
+extern void enet_tap_queue_poll(void);
+extern void enet_tap_input(uint8_t *pkt, int pkt_len);
+extern void enet_tap_stop(void);
+extern void enet_tap_start(uint8_t *mac);
+extern void enet_tap_uninit(void);
+
+#endif /* PREV_ENET_TAP_H */
@@ -97,5 +97,6 @@ extern bool ESP_Receive_Ready(void);
 extern void ESP_Receive_Data(uint8_t val);
 
 extern void ESP_Reset(void);
+extern void ESP_MemorySnapShot_Capture(bool bSave);
 
 #endif /* PREV_ESP_H */
@@ -51,6 +51,7 @@ extern EthernetBuffer enet_rx_buffer;
 
 extern void Ethernet_IO_Handler(void);
 extern void Ethernet_Reset(bool hard);
+extern void Ethernet_MemorySnapShot_Capture(bool bSave);
 extern void Ethernet_UnInit(void);
 extern void enet_receive(uint8_t *pkt, int len);
 
@@ -27,6 +27,7 @@ extern void FLP_Control_Write(void);
 extern void Floppy_IO_Handler(void);
 
 extern void Floppy_Reset(void);
+extern void Floppy_MemorySnapShot_Capture(bool bSave);
 extern int  Floppy_Insert(int drive);
 extern void Floppy_Eject(int drive);
 
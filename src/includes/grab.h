@@ -14,8 +14,13 @@ extern void Grab_Print(uint8_t* data, int width, int height, int dpi);
 extern void Grab_Sound(uint8_t* samples, int len);
 extern void Grab_SoundToggle(void);
 
+extern void Grab_VideoFrame(void);
+extern void Grab_VideoToggle(void);
+extern const char* Grab_Report(uint64_t realTime, uint64_t hostTime);
+
 extern void Grab_Stop(void);
 
 extern volatile bool bRecordingAiff;
+extern volatile bool bRecordingVideo;
 
 #endif /* PREV_GRAB_H */
@@ -47,6 +47,7 @@ extern void         host_sleep_ms(uint32_t ms);
 extern void         host_sleep_us(uint64_t us);
 extern uint64_t     host_get_counter(void);
 extern uint64_t     host_get_counter_frequency(void);
+extern const char*  host_get_counter_name(void);
 extern int          host_num_cpus(void);
 
 #ifdef __cplusplus
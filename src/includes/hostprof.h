@@ -0,0 +1,59 @@
+/*
+  Previous - hostprof.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_HOSTPROF_H
+#define PREV_HOSTPROF_H
+
+#if defined(__GNUC__)
+#define HOSTPROF_TLS __thread
+#elif defined(__cplusplus)
+#define HOSTPROF_TLS thread_local
+#else
+#define HOSTPROF_TLS _Thread_local
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Emulated subsystems host time is attributed to */
+typedef enum {
+	HOSTPROF_NONE,
+	HOSTPROF_CYCINT,
+	HOSTPROF_DSP,
+	HOSTPROF_I860,
+	HOSTPROF_MMU,
+	HOSTPROF_SCSI,
+	HOSTPROF_FILE,
+	HOSTPROF_SLIRP,
+	HOSTPROF_REPAINT,
+	HOSTPROF_MAX
+} hostprof_t;
+
+/* Subsystem tags of the current thread, innermost in low bits */
+extern HOSTPROF_TLS volatile uint16_t HostProf_Tags;
+
+/* Tag current thread to be running given subsystem until HostProf_Leave() */
+static inline uint16_t HostProf_Enter(hostprof_t sub) {
+	uint16_t old = HostProf_Tags;
+	HostProf_Tags = ((old << 4) | sub) & 0xfff;
+	return old;
+}
+
+static inline void HostProf_Leave(uint16_t old) {
+	HostProf_Tags = old;
+}
+
+extern void HostProf_SetThread(const char* name);
+extern bool HostProf_Start(const char* filename, int hz);
+extern void HostProf_Stop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PREV_HOSTPROF_H */
@@ -15,4 +15,6 @@ extern void Keymap_InitShortcutDefaultKeys(void);
 extern int Keymap_GetKeyFromName(const char *name);
 extern const char *Keymap_GetKeyName(int keycode);
 
+extern void Keymap_ReplayInput(const uint8_t *data, int len);
+
 #endif /* PREV_KEYMAP_H */
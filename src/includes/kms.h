@@ -111,6 +111,7 @@ extern void kms_send_sndout_underrun(void);
 extern void kms_send_sndout_request(void);
 
 extern void KMS_Reset(void);
+extern void KMS_MemorySnapShot_Capture(bool bSave);
 
 extern void KMS_Ctrl_Snd_Write(void);
 extern void KMS_Stat_Snd_Read(void);
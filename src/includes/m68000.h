@@ -78,6 +78,18 @@ static inline void M68000_SetSR(uint16_t v)
 #define BUS_ERROR_ACCESS_INSTR	0
 #define BUS_ERROR_ACCESS_DATA	1
 
+/* Cache and ATC statistics, collected for the CPU profiler */
+typedef struct {
+	uint32_t I_Cache_miss;
+	uint32_t I_Cache_hit;
+	uint32_t D_Cache_miss;
+	uint32_t D_Cache_hit;
+	uint32_t ATC_miss;
+} cpu_instruction_t;
+
+extern cpu_instruction_t CpuInstruction;
+extern uint64_t nCpuInstrExecuted;
+
 
 /*-----------------------------------------------------------------------*/
 /**
@@ -93,6 +105,7 @@ extern void M68000_Stop(void);
 extern void M68000_Start(void);
 extern void M68000_CheckInterrupt(void);
 extern void M68000_CheckCpuSettings(void);
+extern void M68000_MemorySnapShot_Capture(bool bSave);
 extern void M68000_BusError (uint32_t addr, int ReadWrite, int Size, int AccessType, uae_u32 val);
 
 extern uint32_t M68000_ReadLong(uint32_t addr);
@@ -64,6 +64,7 @@ extern "C" {
 
 extern volatile bool bQuitProgram;
 extern volatile bool bEmulationActive;
+extern bool bHeadless;
 
 extern bool Main_PauseEmulation(bool visualize);
 extern bool Main_UnPauseEmulation(void);
@@ -0,0 +1,31 @@
+/*
+  Previous - memorySnapShot.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_MEMORYSNAPSHOT_H
+#define PREV_MEMORYSNAPSHOT_H
+
+/* Granularity of dirty page tracking for incremental snapshots */
+#define MEMSNAP_PAGE_SHIFT 12
+#define MEMSNAP_PAGE_SIZE  (1<<MEMSNAP_PAGE_SHIFT)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void MemorySnapShot_Store(void *pData, int Size);
+extern void MemorySnapShot_StoreBlock(void *pData, size_t Size);
+extern void MemorySnapShot_StorePages(void *pData, size_t Size, uint8_t *pDirty);
+extern bool MemorySnapShot_Capture(const char *pszFileName);
+extern bool MemorySnapShot_CaptureDelta(const char *pszFileName);
+extern bool MemorySnapShot_Restore(const char *pszFileName);
+extern bool MemorySnapShot_Compact(const char *pszFileName, const char *pszOutName);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PREV_MEMORYSNAPSHOT_H */
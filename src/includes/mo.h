@@ -9,6 +9,7 @@
 #define PREV_MO_H
 
 extern void MO_Reset(void);
+extern void MO_MemorySnapShot_Capture(bool bSave);
 extern void MO_Insert(int disk);
 extern void MO_Eject(int disk);
 
@@ -23,5 +23,6 @@ extern void ncc_cache_wput(uaecptr addr, uae_u32 w);
 extern void ncc_cache_bput(uaecptr addr, uae_u32 b);
 
 extern void NCC_Reset(void);
+extern void NCC_MemorySnapShot_Capture(bool bSave);
 
 #endif /* PREV_NCC_H */
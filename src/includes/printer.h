@@ -29,6 +29,7 @@ extern PrinterBuffer lp_buffer;
 
 extern void Printer_UnInit(void);
 extern void Printer_Reset(void);
+extern void Printer_MemorySnapShot_Capture(bool bSave);
 extern void Printer_IO_Handler(void);
 
 #endif /* PREV_PRINTER_H */
@@ -29,6 +29,7 @@ extern void     bt463_bput(bt463* ramdac, uint32_t addr, uint32_t b);
 
 extern void RAMDAC_Read(void);
 extern void RAMDAC_Write(void);
+extern void RAMDAC_MemorySnapShot_Capture(bool bSave);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,58 @@
+/*
+  Previous - replay.h
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+*/
+
+#ifndef PREV_REPLAY_H
+#define PREV_REPLAY_H
+
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+	REPLAY_OFF,
+	REPLAY_RECORD,
+	REPLAY_PLAY
+} replay_mode_t;
+
+/* External inputs logged with the cycle they were delivered at */
+typedef enum {
+	REPLAY_END,          /* End of recording */
+	REPLAY_INPUT,        /* Keyboard, mouse or tablet event (data) */
+	REPLAY_ENET_FRAME,   /* Ethernet frame from host network (data) */
+	REPLAY_SND_IN,       /* Sound input sample or -1 (value) */
+	REPLAY_SND_IN_SIZE,  /* Sound input buffer fill (value) */
+	REPLAY_SND_OUT_SIZE, /* Sound output queue fill (value) */
+	REPLAY_DSP_IN,       /* DSP SSI input sample or -1 (value) */
+	REPLAY_NUM_EVENTS
+} replay_event_t;
+
+extern replay_mode_t nReplayMode;
+
+extern bool   Replay_Init(replay_mode_t mode, const char* filename);
+extern void   Replay_UnInit(void);
+extern void   Replay_Reset(void);
+extern time_t Replay_UnixTime(time_t now);
+extern void   Replay_Poll(void);
+extern void   Replay_Record(replay_event_t type, const void* data, int len);
+extern int    Replay_Fetch(replay_event_t type, void* data, int size);
+extern int    Replay_ExchangeValue(replay_event_t type, int value);
+
+/* Record value read from the host, or return recorded value in replay */
+static inline int Replay_Value(replay_event_t type, int value) {
+	if (nReplayMode != REPLAY_OFF) {
+		value = Replay_ExchangeValue(type, value);
+	}
+	return value;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PREV_REPLAY_H */
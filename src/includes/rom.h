@@ -8,6 +8,7 @@
 #ifndef PREV_ROM_H
 #define PREV_ROM_H
 
+extern void rom_set_mac_offset(uint32_t offset);
 extern int rom_load(uint8_t* buf, int len);
 
 #endif  /* PREV_ROM_H */
@@ -21,5 +21,6 @@ extern void nvram_checksum(int force);
 extern void NVRAM_Info(FILE *fp, uint32_t dummy);
 
 extern void RTC_Reset(void);
+extern void RTC_MemorySnapShot_Capture(bool bSave);
 
 #endif /* PREV_RTCNVRAM_H */
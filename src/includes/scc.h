@@ -20,6 +20,7 @@ extern void SCC_Clock_Read(void);
 extern void SCC_Clock_Write(void);
 
 extern void SCC_Reset(void);
+extern void SCC_MemorySnapShot_Capture(bool bSave);
 
 extern void SCC_IO_Handler(void);
 
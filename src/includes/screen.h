@@ -32,6 +32,7 @@ extern void Screen_StatusbarUpdate(void);
 extern bool Screen_ShowCursor(bool show);
 extern void Screen_CenterCursor(void);
 extern void Screen_Reset(void);
+extern const char* Screen_Report(uint64_t realTime, uint64_t hostTime);
 
 #ifdef __cplusplus
 }
@@ -45,6 +45,7 @@ typedef struct {
 extern SCSIBuffer scsi_buffer;
 
 extern void SCSI_Reset(void);
+extern void SCSI_MemorySnapShot_Capture(bool bSave);
 extern void SCSI_Insert(uint8_t target);
 extern void SCSI_Eject(uint8_t target);
 
@@ -20,6 +20,7 @@ extern void SND_DSP_Handler(void);
 
 extern void Sound_Reset(void);
 extern void Sound_Pause(bool pause);
+extern void Sound_MemorySnapShot_Capture(bool bSave);
 
 extern void snd_start_output(uint8_t mode);
 extern void snd_stop_output(void);
@@ -91,6 +91,7 @@ static inline int intlev(void) {
 }
 
 extern void SCR_Reset(void);
+extern void SCR_MemorySnapShot_Capture(bool bSave);
 
 extern void SCR1_Read(void);
 
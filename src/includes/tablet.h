@@ -14,6 +14,7 @@ extern void tablet_pen_button(int tip, int pressed);
 
 extern void Tablet_IO_Handler(void);
 extern void Tablet_Reset(void);
+extern void Tablet_MemorySnapShot_Capture(bool bSave);
 
 extern bool bTabletEnabled;
 
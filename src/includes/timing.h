@@ -26,8 +26,10 @@ enum {
 
 extern void        Timing_Pause(bool pause);
 extern uint64_t    Timing_GetTime(void);
+extern bool        Timing_IsRealtime(void);
 extern void        Timing_GetTimes(uint64_t* realTime, uint64_t* hostTime);
 extern void        Timing_Sync(void);
+extern void        Timing_SetMaxSpeed(bool enable);
 extern uint64_t    Timing_GetSaveTime(void);
 extern time_t      Timing_GetUnixTime(void);
 extern void        Timing_SetUnixTime(time_t now);
@@ -37,6 +39,7 @@ extern void        Timing_Hardclock(int expected, int actual);
 extern void        Timing_BlankCount(int src, bool state);
 extern const char* Timing_Report(uint64_t realTime, uint64_t hostTime);
 extern void        Timing_Reset(void);
+extern void        Timing_MemorySnapShot_Capture(bool bSave);
 
 #ifdef __cplusplus
 }
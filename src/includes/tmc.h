@@ -20,5 +20,6 @@ extern bool tmc_video_enabled(void);
 extern void tmc_video_interrupt(void);
 
 extern void TMC_Reset(void);
+extern void TMC_MemorySnapShot_Capture(bool bSave);
 
 #endif /* PREV_TMC_H */
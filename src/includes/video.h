@@ -8,6 +8,8 @@
 #ifndef PREV_VIDEO_H
 #define PREV_VIDEO_H
 
+#define NEXT_VBL_FREQ 68
+
 extern void Video_Reset(void);
 extern bool Video_Enabled(void);
 extern void Video_VBL_Handler(void);
@@ -18,6 +18,7 @@ const char Kms_fileid[] = "Previous kms.c";
 #include "dma.h"
 #include "rtcnvram.h"
 #include "snd.h"
+#include "memorySnapShot.h"
 
 #define LOG_KMS_REG_LEVEL LOG_DEBUG
 #define LOG_KMS_LEVEL     LOG_DEBUG
@@ -730,3 +731,10 @@ void KMS_Reset(void) {
     kms.rev = ConfigureParams.System.bTurbo?REV_NEW:REV_OLD;
     kms_reset();
 }
+
+void KMS_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&kms, sizeof(kms));
+    MemorySnapShot_Store(&kms_codec_dma_blockend, sizeof(kms_codec_dma_blockend));
+    MemorySnapShot_Store(&m_button_right, sizeof(m_button_right));
+    MemorySnapShot_Store(&m_button_left, sizeof(m_button_left));
+}
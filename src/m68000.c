@@ -12,6 +12,12 @@ const char M68000_fileid[] = "Previous m68000.c";
 #include "m68000.h"
 #include "cpummu.h"
 #include "cpummu030.h"
+#include "fpp.h"
+#include "memorySnapShot.h"
+
+
+cpu_instruction_t CpuInstruction;   /* Cache and ATC statistics */
+uint64_t nCpuInstrExecuted;         /* Executed instructions, for speed reporting */
 
 
 /**
@@ -34,6 +40,48 @@ void M68000_Reset(void)
 }
 
 
+/*-----------------------------------------------------------------------*/
+/**
+ * Save/Restore snapshot of CPU variables ('MemorySnapShot_Store' handles type)
+ * Must be called between two instructions.
+ */
+void M68000_MemorySnapShot_Capture(bool bSave)
+{
+	uae_u8 *pc_p = regs.pc_p, *pc_oldp = regs.pc_oldp;
+
+	MemorySnapShot_Store(&regs, sizeof(regs));
+	regs.pc_p = pc_p;
+	regs.pc_oldp = pc_oldp;
+
+	MemorySnapShot_Store(&crp_030, sizeof(crp_030));
+	MemorySnapShot_Store(&srp_030, sizeof(srp_030));
+	MemorySnapShot_Store(&tt0_030, sizeof(tt0_030));
+	MemorySnapShot_Store(&tt1_030, sizeof(tt1_030));
+	MemorySnapShot_Store(&tc_030, sizeof(tc_030));
+	MemorySnapShot_Store(&mmusr_030, sizeof(mmusr_030));
+
+	if (!bSave)
+	{
+		/* Rebuild translation state from the restored registers */
+		if (currprefs.mmu_model == 68030) {
+			mmu030_decode_tc(tc_030, true);
+			mmu030_flush_atc_all();
+		} else if (currprefs.mmu_model >= 68040) {
+			mmu_set_tc(regs.tcr);
+			mmu_set_super(regs.s != 0);
+			mmu_tt_modified();
+			mmu_flush_atc_all(true);
+		}
+		fpp_set_fpcr(regs.fpcr);
+		flush_cpu_caches(true);
+
+		/* Keep running, the reset that loaded the snapshot is done */
+		M68000_UnsetSpecial(SPCFLAG_MODE_CHANGE);
+		M68000_SetSpecial(SPCFLAG_INT);
+	}
+}
+
+
 /*-----------------------------------------------------------------------*/
 /**
  * Stop 680x0 emulation
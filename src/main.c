@@ -8,21 +8,30 @@
 */
 const char Main_fileid[] = "Previous main.c";
 
+#include "config.h"
+
 #include <time.h>
 #include <errno.h>
 #include <signal.h>
+#if HAVE_FORK
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 #include "main.h"
 #include "event.h"
 #include "timing.h"
 #include "configuration.h"
+#include "control.h"
 #include "dialog.h"
 #include "ioMem.h"
 #include "keymap.h"
 #include "log.h"
 #include "m68000.h"
+#include "memorySnapShot.h"
 #include "paths.h"
 #include "reset.h"
+#include "rom.h"
 #include "screen.h"
 #include "snd.h"
 #include "ethernet.h"
@@ -34,6 +43,9 @@ const char Main_fileid[] = "Previous main.c";
 #include "dsp.h"
 #include "host.h"
 #include "grab.h"
+#include "audio.h"
+#include "hostprof.h"
+#include "replay.h"
 #include "dimension.hpp"
 
 #include "hatari-glue.h"
@@ -45,6 +57,13 @@ const char Main_fileid[] = "Previous main.c";
 
 volatile bool bQuitProgram = false;            /* Flag to quit program cleanly */
 volatile bool bEmulationActive = false;        /* Do not run emulation during initialization */
+bool bHeadless = false;                        /* Run without window, input only from control socket */
+
+static const char* snapShotFile;               /* Snapshot to restore on first event, from --memstate */
+static const char* controlSocket;              /* Control socket path, from --control-socket */
+static int nInstances = 1;                     /* Number of machines to run, from --instances */
+static const char* replayFile;                 /* Input log, from --record or --replay */
+static replay_mode_t replayMode = REPLAY_OFF;
 
 #ifndef ENABLE_RENDERING_THREAD
 static thread_t*    nextThread;
@@ -60,7 +79,9 @@ typedef struct {
 
 static uint64_t lastRT;
 static uint64_t lastCycles;
+static uint64_t lastInstructions;
 static double   speedFactor = 1.0;
+static double   speedMips;
 static char     speedMsg[32];
 
 static void Main_Speed(uint64_t realTime, uint64_t hostTime) {
@@ -68,8 +89,11 @@ static void Main_Speed(uint64_t realTime, uint64_t hostTime) {
 	speedFactor   = nCyclesMainCounter - lastCycles;
 	speedFactor  /= ConfigureParams.System.nCpuFreq;
 	speedFactor  /= dRT;
+	speedMips     = nCpuInstrExecuted - lastInstructions;
+	speedMips    /= dRT;
 	lastRT        = realTime;
 	lastCycles    = nCyclesMainCounter;
+	lastInstructions = nCpuInstrExecuted;
 }
 
 void Main_SpeedReset(void) {
@@ -77,12 +101,15 @@ void Main_SpeedReset(void) {
 	Timing_GetTimes(&realTime, &hostTime);
 	lastRT     = realTime;
 	lastCycles = nCyclesMainCounter;
+	lastInstructions = nCpuInstrExecuted;
 
 	Log_Printf(LOG_WARN, "Realtime mode %s.\n", ConfigureParams.System.bRealtime ? "enabled" : "disabled");
 }
 
 const char* Main_SpeedMsg(void) {
-	if (ConfigureParams.System.bRealtime) {
+	if (ConfigureParams.System.bMaxSpeed) {
+		snprintf(speedMsg, sizeof(speedMsg), "%.1fx %.1fMIPS/", speedFactor, speedMips);
+	} else if (ConfigureParams.System.bRealtime) {
 		snprintf(speedMsg, sizeof(speedMsg), "%dMHz/", (int)(ConfigureParams.System.nCpuFreq * speedFactor + 0.5));
 	} else if (speedFactor < 0.9 || speedFactor > 1.1) {
 		snprintf(speedMsg, sizeof(speedMsg), "%.1fx%dMHz/", speedFactor, ConfigureParams.System.nCpuFreq);
@@ -96,6 +123,9 @@ const char* Main_SpeedMsg(void) {
 static const report_t reports[] = {
 	{"ND",    nd_reports},
 	{"Host",  Timing_Report},
+	{"Screen", Screen_Report},
+	{"Grab",  Grab_Report},
+	{"Audio", Audio_Report},
 };
 #endif
 
@@ -169,7 +199,10 @@ bool Main_UnPauseEmulation(void) {
 void Main_HaltDialog(void) {
 	Main_PauseEmulation(true);
 	Log_Printf(LOG_WARN, "Fatal error: CPU halted!");
-	if (!DlgAlert_Query("Fatal error: CPU halted!\n\nPress OK to restart CPU or cancel to quit.")) {
+	if (bHeadless) {
+		/* Nobody to ask, let the caller see the failure */
+		Main_RequestQuit(false);
+	} else if (!DlgAlert_Query("Fatal error: CPU halted!\n\nPress OK to restart CPU or cancel to quit.")) {
 		Main_RequestQuit(false);
 	}
 	Main_UnPauseEmulation();
@@ -212,6 +245,10 @@ void Main_RequestQuit(bool confirm) {
  */
 void Main_EventHandler(void) {
 	static int statusBarUpdate = 0;
+	static uint64_t lastInputRT = 0;
+	bool bHandleInput = true;
+	uint64_t vt;
+	uint64_t rt;
 #ifndef ENABLE_RENDERING_THREAD
 	if (!bEmulationActive) {
 		host_semaphore_signal(pauseFlag);
@@ -221,8 +258,6 @@ void Main_EventHandler(void) {
 	}
 #endif
 	if (++statusBarUpdate > 400) {
-		uint64_t vt;
-		uint64_t rt;
 		Timing_GetTimes(&rt, &vt);
 #if ENABLE_TESTING
 		fprintf(stderr, "[reports]");
@@ -238,11 +273,35 @@ void Main_EventHandler(void) {
 		statusBarUpdate = 0;
 	}
 
+	/* Restore snapshot given on command line once machine is running */
+	if (snapShotFile) {
+		MemorySnapShot_Restore(snapShotFile);
+		snapShotFile = NULL;
+	}
+
+	/* In max speed mode events come faster than real time,
+	 * only handle host input every 5 ms of real time */
+	if (ConfigureParams.System.bMaxSpeed) {
+		Timing_GetTimes(&rt, &vt);
+		bHandleInput = rt - lastInputRT >= 5000;
+		if (bHandleInput) {
+			lastInputRT = rt;
+		}
+	}
+
+	if (bHandleInput) {
+		/* Process commands from control socket */
+		Control_CheckUpdates();
+
 #ifdef ENABLE_RENDERING_THREAD
-	GuiEvent_EventHandler();
+		GuiEvent_EventHandler();
 #else
-	GuiEvent_EventQueueHandler();
+		GuiEvent_EventQueueHandler();
 #endif
+	}
+
+	/* Deliver recorded input at the cycle it was recorded at */
+	Replay_Poll();
 
 	Timing_Sync();
 
@@ -256,6 +315,7 @@ void Main_EventHandler(void) {
  */
 static int Main_Thread(void* unused) {
 	host_thread_priority(1);
+	HostProf_SetThread("68k");
 
 	while (!bQuitProgram) {
 		/* Start EventHandler */
@@ -284,12 +344,16 @@ static void Main_Loop(void) {
 	Main_UnPauseEmulation();
 
 #ifdef ENABLE_RENDERING_THREAD
+	HostProf_SetThread("68k");
+
 	/* Start EventHandler */
 	CycInt_AddTimeEvent(1000, 0, EVENT_MAIN_EVENT);
 
 	/* Start emulation */
 	M68000_Start();
 #else
+	HostProf_SetThread("main");
+
 	/* Initialize event queue */
 	GuiEvent_InitEventQueue();
 
@@ -311,6 +375,10 @@ static void Main_Loop(void) {
  * @return true if configuration is ready, false if we need to quit
  */
 static bool Main_StartMenu(void) {
+	if (bHeadless) {
+		/* No dialogs, configuration must be complete */
+		return true;
+	}
 	if (!File_Exists(sConfigFileName) || ConfigureParams.ConfigDialog.bShowConfigDialogAtStartup) {
 		Dialog_DoProperty();
 	}
@@ -365,6 +433,7 @@ static void Main_UnInit(void) {
 	host_thread_wait(nextThread);
 	host_semaphore_destroy(pauseFlag);
 #endif
+	Replay_UnInit();
 	Sound_Pause(true);
 	Printer_UnInit();
 	Ethernet_UnInit();
@@ -477,6 +546,128 @@ void Main_ErrorExit(const char *msg1, const char *msg2, int errval)
 	exit(errval);
 }
 
+/**
+ * Run the configured number of machines, each in its own process forked
+ * from the fully configured parent. Disk writes of every machine go to an
+ * in-memory overlay, so base images are shared read-only. Every machine
+ * adds its number to the MAC address in ROM, so that they can share one
+ * network segment. Returns the machine number in the children, the parent
+ * waits for all of them and exits with failure if any machine failed.
+ */
+static int Main_ForkInstances(void) {
+#if HAVE_FORK
+	int i, status, result = 0;
+	pid_t pid;
+
+	if (nInstances <= 1) {
+		return 0;
+	}
+	ConfigureParams.SCSI.nWriteProtection = WRITEPROT_ON;
+	fflush(stdout);
+	fflush(stderr);
+
+	for (i = 0; i < nInstances; i++) {
+		pid = fork();
+		if (pid < 0) {
+			perror("ERROR: starting machine failed");
+			result = 1;
+			break;
+		}
+		if (pid == 0) {
+			srand((unsigned)time(NULL) ^ (unsigned)getpid());
+			rom_set_mac_offset(i);
+			return i;
+		}
+	}
+	fprintf(stderr, "Running %d machines.\n", i);
+
+	while (wait(&status) > 0) {
+		if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+			result = 1;
+		}
+	}
+	exit(result);
+#else
+	if (nInstances > 1) {
+		fprintf(stderr, "Multiple instances are not supported on this platform.\n");
+	}
+	return 0;
+#endif
+}
+
+/**
+ * Connect control socket given on command line. When running several
+ * machines each one connects to "<path>.<machine number>".
+ */
+static void Main_ConnectControlSocket(int instance) {
+	char path[FILENAME_MAX];
+	const char *err;
+
+	if (!controlSocket) {
+		return;
+	}
+	if (nInstances > 1) {
+		snprintf(path, sizeof(path), "%s.%d", controlSocket, instance);
+	} else {
+		snprintf(path, sizeof(path), "%s", controlSocket);
+	}
+	err = Control_SetSocket(path);
+	if (err) {
+		Main_ErrorExit("Can not open control socket:", err, -1);
+	}
+}
+
+/**
+ * Open input log given on command line. When running several machines
+ * each one records to "<file>.<machine number>".
+ */
+static void Main_OpenReplay(int instance) {
+	char path[FILENAME_MAX];
+
+	if (!replayFile) {
+		return;
+	}
+	if (nInstances > 1 && replayMode == REPLAY_RECORD) {
+		snprintf(path, sizeof(path), "%s.%d", replayFile, instance);
+	} else {
+		snprintf(path, sizeof(path), "%s", replayFile);
+	}
+	if (!Replay_Init(replayMode, path)) {
+		exit(1);
+	}
+}
+
+/**
+ * Parse command line. The regular options parser is not used by this
+ * build, only the options needed to run without a display are handled.
+ */
+static void Main_ParseParameters(int argc, char *argv[]) {
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "--headless") == 0) {
+			bHeadless = true;
+		} else if (strcmp(argv[i], "--control-socket") == 0 && i + 1 < argc) {
+			controlSocket = argv[++i];
+		} else if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc) {
+			nInstances = atoi(argv[++i]);
+		} else if (strcmp(argv[i], "--memstate") == 0 && i + 1 < argc) {
+			snapShotFile = argv[++i];
+		} else if (strcmp(argv[i], "--max-speed") == 0) {
+			ConfigureParams.System.bMaxSpeed = true;
+		} else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+			replayMode = REPLAY_RECORD;
+			replayFile = argv[++i];
+		} else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+			replayMode = REPLAY_PLAY;
+			replayFile = argv[++i];
+		} else {
+			fprintf(stderr, "Ignoring unknown option '%s'\n", argv[i]);
+			fprintf(stderr, "Usage: %s [--headless] [--control-socket <path>] [--memstate <file>] [--max-speed] [--instances <n>] [--record <file>] [--replay <file>]\n", argv[0]);
+		}
+	}
+}
+
 /**
  * Main
  * 
@@ -484,6 +675,8 @@ void Main_ErrorExit(const char *msg1, const char *msg2, int errval)
  */
 int main(int argc, char *argv[])
 {
+	int instance;
+
 	/* Generate random seed */
 	srand((unsigned)time(NULL));
 
@@ -499,6 +692,14 @@ int main(int argc, char *argv[])
 	/* Now load the values from the configuration file */
 	Main_LoadInitialConfig();
 
+	/* Handle command line options */
+	Main_ParseParameters(argc, argv);
+
+	/* Start additional machines and connect to their control sockets */
+	instance = Main_ForkInstances();
+	Main_ConnectControlSocket(instance);
+	Main_OpenReplay(instance);
+
 	/* monitor type option might require "reset" -> true */
 	Configuration_Apply(true);
 
@@ -515,8 +716,9 @@ int main(int argc, char *argv[])
 		Main_Loop();
 	}
 
-	/* Stop recording */
+	/* Stop recording and profiling */
 	Grab_Stop();
+	HostProf_Stop();
 
 	/* Return from full screen */
 	Screen_ReturnFromFullScreen();
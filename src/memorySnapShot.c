@@ -0,0 +1,913 @@
+/*
+  Previous - memorySnapShot.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Memory snapshot of the whole emulated machine. Every module saves and
+  restores its state in a *_MemorySnapShot_Capture() function, which calls
+  MemorySnapShot_Store() for each variable. The same functions are used
+  for saving and restoring, so the order of the stored variables always
+  matches.
+
+  Large memories (main memory, VRAM, DSP and NeXTdimension memory) are
+  passed to MemorySnapShot_StoreBlock() instead. They are written page
+  aligned after the other state, so restoring maps the file and copies
+  them directly without any parsing.
+
+  Main memory and VRAM keep a dirty map with one byte per page, set by
+  their write handlers. An incremental snapshot names the last snapshot
+  saved or restored as its parent and only stores the pages written since
+  then. Restoring it restores the chain of parents first, compacting it
+  merges the chain into a single full snapshot.
+
+  Snapshots contain raw emulator structures, so they can only be restored
+  by a build with the same SNAPSHOT_VERSION and the same machine
+  configuration. Every stored variable is preceded by its size, so that a
+  structure whose size changed is detected before it is overwritten. Bump
+  SNAPSHOT_VERSION whenever a captured structure changes without changing
+  its size, or the order of stored variables changes. Disk
+  images are not part of the snapshot and must not be changed between
+  saving and restoring.
+*/
+const char MemorySnapShot_fileid[] = "Previous memorySnapShot.c";
+
+#include "config.h"
+
+#if HAVE_MMAP
+#include <sys/mman.h>
+#endif
+
+#include "main.h"
+#include "configuration.h"
+#include "change.h"
+#include "reset.h"
+#include "file.h"
+#include "log.h"
+#include "memorySnapShot.h"
+#include "m68000.h"
+#include "memory.h"
+#include "cycInt.h"
+#include "timing.h"
+#include "tmc.h"
+#include "ncc.h"
+#include "bmap.h"
+#include "sysReg.h"
+#include "rtcnvram.h"
+#include "dma.h"
+#include "esp.h"
+#include "scsi.h"
+#include "mo.h"
+#include "floppy.h"
+#include "scc.h"
+#include "tablet.h"
+#include "ethernet.h"
+#include "kms.h"
+#include "adb.h"
+#include "snd.h"
+#include "printer.h"
+#include "ramdac.h"
+#include "dsp.h"
+#include "NextBus.hpp"
+
+
+#define SNAPSHOT_MAGIC      "PREVSNAP"
+#define SNAPSHOT_VERSION    1
+#define SNAPSHOT_BUILD      PROG_NAME
+#define SNAPSHOT_ALIGN      0x10000
+#define SNAPSHOT_MAX_BLOCKS 64
+#define SNAPSHOT_MAX_CHAIN  256
+#define SNAPSHOT_MAX_PATH   1024
+
+typedef struct {
+	char     magic[8];
+	uint32_t version;                   /* SNAPSHOT_VERSION */
+	char     build[52];                 /* informational only */
+	char     parent[SNAPSHOT_MAX_PATH]; /* empty for full snapshots */
+	uint64_t state_offset;
+	uint64_t state_size;
+	uint32_t num_blocks;
+	uint32_t reserved;
+	struct {
+		uint64_t offset;
+		uint64_t size;
+		uint64_t index;    /* offset of stored page numbers, 0 for whole block */
+		uint64_t pages;
+	} block[SNAPSHOT_MAX_BLOCKS];
+} SNAPSHOT_HEADER;
+
+static SNAPSHOT_HEADER Header;
+static bool     bSaving;
+static bool     bIncremental;
+static bool     bCaptureError;
+static bool     bLayoutError;
+
+/* Saving: variables are collected to a buffer, blocks are written later */
+static uint8_t *pStateBuf;
+static size_t   nStateSize;
+static size_t   nStateAlloc;
+static void    *pBlockData[SNAPSHOT_MAX_BLOCKS];
+static uint32_t *pBlockPages[SNAPSHOT_MAX_BLOCKS];
+
+/* Restoring: variables and blocks are read from the (mapped) file */
+static uint8_t *pFileData;
+static size_t   nFileSize;
+static size_t   nStatePos;
+static int      nBlockIdx;
+
+/* Dirty page maps of blocks, cleared when a snapshot is saved or restored */
+static uint8_t *pBlockDirty[SNAPSHOT_MAX_BLOCKS];
+
+/* Last snapshot saved or restored, parent of the next incremental one */
+static char     szLastSnapShot[SNAPSHOT_MAX_PATH];
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save or restore a variable of the given size. The size is stored in
+ * front of it and checked on restore.
+ */
+void MemorySnapShot_Store(void *pData, int Size)
+{
+	uint32_t tag = Size;
+
+	if (bCaptureError)
+		return;
+
+	if (bSaving)
+	{
+		if (nStateSize + sizeof(tag) + Size > nStateAlloc)
+		{
+			uint8_t *p;
+			size_t alloc = nStateAlloc ? nStateAlloc : 0x10000;
+			while (nStateSize + sizeof(tag) + Size > alloc)
+				alloc *= 2;
+			p = realloc(pStateBuf, alloc);
+			if (!p)
+			{
+				bCaptureError = true;
+				return;
+			}
+			pStateBuf = p;
+			nStateAlloc = alloc;
+		}
+		memcpy(pStateBuf + nStateSize, &tag, sizeof(tag));
+		memcpy(pStateBuf + nStateSize + sizeof(tag), pData, Size);
+		nStateSize += sizeof(tag) + Size;
+	}
+	else
+	{
+		if (nStatePos + sizeof(tag) + Size > Header.state_size)
+		{
+			bCaptureError = true;
+			return;
+		}
+		memcpy(&tag, pFileData + Header.state_offset + nStatePos, sizeof(tag));
+		if (tag != (uint32_t)Size)
+		{
+			bLayoutError = bCaptureError = true;
+			return;
+		}
+		memcpy(pData, pFileData + Header.state_offset + nStatePos + sizeof(tag), Size);
+		nStatePos += sizeof(tag) + Size;
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Size of given page of a block, only the last page can be shorter.
+ */
+static size_t MemorySnapShot_PageSize(uint64_t size, uint32_t page)
+{
+	uint64_t rest = size - ((uint64_t)page << MEMSNAP_PAGE_SHIFT);
+
+	return rest < MEMSNAP_PAGE_SIZE ? (size_t)rest : MEMSNAP_PAGE_SIZE;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Copy block from a mapped snapshot file. Incremental blocks only
+ * overwrite the stored pages.
+ */
+static bool MemorySnapShot_CopyBlock(const SNAPSHOT_HEADER *hdr, const uint8_t *data,
+                                     size_t size, int i, uint8_t *pDest, size_t Size)
+{
+	uint64_t k, pos, num = (Size + MEMSNAP_PAGE_SIZE - 1) >> MEMSNAP_PAGE_SHIFT;
+	uint32_t page;
+
+	if (hdr->block[i].size != Size)
+		return false;
+
+	if (!hdr->block[i].index)
+	{
+		if (hdr->block[i].offset + Size > size)
+			return false;
+		memcpy(pDest, data + hdr->block[i].offset, Size);
+		return true;
+	}
+
+	if (hdr->block[i].pages > num ||
+	    hdr->block[i].index + hdr->block[i].pages * sizeof(page) > size)
+		return false;
+	for (k = 0; k < hdr->block[i].pages; k++)
+	{
+		memcpy(&page, data + hdr->block[i].index + k * sizeof(page), sizeof(page));
+		pos = hdr->block[i].offset + (k << MEMSNAP_PAGE_SHIFT);
+		if (page >= num || pos + MemorySnapShot_PageSize(Size, page) > size)
+			return false;
+		memcpy(pDest + ((size_t)page << MEMSNAP_PAGE_SHIFT), data + pos,
+		       MemorySnapShot_PageSize(Size, page));
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save or restore a large memory block with optional dirty page map (one
+ * byte per MEMSNAP_PAGE_SIZE bytes, set by the owner on every write).
+ * Blocks are stored page aligned in the snapshot file and restored with
+ * a single copy. Incremental snapshots only store the dirty pages of
+ * blocks with a dirty page map.
+ */
+void MemorySnapShot_StorePages(void *pData, size_t Size, uint8_t *pDirty)
+{
+	if (bCaptureError)
+		return;
+
+	if (nBlockIdx >= SNAPSHOT_MAX_BLOCKS)
+	{
+		bCaptureError = true;
+		return;
+	}
+	pBlockDirty[nBlockIdx] = pDirty;
+
+	if (bSaving)
+	{
+		pBlockData[nBlockIdx] = pData;
+		Header.block[nBlockIdx].size = Size;
+
+		if (bIncremental && pDirty)
+		{
+			uint32_t i, n = 0, num = (Size + MEMSNAP_PAGE_SIZE - 1) >> MEMSNAP_PAGE_SHIFT;
+			uint32_t *pages = malloc((num + 1) * sizeof(*pages));
+			if (!pages)
+			{
+				bCaptureError = true;
+				return;
+			}
+			for (i = 0; i < num; i++)
+			{
+				if (pDirty[i])
+					pages[n++] = i;
+			}
+			pBlockPages[nBlockIdx] = pages;
+			Header.block[nBlockIdx].pages = n;
+		}
+	}
+	else
+	{
+		if (nBlockIdx >= (int)Header.num_blocks ||
+		    !MemorySnapShot_CopyBlock(&Header, pFileData, nFileSize, nBlockIdx, pData, Size))
+		{
+			bCaptureError = true;
+			return;
+		}
+	}
+	nBlockIdx++;
+}
+
+void MemorySnapShot_StoreBlock(void *pData, size_t Size)
+{
+	MemorySnapShot_StorePages(pData, Size, NULL);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save or restore the state of all modules. The order must never depend
+ * on whether we are saving or restoring.
+ */
+static void MemorySnapShot_CaptureModules(bool bSave)
+{
+	NEXTMemory_MemorySnapShot_Capture(bSave);
+	M68000_MemorySnapShot_Capture(bSave);
+	CycInt_MemorySnapShot_Capture(bSave);
+	Timing_MemorySnapShot_Capture(bSave);
+	TMC_MemorySnapShot_Capture(bSave);
+	NCC_MemorySnapShot_Capture(bSave);
+	BMAP_MemorySnapShot_Capture(bSave);
+	SCR_MemorySnapShot_Capture(bSave);
+	RTC_MemorySnapShot_Capture(bSave);
+	DMA_MemorySnapShot_Capture(bSave);
+	ESP_MemorySnapShot_Capture(bSave);
+	SCSI_MemorySnapShot_Capture(bSave);
+	MO_MemorySnapShot_Capture(bSave);
+	Floppy_MemorySnapShot_Capture(bSave);
+	SCC_MemorySnapShot_Capture(bSave);
+	Tablet_MemorySnapShot_Capture(bSave);
+	Ethernet_MemorySnapShot_Capture(bSave);
+	KMS_MemorySnapShot_Capture(bSave);
+	ADB_MemorySnapShot_Capture(bSave);
+	Sound_MemorySnapShot_Capture(bSave);
+	Printer_MemorySnapShot_Capture(bSave);
+	RAMDAC_MemorySnapShot_Capture(bSave);
+	DSP_MemorySnapShot_Capture(bSave);
+	NextBus_MemorySnapShot_Capture(bSave);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Check that the snapshot was taken from the same kind of machine. Paths
+ * and user interface settings may differ, they are taken from the snapshot.
+ */
+static bool MemorySnapShot_CheckConfig(const CNF_PARAMS *saved)
+{
+	const CNF_SYSTEM *s = &saved->System, *c = &ConfigureParams.System;
+	int i, j;
+
+	if (s->nMachineType != c->nMachineType || s->bColor != c->bColor ||
+	    s->bTurbo != c->bTurbo || s->bNBIC != c->bNBIC || s->bADB != c->bADB ||
+	    s->nSCSI != c->nSCSI || s->nRTC != c->nRTC ||
+	    s->nCpuLevel != c->nCpuLevel || s->n_FPUType != c->n_FPUType ||
+	    s->nDSPType != c->nDSPType || s->bDSPMemoryExpansion != c->bDSPMemoryExpansion)
+		return false;
+
+	for (i = 0; i < 4; i++)
+	{
+		if (saved->Memory.nMemoryBankSize[i] != ConfigureParams.Memory.nMemoryBankSize[i])
+			return false;
+	}
+	for (i = 0; i < ND_MAX_BOARDS; i++)
+	{
+		const NDBOARD *sb = &saved->Dimension.board[i], *cb = &ConfigureParams.Dimension.board[i];
+		if (sb->bEnabled != cb->bEnabled)
+			return false;
+		for (j = 0; j < 4 && cb->bEnabled; j++)
+		{
+			if (sb->nMemoryBankSize[j] != cb->nMemoryBankSize[j])
+				return false;
+		}
+	}
+	return saved->Dimension.bI860Thread == ConfigureParams.Dimension.bI860Thread;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Write padding to align file position.
+ */
+static bool MemorySnapShot_Align(FILE *f, uint64_t *pos)
+{
+	static const uint8_t zero[256];
+	uint64_t pad = (SNAPSHOT_ALIGN - (*pos % SNAPSHOT_ALIGN)) % SNAPSHOT_ALIGN;
+
+	*pos += pad;
+	while (pad)
+	{
+		size_t n = pad > sizeof(zero) ? sizeof(zero) : (size_t)pad;
+		if (fwrite(zero, 1, n, f) != n)
+			return false;
+		pad -= n;
+	}
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Remember given snapshot as base of the next incremental snapshot and
+ * clear dirty page maps of the blocks just saved or restored.
+ */
+static void MemorySnapShot_SetLast(const char *pszFileName)
+{
+	int i;
+
+	for (i = 0; i < nBlockIdx; i++)
+	{
+		if (pBlockDirty[i])
+			memset(pBlockDirty[i], 0, (Header.block[i].size + MEMSNAP_PAGE_SIZE - 1) >> MEMSNAP_PAGE_SHIFT);
+	}
+	if (strlen(pszFileName) < sizeof(szLastSnapShot))
+		strcpy(szLastSnapShot, pszFileName);
+	else
+		szLastSnapShot[0] = '\0';
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Read and check snapshot file header.
+ */
+static bool MemorySnapShot_ReadHeader(const char *pszFileName, SNAPSHOT_HEADER *hdr)
+{
+	FILE *f;
+	bool ok;
+
+	f = File_Open(pszFileName, "rb");
+	if (!f)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: Cannot read '%s'", pszFileName);
+		return false;
+	}
+	ok = fread(hdr, sizeof(*hdr), 1, f) == 1;
+	File_Close(f);
+
+	if (!ok || memcmp(hdr->magic, SNAPSHOT_MAGIC, sizeof(hdr->magic)) ||
+	    hdr->num_blocks > SNAPSHOT_MAX_BLOCKS)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' is not a snapshot file", pszFileName);
+		return false;
+	}
+	if (hdr->version != SNAPSHOT_VERSION)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' was saved by an incompatible version (%.52s)",
+		           pszFileName, hdr->build);
+		return false;
+	}
+	hdr->parent[sizeof(hdr->parent) - 1] = '\0';
+	return true;
+}
+
+
+/**
+ * Return the file name of entry i of a chain read by MemorySnapShot_ReadChain.
+ */
+static const char *MemorySnapShot_ChainName(const char *pszFileName, const SNAPSHOT_HEADER *hdr, int i)
+{
+	return i ? hdr[i-1].parent : pszFileName;
+}
+
+/**
+ * Read the headers of a snapshot and of all snapshots it is based on into
+ * hdr, which must have room for SNAPSHOT_MAX_CHAIN entries, newest first.
+ * Returns the length of the chain or 0 on error.
+ */
+static int MemorySnapShot_ReadChain(const char *pszFileName, SNAPSHOT_HEADER *hdr)
+{
+	const char *name = pszFileName;
+	int i, n = 0;
+
+	for (;;)
+	{
+		if (!MemorySnapShot_ReadHeader(name, &hdr[n]))
+			return 0;
+		if (!hdr[n++].parent[0])
+			return n;
+		name = hdr[n-1].parent;
+		if (n >= SNAPSHOT_MAX_CHAIN)
+		{
+			Log_Printf(LOG_WARN, "Memory snapshot: Too many incremental snapshots before '%s'", pszFileName);
+			return 0;
+		}
+		for (i = 0; i < n; i++)
+		{
+			if (strcmp(MemorySnapShot_ChainName(pszFileName, hdr, i), name) == 0)
+			{
+				Log_Printf(LOG_WARN, "Memory snapshot: '%s' is based on itself", name);
+				return 0;
+			}
+		}
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Save the state of the emulated machine to the given file. Incremental
+ * snapshots refer to the last snapshot saved or restored and only contain
+ * memory pages changed since. They cannot replace a file of their chain.
+ */
+static bool MemorySnapShot_Save(const char *pszFileName, bool bDelta)
+{
+	FILE *f;
+	SNAPSHOT_HEADER *chain;
+	uint64_t pos, k;
+	int i, n;
+	bool ok = false;
+
+	if (bDelta && szLastSnapShot[0])
+	{
+		/* Overwriting a snapshot the new one is based on breaks the chain */
+		chain = malloc(SNAPSHOT_MAX_CHAIN * sizeof(*chain));
+		if (!chain)
+			return false;
+		n = MemorySnapShot_ReadChain(szLastSnapShot, chain);
+		for (i = 0; i < n; i++)
+		{
+			if (strcmp(MemorySnapShot_ChainName(szLastSnapShot, chain, i), pszFileName) == 0)
+				break;
+		}
+		free(chain);
+		if (n == 0)
+		{
+			/* Chain is unreadable, fall back to a full snapshot below */
+			szLastSnapShot[0] = '\0';
+		}
+		else if (i < n)
+		{
+			Log_Printf(LOG_WARN, "Memory snapshot: Cannot save '%s' on top of '%s'",
+			           pszFileName, szLastSnapShot);
+			return false;
+		}
+	}
+
+	memset(&Header, 0, sizeof(Header));
+	memcpy(Header.magic, SNAPSHOT_MAGIC, sizeof(Header.magic));
+	Header.version = SNAPSHOT_VERSION;
+	strncpy(Header.build, SNAPSHOT_BUILD, sizeof(Header.build) - 1);
+
+	if (bDelta)
+	{
+		if (!szLastSnapShot[0])
+		{
+			Log_Printf(LOG_WARN, "Memory snapshot: No previous snapshot for '%s', saving full snapshot",
+			           pszFileName);
+			bDelta = false;
+		}
+		else
+		{
+			strcpy(Header.parent, szLastSnapShot);
+		}
+	}
+
+	bSaving = true;
+	bIncremental = bDelta;
+	bCaptureError = false;
+	nStateSize = 0;
+	nBlockIdx = 0;
+	memset(pBlockPages, 0, sizeof(pBlockPages));
+
+	MemorySnapShot_Store(&ConfigureParams, sizeof(ConfigureParams));
+	MemorySnapShot_CaptureModules(true);
+
+	if (bCaptureError)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: Out of memory while saving state");
+		goto out;
+	}
+
+	f = File_Open(pszFileName, "wb");
+	if (!f)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: Cannot create '%s'", pszFileName);
+		goto out;
+	}
+
+	/* Lay out the file: header, state, page numbers of incremental
+	 * blocks, then page aligned blocks */
+	Header.num_blocks = nBlockIdx;
+	Header.state_offset = sizeof(Header);
+	Header.state_size = nStateSize;
+	pos = Header.state_offset + Header.state_size;
+	for (i = 0; i < nBlockIdx; i++)
+	{
+		if (pBlockPages[i])
+		{
+			Header.block[i].index = pos;
+			pos += Header.block[i].pages * sizeof(uint32_t);
+		}
+	}
+	for (i = 0; i < nBlockIdx; i++)
+	{
+		pos = (pos + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+		Header.block[i].offset = pos;
+		if (pBlockPages[i])
+		{
+			for (k = 0; k < Header.block[i].pages; k++)
+				pos += MemorySnapShot_PageSize(Header.block[i].size, pBlockPages[i][k]);
+		}
+		else
+		{
+			pos += Header.block[i].size;
+		}
+	}
+
+	ok = fwrite(&Header, sizeof(Header), 1, f) == 1 &&
+	     fwrite(pStateBuf, nStateSize, 1, f) == 1;
+	pos = sizeof(Header) + nStateSize;
+	for (i = 0; ok && i < nBlockIdx; i++)
+	{
+		if (pBlockPages[i] && Header.block[i].pages)
+		{
+			ok = fwrite(pBlockPages[i], sizeof(uint32_t), Header.block[i].pages, f) == Header.block[i].pages;
+			pos += Header.block[i].pages * sizeof(uint32_t);
+		}
+	}
+	for (i = 0; ok && i < nBlockIdx; i++)
+	{
+		ok = MemorySnapShot_Align(f, &pos);
+		if (pBlockPages[i])
+		{
+			for (k = 0; ok && k < Header.block[i].pages; k++)
+			{
+				uint32_t page = pBlockPages[i][k];
+				size_t size = MemorySnapShot_PageSize(Header.block[i].size, page);
+				ok = fwrite((uint8_t *)pBlockData[i] + ((size_t)page << MEMSNAP_PAGE_SHIFT), size, 1, f) == 1;
+				pos += size;
+			}
+		}
+		else if (ok)
+		{
+			ok = fwrite(pBlockData[i], Header.block[i].size, 1, f) == 1;
+			pos += Header.block[i].size;
+		}
+	}
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (ok)
+	{
+		MemorySnapShot_SetLast(pszFileName);
+		Log_Printf(LOG_WARN, "Memory snapshot: Saved to '%s'", pszFileName);
+	}
+	else
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: Error writing '%s'", pszFileName);
+	}
+
+out:
+	for (i = 0; i < SNAPSHOT_MAX_BLOCKS; i++)
+	{
+		free(pBlockPages[i]);
+		pBlockPages[i] = NULL;
+	}
+	free(pStateBuf);
+	pStateBuf = NULL;
+	nStateAlloc = 0;
+	return ok;
+}
+
+/**
+ * Save a full snapshot.
+ * Must be called from the CPU thread between two instructions.
+ */
+bool MemorySnapShot_Capture(const char *pszFileName)
+{
+	return MemorySnapShot_Save(pszFileName, false);
+}
+
+/**
+ * Save an incremental snapshot on top of the last one.
+ * Must be called from the CPU thread between two instructions.
+ */
+bool MemorySnapShot_CaptureDelta(const char *pszFileName)
+{
+	return MemorySnapShot_Save(pszFileName, true);
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Map snapshot file to memory. Returns NULL if the file cannot be read.
+ */
+static uint8_t *MemorySnapShot_Map(const char *pszFileName, size_t *pSize)
+{
+	FILE *f;
+	off_t size;
+	uint8_t *data;
+
+	f = File_Open(pszFileName, "rb");
+	if (!f)
+		return NULL;
+	size = File_Length(pszFileName);
+	if (size < (off_t)sizeof(SNAPSHOT_HEADER))
+	{
+		File_Close(f);
+		return NULL;
+	}
+	*pSize = (size_t)size;
+
+#if HAVE_MMAP
+	data = mmap(NULL, *pSize, PROT_READ, MAP_PRIVATE, fileno(f), 0);
+	if (data == MAP_FAILED)
+		data = NULL;
+#else
+	data = malloc(*pSize);
+	if (data && fread(data, *pSize, 1, f) != 1)
+	{
+		free(data);
+		data = NULL;
+	}
+#endif
+	File_Close(f);
+	return data;
+}
+
+static void MemorySnapShot_Unmap(uint8_t *data, size_t size)
+{
+#if HAVE_MMAP
+	munmap(data, size);
+#else
+	free(data);
+#endif
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Restore the state of the emulated machine from the given file, whose
+ * header has already been read into hdr. An incremental snapshot is
+ * applied on top of the state restored from its parent.
+ */
+static bool MemorySnapShot_RestoreFile(const char *pszFileName, const SNAPSHOT_HEADER *hdr,
+                                       CNF_PARAMS *saved)
+{
+	pFileData = MemorySnapShot_Map(pszFileName, &nFileSize);
+	if (!pFileData)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: Cannot read '%s'", pszFileName);
+		return false;
+	}
+
+	memcpy(&Header, pFileData, sizeof(Header));
+	if (memcmp(&Header, hdr, sizeof(Header)) ||
+	    Header.state_offset + Header.state_size > nFileSize)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' is not a snapshot file", pszFileName);
+		MemorySnapShot_Unmap(pFileData, nFileSize);
+		return false;
+	}
+
+	bSaving = false;
+	bCaptureError = false;
+	bLayoutError = false;
+	nStatePos = 0;
+	nBlockIdx = 0;
+
+	MemorySnapShot_Store(saved, sizeof(*saved));
+	if (bLayoutError)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' was saved by an incompatible version", pszFileName);
+		MemorySnapShot_Unmap(pFileData, nFileSize);
+		return false;
+	}
+	if (bCaptureError || !MemorySnapShot_CheckConfig(saved))
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' was saved with a different machine configuration",
+		           pszFileName);
+		MemorySnapShot_Unmap(pFileData, nFileSize);
+		return false;
+	}
+
+	/* Bring up the machine with the saved settings and disks, then
+	 * overwrite its state with the saved one. Incremental snapshots
+	 * are applied on top of the state restored by their parent. */
+	if (!Header.parent[0])
+		Change_CopyChangedParamsToConfiguration(&ConfigureParams, saved, true);
+	MemorySnapShot_CaptureModules(false);
+
+	MemorySnapShot_Unmap(pFileData, nFileSize);
+	pFileData = NULL;
+
+	if (bCaptureError)
+	{
+		/* Machine is in an undefined state now, start it from scratch */
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' %s, resetting machine", pszFileName,
+		           bLayoutError ? "does not match this version" : "is damaged");
+		Reset_Cold();
+		return false;
+	}
+	return true;
+}
+
+/**
+ * Restore a full or incremental snapshot.
+ * Must be called from the CPU thread between two instructions.
+ */
+bool MemorySnapShot_Restore(const char *pszFileName)
+{
+	SNAPSHOT_HEADER *hdr;
+	CNF_PARAMS *saved;
+	int i, n = 0;
+	bool ok = false;
+
+	hdr = malloc(SNAPSHOT_MAX_CHAIN * sizeof(*hdr));
+	saved = malloc(sizeof(*saved));
+	if (hdr && saved)
+		n = MemorySnapShot_ReadChain(pszFileName, hdr);
+
+	/* Oldest snapshot first */
+	for (i = n - 1; i >= 0; i--)
+	{
+		ok = MemorySnapShot_RestoreFile(MemorySnapShot_ChainName(pszFileName, hdr, i), &hdr[i], saved);
+		if (!ok)
+			break;
+	}
+	free(saved);
+	free(hdr);
+	if (!ok)
+		return false;
+
+	MemorySnapShot_SetLast(pszFileName);
+	Log_Printf(LOG_WARN, "Memory snapshot: Restored from '%s'", pszFileName);
+	return true;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Merge an incremental snapshot and all snapshots it is based on into a
+ * single full snapshot. Does not touch the state of the emulated machine.
+ */
+bool MemorySnapShot_Compact(const char *pszFileName, const char *pszOutName)
+{
+	SNAPSHOT_HEADER *hdr, out;
+	const char *name;
+	uint8_t *data[SNAPSHOT_MAX_CHAIN];
+	size_t size[SNAPSHOT_MAX_CHAIN];
+	uint8_t *buf;
+	uint64_t pos;
+	FILE *f = NULL;
+	int i, k, n = 0, mapped = 0;
+	bool ok = false;
+
+	hdr = malloc(SNAPSHOT_MAX_CHAIN * sizeof(*hdr));
+	if (!hdr)
+		return false;
+
+	/* Collect the chain, newest snapshot first */
+	n = MemorySnapShot_ReadChain(pszFileName, hdr);
+	for (k = 0; k < n; k++)
+	{
+		name = MemorySnapShot_ChainName(pszFileName, hdr, k);
+		if (strcmp(name, pszOutName) == 0)
+		{
+			Log_Printf(LOG_WARN, "Memory snapshot: Cannot compact '%s' into '%s'", pszFileName, pszOutName);
+			goto out;
+		}
+		if (hdr[k].num_blocks != hdr[0].num_blocks)
+		{
+			Log_Printf(LOG_WARN, "Memory snapshot: '%s' does not match '%s'", name, pszFileName);
+			goto out;
+		}
+		data[k] = MemorySnapShot_Map(name, &size[k]);
+		if (!data[k])
+		{
+			Log_Printf(LOG_WARN, "Memory snapshot: Cannot read '%s'", name);
+			goto out;
+		}
+		mapped = k + 1;
+	}
+	if (n == 0)
+		goto out;
+	if (hdr[0].state_offset + hdr[0].state_size > size[0])
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: '%s' is damaged", pszFileName);
+		goto out;
+	}
+
+	/* Same layout as a full snapshot, with the newest state */
+	out = hdr[0];
+	memset(out.parent, 0, sizeof(out.parent));
+	out.state_offset = sizeof(out);
+	pos = out.state_offset + out.state_size;
+	for (i = 0; i < (int)out.num_blocks; i++)
+	{
+		pos = (pos + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+		out.block[i].offset = pos;
+		out.block[i].index = 0;
+		out.block[i].pages = 0;
+		pos += out.block[i].size;
+	}
+
+	f = File_Open(pszOutName, "wb");
+	if (!f)
+	{
+		Log_Printf(LOG_WARN, "Memory snapshot: Cannot create '%s'", pszOutName);
+		goto out;
+	}
+	ok = fwrite(&out, sizeof(out), 1, f) == 1 &&
+	     fwrite(data[0] + hdr[0].state_offset, out.state_size, 1, f) == 1;
+	pos = out.state_offset + out.state_size;
+	for (i = 0; ok && i < (int)out.num_blocks; i++)
+	{
+		buf = malloc(out.block[i].size);
+		ok = buf != NULL;
+		for (k = n - 1; ok && k >= 0; k--)
+		{
+			ok = MemorySnapShot_CopyBlock(&hdr[k], data[k], size[k], i, buf, out.block[i].size);
+		}
+		ok = ok && MemorySnapShot_Align(f, &pos) &&
+		     fwrite(buf, out.block[i].size, 1, f) == 1;
+		pos += out.block[i].size;
+		free(buf);
+	}
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (ok)
+		Log_Printf(LOG_WARN, "Memory snapshot: Compacted %d snapshots into '%s'", n, pszOutName);
+	else
+		Log_Printf(LOG_WARN, "Memory snapshot: Error writing '%s'", pszOutName);
+
+out:
+	for (k = 0; k < mapped; k++)
+		MemorySnapShot_Unmap(data[k], size[k]);
+	free(hdr);
+	return ok;
+}
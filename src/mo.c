@@ -24,6 +24,7 @@ const char Mo_fileid[] = "Previous mo.c";
 #include "file.h"
 #include "rs.h"
 #include "statusbar.h"
+#include "memorySnapShot.h"
 
 #define LOG_MO_REG_LEVEL    LOG_DEBUG
 #define LOG_MO_CMD_LEVEL    LOG_DEBUG
@@ -1702,6 +1703,32 @@ void MO_Reset(void) {
     CycInt_RemovePendingEvent(EVENT_MO_ECC_IO);
 }
 
+void MO_MemorySnapShot_Capture(bool bSave) {
+    int i;
+    FILE* dsk;
+    
+    MemorySnapShot_Store(&osp, sizeof(osp));
+    for (i = 0; i < MO_MAX_DRIVES; i++) {
+        dsk = mo[i].dsk;
+        MemorySnapShot_Store(&mo[i], sizeof(mo[i]));
+        mo[i].dsk = dsk;
+    }
+    MemorySnapShot_Store(ecc_buffer, sizeof(ecc_buffer));
+    MemorySnapShot_Store(&ecc_state, sizeof(ecc_state));
+    MemorySnapShot_Store(&ecc_mode, sizeof(ecc_mode));
+    MemorySnapShot_Store(&fmt_mode, sizeof(fmt_mode));
+    MemorySnapShot_Store(&dnum, sizeof(dnum));
+    MemorySnapShot_Store(&sector_increment, sizeof(sector_increment));
+    MemorySnapShot_Store(&write_timing, sizeof(write_timing));
+    MemorySnapShot_Store(&sector_timer, sizeof(sector_timer));
+    MemorySnapShot_Store(&ecc_repeat, sizeof(ecc_repeat));
+    MemorySnapShot_Store(&eccin, sizeof(eccin));
+    MemorySnapShot_Store(&eccout, sizeof(eccout));
+    MemorySnapShot_Store(&delayed_compl, sizeof(delayed_compl));
+    MemorySnapShot_Store(&delayed_attn, sizeof(delayed_attn));
+    MemorySnapShot_Store(&delayed_drive, sizeof(delayed_drive));
+}
+
 void MO_Insert(int drive) {
     Log_Printf(LOG_WARN, "MO disk %i: %s",drive,ConfigureParams.MO.drive[drive].szImageName);
 
@@ -12,6 +12,7 @@ const char Ncc_fileid[] = "Previous ncc.c";
 #include "main.h"
 #include "m68000.h"
 #include "ncc.h"
+#include "memorySnapShot.h"
 
 #define LOG_NCC_LEVEL LOG_DEBUG
 #define LOG_TAG_LEVEL LOG_DEBUG
@@ -184,3 +185,9 @@ void NCC_Reset(void) {
 	memset(ncc.cache, 0, sizeof(ncc.cache));
 	memset(ncc.tag, 0, sizeof(ncc.tag));
 }
+
+
+/* Save/Restore snapshot of NCC registers and cache */
+void NCC_MemorySnapShot_Capture(bool bSave) {
+	MemorySnapShot_Store(&ncc, sizeof(ncc));
+}
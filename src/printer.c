@@ -16,6 +16,7 @@ const char Printer_fileid[] = "Previous printer.c";
 #include "dma.h"
 #include "statusbar.h"
 #include "grab.h"
+#include "memorySnapShot.h"
 
 #define LOG_LP_REG_LEVEL    LOG_DEBUG
 #define LOG_LP_LEVEL        LOG_DEBUG
@@ -28,29 +29,49 @@ PrinterBuffer lp_buffer;
 static uint8_t* print_data;
 static int print_dpi;
 static int print_size;
+static int print_alloc;
 static int print_limit;
 static int print_width;
 
 /* 14 inches is the longest paper and 400 DPI is the highest resolution. */
 static const int MAX_PAGE_LEN = 14 * 400; 
 
+/* Page buffer grows in strips of one inch at the highest resolution. */
+static const int PAGE_STRIP_LEN = 400;
+
 static void lp_print_start(uint32_t data) {
     if (print_data) {
         free(print_data);
+        print_data = NULL;
     }
     print_width = ((data >> 16) & 0x7F) * 4;
-    if (print_width) {
-        print_limit = MAX_PAGE_LEN * print_width;
-        print_data  = (uint8_t*)malloc(print_limit);
-        print_size  = 0;
-    }
+    print_limit = MAX_PAGE_LEN * print_width;
+    print_alloc = 0;
+    print_size  = 0;
 }
 
 static void lp_print_data(void) {
-    if (print_data) {
+    if (print_width) {
         if (lp_buffer.size > print_limit - print_size) {
             lp_buffer.size = print_limit - print_size;
         }
+        if (print_size + lp_buffer.size > print_alloc) {
+            int size = print_alloc + PAGE_STRIP_LEN * print_width;
+            uint8_t* buf;
+            
+            while (size < print_size + lp_buffer.size) {
+                size += PAGE_STRIP_LEN * print_width;
+            }
+            if (size > print_limit) {
+                size = print_limit;
+            }
+            buf = (uint8_t*)realloc(print_data, size);
+            if (!buf) {
+                return;
+            }
+            print_data  = buf;
+            print_alloc = size;
+        }
         memcpy(print_data + print_size, lp_buffer.data, lp_buffer.size);
         print_size += lp_buffer.size;
     }
@@ -58,10 +79,11 @@ static void lp_print_data(void) {
 
 static void lp_print_finish(void) {
     if (print_data) {
+        /* Page buffer is freed after saving it to file */
         Grab_Print(print_data, print_width * 8, print_size / print_width, print_dpi);
-        free(print_data);
-        print_data = NULL;
-        print_size = 0;
+        print_data  = NULL;
+        print_alloc = 0;
+        print_size  = 0;
     }
 }
 
@@ -660,6 +682,15 @@ void Printer_Reset(void) {
     lp_power_off();
 }
 
+/* Save/Restore snapshot of printer interface, pages in progress are lost */
+void Printer_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&lp, sizeof(lp));
+    MemorySnapShot_Store(&lp_buffer, sizeof(lp_buffer));
+    MemorySnapShot_Store(&lp_data_transfer, sizeof(lp_data_transfer));
+    MemorySnapShot_Store(&lp_serial_phase, sizeof(lp_serial_phase));
+    MemorySnapShot_Store(&lp_copyright_sequence, sizeof(lp_copyright_sequence));
+}
+
 
 /* Printer interface registers */
 void LP_CSR0_Read(void) { /* 0x0200F000 */
@@ -14,6 +14,7 @@ const char Ramdac_fileid[] = "Previous ramdac.c";
 #include "configuration.h"
 #include "ramdac.h"
 #include "sysReg.h"
+#include "memorySnapShot.h"
 
 #define LOG_RAMDAC_LEVEL    LOG_DEBUG
 
@@ -273,3 +274,7 @@ void RAMDAC_Write(void) {
     Log_Printf(LOG_RAMDAC_LEVEL,"[RAMDAC] Write at $%08x val=$%02x PC=$%08x\n", IoAccessCurrentAddress, IoMem_ReadByte(IoAccessCurrentAddress), m68k_getpc());
     bt463_bput(&ramdac68k, IoAccessCurrentAddress & 3, IoMem_ReadByte(IoAccessCurrentAddress));
 }
+
+void RAMDAC_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&ramdac68k, sizeof(ramdac68k));
+}
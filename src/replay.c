@@ -0,0 +1,383 @@
+/*
+  Previous - replay.c
+
+  This file is distributed under the GNU General Public License, version 2
+  or at your option any later version. Read the file gpl.txt for details.
+
+  Deterministic record and replay of external inputs.
+
+  While recording, every input that reaches the emulated machine from the
+  host (keyboard and mouse events, network frames, sound input and the
+  host sound queue fill that paces sound output) is logged together with
+  the value of nCyclesMainCounter it was delivered at. During replay the
+  host sources are ignored and the logged inputs are delivered at the
+  same hooks when the cycle counter reaches their cycle. Both modes run
+  in cycle time with realtime mode switched off and use the Unix time
+  and random seed stored in the file, so replaying a recording gives the
+  same run every time.
+
+  File format: an 8 byte magic, the Unix start time (8 bytes), the CPU
+  frequency in MHz (4 bytes) and the machine type (1 byte), all little
+  endian. Then one record per event: cycles since the previous event as
+  varint, the event type as one byte and its payload. Value events carry
+  a zigzag encoded varint, data events a varint length and the data.
+*/
+const char Replay_fileid[] = "Previous replay.c";
+
+#include "config.h"
+
+#include <inttypes.h>
+
+#include "main.h"
+#include "configuration.h"
+#include "cycInt.h"
+#include "keymap.h"
+#include "log.h"
+#include "replay.h"
+
+#define REPLAY_MAGIC    "PRVRPL01"
+#define REPLAY_MAX_DATA (64*1024)
+#define REPLAY_BUFFER   (1024*1024)
+
+enum {
+	REPLAY_KIND_NONE,
+	REPLAY_KIND_VALUE,
+	REPLAY_KIND_DATA
+};
+
+static const uint8_t ReplayKind[REPLAY_NUM_EVENTS] = {
+	REPLAY_KIND_NONE,  /* REPLAY_END */
+	REPLAY_KIND_DATA,  /* REPLAY_INPUT */
+	REPLAY_KIND_DATA,  /* REPLAY_ENET_FRAME */
+	REPLAY_KIND_VALUE, /* REPLAY_SND_IN */
+	REPLAY_KIND_VALUE, /* REPLAY_SND_IN_SIZE */
+	REPLAY_KIND_VALUE, /* REPLAY_SND_OUT_SIZE */
+	REPLAY_KIND_VALUE  /* REPLAY_DSP_IN */
+};
+
+replay_mode_t nReplayMode = REPLAY_OFF;
+
+static FILE*    ReplayFile;
+static time_t   ReplayStartTime;
+static uint64_t ReplayLastCycle;   /* Cycle of last recorded or replayed event */
+static uint64_t ReplayEvents;
+static uint64_t ReplayLate;
+static uint64_t ReplayMissing;
+static bool     ReplayDiverged;
+
+/* Next event to be replayed */
+static struct {
+	bool     valid;
+	uint8_t  type;
+	uint64_t delta;
+	int      value;
+	int      len;
+	uint8_t  data[REPLAY_MAX_DATA];
+} Next;
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Helpers for reading and writing the file.
+ */
+static void Replay_PutVarint(uint64_t v) {
+	uint8_t buf[10];
+	int n = 0;
+
+	do {
+		buf[n] = v & 0x7f;
+		v >>= 7;
+		if (v) {
+			buf[n] |= 0x80;
+		}
+		n++;
+	} while (v);
+	fwrite(buf, 1, n, ReplayFile);
+}
+
+static bool Replay_GetVarint(uint64_t* v) {
+	int c, shift = 0;
+
+	*v = 0;
+	do {
+		c = getc(ReplayFile);
+		if (c == EOF || shift > 63) {
+			return false;
+		}
+		*v |= (uint64_t)(c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return true;
+}
+
+static void Replay_PutLE(uint64_t v, int size) {
+	uint8_t buf[8];
+	int i;
+
+	for (i = 0; i < size; i++) {
+		buf[i] = v >> (i * 8);
+	}
+	fwrite(buf, 1, size, ReplayFile);
+}
+
+static bool Replay_GetLE(uint64_t* v, int size) {
+	uint8_t buf[8];
+	int i;
+
+	if (fread(buf, 1, size, ReplayFile) != (size_t)size) {
+		return false;
+	}
+	*v = 0;
+	for (i = 0; i < size; i++) {
+		*v |= (uint64_t)buf[i] << (i * 8);
+	}
+	return true;
+}
+
+/* Start logging an event at the current cycle */
+static void Replay_PutEvent(replay_event_t type) {
+	Replay_PutVarint(nCyclesMainCounter - ReplayLastCycle);
+	putc(type, ReplayFile);
+	ReplayLastCycle = nCyclesMainCounter;
+	ReplayEvents++;
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Log end of replay and statistics.
+ */
+static void Replay_Summary(void) {
+	Log_Printf(LOG_WARN, "[Replay] %s %"PRIu64" events, %"PRIu64" late, %"PRIu64" missing.",
+	           nReplayMode == REPLAY_RECORD ? "Recorded" : "Replayed",
+	           ReplayEvents, ReplayLate, ReplayMissing);
+}
+
+/* Read the next event to be replayed. At the end of a file without end
+ * marker the replay stops and host inputs are used again. */
+static void Replay_Read(void) {
+	uint64_t v = 0;
+	int c;
+
+	Next.valid = Replay_GetVarint(&Next.delta) && (c = getc(ReplayFile)) != EOF && c < REPLAY_NUM_EVENTS;
+	if (Next.valid) {
+		Next.type = c;
+		switch (ReplayKind[Next.type]) {
+			case REPLAY_KIND_VALUE:
+				Next.valid = Replay_GetVarint(&v);
+				Next.value = (int)(uint32_t)((v >> 1) ^ -(v & 1));
+				break;
+			case REPLAY_KIND_DATA:
+				Next.valid = Replay_GetVarint(&v) && v <= REPLAY_MAX_DATA;
+				Next.len   = Next.valid ? (int)v : 0;
+				Next.valid = Next.valid && fread(Next.data, 1, Next.len, ReplayFile) == (size_t)Next.len;
+				break;
+			default:
+				break;
+		}
+	}
+	if (!Next.valid) {
+		Log_Printf(LOG_WARN, "[Replay] File ends without end marker, continuing with host input.");
+		Replay_Summary();
+		nReplayMode = REPLAY_OFF;
+	}
+}
+
+/* Check if the next event is of given type and its cycle is reached */
+static bool Replay_Due(replay_event_t type) {
+	return nReplayMode == REPLAY_PLAY && Next.valid && Next.type == type &&
+	       ReplayLastCycle + Next.delta <= nCyclesMainCounter;
+}
+
+static void Replay_Consume(void) {
+	ReplayLastCycle += Next.delta;
+	if (ReplayLastCycle != nCyclesMainCounter) {
+		ReplayLate++;
+	}
+	ReplayEvents++;
+	if (Next.type == REPLAY_END) {
+		Next.valid = false;
+	} else {
+		Replay_Read();
+	}
+}
+
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Open file for recording or replaying. Realtime mode is switched off,
+ * guest time must only depend on emulated cycles.
+ */
+bool Replay_Init(replay_mode_t mode, const char* filename) {
+	char magic[8];
+	uint64_t v, w;
+
+	if (mode == REPLAY_OFF) {
+		return true;
+	}
+	ReplayFile = fopen(filename, mode == REPLAY_RECORD ? "wb" : "rb");
+	if (!ReplayFile) {
+		fprintf(stderr, "ERROR: can't open replay file '%s'\n", filename);
+		return false;
+	}
+	setvbuf(ReplayFile, NULL, _IOFBF, REPLAY_BUFFER);
+
+	if (mode == REPLAY_RECORD) {
+		ReplayStartTime = time(NULL);
+		fwrite(REPLAY_MAGIC, 1, sizeof(magic), ReplayFile);
+		Replay_PutLE((uint64_t)(int64_t)ReplayStartTime, 8);
+		Replay_PutLE(ConfigureParams.System.nCpuFreq, 4);
+		Replay_PutLE(ConfigureParams.System.nMachineType, 1);
+	} else {
+		if (fread(magic, 1, sizeof(magic), ReplayFile) != sizeof(magic) ||
+		    memcmp(magic, REPLAY_MAGIC, sizeof(magic)) != 0 || !Replay_GetLE(&v, 8)) {
+			fprintf(stderr, "ERROR: '%s' is not a replay file\n", filename);
+			fclose(ReplayFile);
+			ReplayFile = NULL;
+			return false;
+		}
+		ReplayStartTime = (time_t)(int64_t)v;
+		if (!Replay_GetLE(&v, 4) || !Replay_GetLE(&w, 1) ||
+		    v != (uint64_t)ConfigureParams.System.nCpuFreq || w != (uint64_t)ConfigureParams.System.nMachineType) {
+			fprintf(stderr, "WARNING: '%s' was recorded with a different machine configuration\n", filename);
+		}
+	}
+	nReplayMode    = mode;
+	ReplayEvents   = ReplayLate = ReplayMissing = 0;
+	ReplayDiverged = false;
+	ConfigureParams.System.bRealtime = false;
+
+	if (mode == REPLAY_PLAY) {
+		Replay_Read();
+	}
+	fprintf(stderr, "%s external inputs %s '%s'.\n", mode == REPLAY_RECORD ? "Recording" : "Replaying",
+	        mode == REPLAY_RECORD ? "to" : "from", filename);
+	return true;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Close file. When recording the end is logged at the current cycle, so
+ * that replays stop at the same point. Must not be called while the
+ * emulation is running.
+ */
+void Replay_UnInit(void) {
+	if (!ReplayFile) {
+		return;
+	}
+	if (nReplayMode == REPLAY_RECORD) {
+		Replay_PutEvent(REPLAY_END);
+	}
+	if (nReplayMode != REPLAY_OFF) {
+		Replay_Summary();
+	}
+	fclose(ReplayFile);
+	ReplayFile  = NULL;
+	nReplayMode = REPLAY_OFF;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Called on cold reset, when the cycle counter starts from zero again.
+ */
+void Replay_Reset(void) {
+	if (nReplayMode == REPLAY_OFF) {
+		return;
+	}
+	ReplayLastCycle = 0;
+	srand(1);
+	ConfigureParams.System.bRealtime = false;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Return the Unix time the machine starts with.
+ */
+time_t Replay_UnixTime(time_t now) {
+	return nReplayMode != REPLAY_OFF ? ReplayStartTime : now;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Deliver replayed input events and stop at the end of the recording.
+ * Called from the main event handler, where input events are recorded.
+ */
+void Replay_Poll(void) {
+	while (Replay_Due(REPLAY_INPUT)) {
+		Keymap_ReplayInput(Next.data, Next.len);
+		Replay_Consume();
+	}
+	if (Replay_Due(REPLAY_END)) {
+		Replay_Consume();
+		Replay_Summary();
+		nReplayMode = REPLAY_OFF;
+		Main_RequestQuit(false);
+		return;
+	}
+	/* A hook that was run while recording has not been run in replay */
+	if (nReplayMode == REPLAY_PLAY && Next.valid && !ReplayDiverged &&
+	    ReplayLastCycle + Next.delta + ConfigureParams.System.nCpuFreq * 1000000ULL < nCyclesMainCounter) {
+		Log_Printf(LOG_WARN, "[Replay] Replay diverged, event type %d from cycle %"PRIu64" is pending.",
+		           Next.type, ReplayLastCycle + Next.delta);
+		ReplayDiverged = true;
+	}
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Log data from host at the current cycle.
+ */
+void Replay_Record(replay_event_t type, const void* data, int len) {
+	if (nReplayMode != REPLAY_RECORD) {
+		return;
+	}
+	if (len > REPLAY_MAX_DATA) {
+		Log_Printf(LOG_WARN, "[Replay] Truncating %d byte event to %d bytes.", len, REPLAY_MAX_DATA);
+		len = REPLAY_MAX_DATA;
+	}
+	Replay_PutEvent(type);
+	Replay_PutVarint(len);
+	fwrite(data, 1, len, ReplayFile);
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Get replayed data of given type if it is due at the current cycle.
+ * Returns the length of the data or -1 if there is none.
+ */
+int Replay_Fetch(replay_event_t type, void* data, int size) {
+	int len;
+
+	if (!Replay_Due(type)) {
+		return -1;
+	}
+	len = Next.len < size ? Next.len : size;
+	memcpy(data, Next.data, len);
+	Replay_Consume();
+	return len;
+}
+
+/*-----------------------------------------------------------------------*/
+/**
+ * Log value read from the host or return the value read while recording.
+ * If no value was recorded here, return a neutral one instead of the live
+ * host value, so that the replay does not depend on the host.
+ */
+int Replay_ExchangeValue(replay_event_t type, int value) {
+	if (nReplayMode == REPLAY_RECORD) {
+		Replay_PutEvent(type);
+		Replay_PutVarint(((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+	} else if (Replay_Due(type)) {
+		value = Next.value;
+		Replay_Consume();
+	} else if (nReplayMode == REPLAY_PLAY) {
+		ReplayMissing++;
+		/* No sample for inputs, nothing queued for buffer fills */
+		if (type == REPLAY_SND_IN || type == REPLAY_DSP_IN) {
+			value = -1;
+		} else {
+			value = 0;
+		}
+	}
+	return value;
+}
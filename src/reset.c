@@ -36,6 +36,7 @@ const char Reset_fileid[] = "Hatari reset.c";
 #include "dsp.h"
 #include "kms.h"
 #include "keymap.h"
+#include "replay.h"
 #include "NextBus.hpp"
 
 /*-----------------------------------------------------------------------*/
@@ -50,6 +51,7 @@ static int Reset_NeXT(bool bCold)
 			return ret;
 		}
 		Keymap_Init();            /* Reset keymap */
+		Replay_Reset();           /* Reset input recording/replay */
 		Timing_Reset();           /* Reset timing system */
 		CycInt_Reset();           /* Reset interrupts */
 		Video_Reset();            /* Reset video */
@@ -15,15 +15,29 @@ const char Rom_fileid[] = "Previous rom.c";
 #include "rom.h"
 
 
+static uint32_t rom_mac_offset;
+
+/* Add offset to the MAC address, so that several machines get different ones */
+void rom_set_mac_offset(uint32_t offset) {
+    rom_mac_offset = offset;
+}
+
 /* Change the MAC address stored in ROM if requested */
 static void rom_config(uint8_t* buf) {
-    if (ConfigureParams.Rom.bUseCustomMac) {
+    if (ConfigureParams.Rom.bUseCustomMac || rom_mac_offset) {
         int i, n;
-        uint32_t crc, k, r;
+        uint32_t crc, k, r, nic;
         
-        for (i = 3; i < 6; i++) {
-            buf[8+i] = ConfigureParams.Rom.nRomCustomMac[i];
+        if (ConfigureParams.Rom.bUseCustomMac) {
+            for (i = 3; i < 6; i++) {
+                buf[8+i] = ConfigureParams.Rom.nRomCustomMac[i];
+            }
         }
+        nic = (buf[8+3] << 16) | (buf[8+4] << 8) | buf[8+5];
+        nic += rom_mac_offset;
+        buf[8+3] = (nic >> 16) & 0xFF;
+        buf[8+4] = (nic >> 8) & 0xFF;
+        buf[8+5] = nic & 0xFF;
         
         n = 22;
         i = 0;
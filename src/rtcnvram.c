@@ -18,6 +18,7 @@ const char Rtcnvram_fileid[] = "Previous rtcnvram.c";
 #include "dimension.hpp"
 #include "sysReg.h"
 #include "rtcnvram.h"
+#include "memorySnapShot.h"
 
 #include <time.h>
 
@@ -833,6 +834,17 @@ void RTC_Reset(void) {
 }
 
 
+/* ------------------- RTC snapshot ------------------- */
+void RTC_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&rtc, sizeof(rtc));
+    MemorySnapShot_Store(&newrtc, sizeof(newrtc));
+    MemorySnapShot_Store(&rtc_addr, sizeof(rtc_addr));
+    MemorySnapShot_Store(&rtc_val, sizeof(rtc_val));
+    MemorySnapShot_Store(&rtc_data, sizeof(rtc_data));
+    MemorySnapShot_Store(&phase, sizeof(phase));
+}
+
+
 
 /* ---------------------- RTC NVRAM ---------------------- */
 
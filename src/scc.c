@@ -17,6 +17,7 @@ const char Scc_fileid[] = "Previous scc.c";
 #include "sysReg.h"
 #include "dma.h"
 #include "tablet.h"
+#include "memorySnapShot.h"
 
 #define LOG_SCC_LEVEL     LOG_DEBUG
 #define LOG_SCC_IO_LEVEL  LOG_DEBUG
@@ -641,6 +642,14 @@ void SCC_Reset(void) {
     scc[0].clock = 0;
 }
 
+void SCC_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(scc, sizeof(scc));
+    MemorySnapShot_Store(&scc_register_pointer, sizeof(scc_register_pointer));
+    MemorySnapShot_Store(&scc_pio, sizeof(scc_pio));
+    MemorySnapShot_Store(&scc_pio_data, sizeof(scc_pio_data));
+    MemorySnapShot_Store(&scc_pio_channel, sizeof(scc_pio_channel));
+}
+
 
 /* Registers */
 void SCC_ControlB_Read(void) { /* 0x02018000 */
@@ -16,6 +16,8 @@ const char Scsi_fileid[] = "Previous scsi.c";
 #include "statusbar.h"
 #include "scsi.h"
 #include "file.h"
+#include "hostprof.h"
+#include "memorySnapShot.h"
 
 #define LOG_SCSI_LEVEL  LOG_DEBUG    /* Print debugging messages */
 
@@ -493,16 +495,15 @@ static void scsi_write_sector(void) {
             File_Write(scsi_buffer.data, SCSIdisk[target].blocksize, offset, SCSIdisk[target].dsk);
         } else {
             Log_Printf(LOG_SCSI_LEVEL, "[SCSI] WARNING: File write disabled!");
-            if(SCSIdisk[target].shadow) {
-                if(!(SCSIdisk[target].shadow[SCSIdisk[target].lba]))
-                    SCSIdisk[target].shadow[SCSIdisk[target].lba] = malloc(SCSIdisk[target].blocksize);
-                memcpy(SCSIdisk[target].shadow[SCSIdisk[target].lba], scsi_buffer.data, SCSIdisk[target].blocksize);
-            } else {
+            if(!SCSIdisk[target].shadow) {
                 uint32_t blocks = (uint32_t)(SCSIdisk[target].size / SCSIdisk[target].blocksize);
                 SCSIdisk[target].shadow = malloc(sizeof(uint8_t*) * blocks);
                 for(int i = blocks; --i >= 0;)
                     SCSIdisk[target].shadow[i] = NULL;
             }
+            if(!(SCSIdisk[target].shadow[SCSIdisk[target].lba]))
+                SCSIdisk[target].shadow[SCSIdisk[target].lba] = malloc(SCSIdisk[target].blocksize);
+            memcpy(SCSIdisk[target].shadow[SCSIdisk[target].lba], scsi_buffer.data, SCSIdisk[target].blocksize);
         }
         scsi_buffer.size = 0;
         scsi_buffer.limit = SCSIdisk[target].blocksize;
@@ -1055,7 +1056,9 @@ void SCSIdisk_Receive_Command(uint8_t *cdb, uint8_t identify) {
     
     Log_Printf(LOG_SCSI_LEVEL, "SCSI command: Opcode = $%02x, target = %i, LUN = %i", cdb[0], SCSIbus.target,lun);
     
+    uint16_t tags = HostProf_Enter(HOSTPROF_SCSI);
     SCSI_Command(cdb);
+    HostProf_Leave(tags);
 }
 
 int64_t SCSIdisk_Time(void) {
@@ -1071,8 +1074,24 @@ int64_t SCSIdisk_Time(void) {
 }
 
 
+/* Free blocks written to a write protected disk */
+static void SCSI_FreeShadow(uint8_t i) {
+    uint32_t blk, blocks;
+    
+    if (SCSIdisk[i].shadow) {
+        blocks = SCSIdisk[i].blocksize ? (uint32_t)(SCSIdisk[i].size / SCSIdisk[i].blocksize) : 0;
+        for (blk = 0; blk < blocks; blk++) {
+            free(SCSIdisk[i].shadow[blk]);
+        }
+        free(SCSIdisk[i].shadow);
+        SCSIdisk[i].shadow = NULL;
+    }
+}
+
 /* Insert/Eject SCSI disks */
 void SCSI_Insert(uint8_t i) {
+    SCSI_FreeShadow(i);
+    
     SCSIdisk[i].devtype = ConfigureParams.SCSI.target[i].nDeviceType;
     if (SCSIdisk[i].devtype == SD_HARDDISK) {
         ConfigureParams.SCSI.target[i].bDiskInserted = true;
@@ -1085,8 +1104,6 @@ void SCSI_Insert(uint8_t i) {
     SCSIdisk[i].blocksize = (SCSIdisk[i].devtype == SD_CD) ? SCSI_CD_BLOCK : SCSI_BLOCKSIZE;
     SCSIdisk[i].known = SCSI_LookupDisk(i); /* Sets size and blocksize */
     
-    SCSIdisk[i].shadow = NULL;
-    
     if (SCSIdisk[i].devtype != SD_NONE && ConfigureParams.SCSI.target[i].bDiskInserted) {
         Log_Printf(LOG_WARN, "SCSI disk %i: Insert %s", i, ConfigureParams.SCSI.target[i].szImageName);
         
@@ -1094,7 +1111,9 @@ void SCSI_Insert(uint8_t i) {
             ConfigureParams.SCSI.target[i].bWriteProtected = true;
         }
         if (!ConfigureParams.SCSI.target[i].bWriteProtected) {
-            SCSIdisk[i].dsk = File_Open(ConfigureParams.SCSI.target[i].szImageName, "rb+");
+            /* With write protection on writes only go to the shadow blocks */
+            SCSIdisk[i].dsk = File_Open(ConfigureParams.SCSI.target[i].szImageName,
+                                        ConfigureParams.SCSI.nWriteProtection == WRITEPROT_ON ? "rb" : "rb+");
             SCSIdisk[i].readonly = false;
         }
         if (ConfigureParams.SCSI.target[i].bWriteProtected || SCSIdisk[i].dsk == NULL) {
@@ -1114,6 +1133,7 @@ void SCSI_Insert(uint8_t i) {
 }
 
 void SCSI_Eject(uint8_t i) {    
+    SCSI_FreeShadow(i);
     SCSIdisk[i].dsk = File_Close(SCSIdisk[i].dsk);
     SCSIdisk[i].size = 0;
     SCSIdisk[i].readonly = false;
@@ -1141,3 +1161,58 @@ void SCSI_Reset(void) {
     SCSI_Uninit();
     SCSI_Init();
 }
+
+
+/* Save/Restore snapshot of SCSI bus and disks. Disk images are not saved,
+ * but blocks written to write protected disks are. */
+void SCSI_MemorySnapShot_Capture(bool bSave) {
+    int i;
+    uint32_t blk, blocks, count;
+    FILE* dsk;
+    uint8_t** shadow;
+    
+    MemorySnapShot_Store(&SCSIbus, sizeof(SCSIbus));
+    MemorySnapShot_Store(&scsi_buffer, sizeof(scsi_buffer));
+    
+    for (i = 0; i < ESP_MAX_DEVS; i++) {
+        dsk    = SCSIdisk[i].dsk;
+        shadow = SCSIdisk[i].shadow;
+        MemorySnapShot_Store(&SCSIdisk[i], sizeof(SCSIdisk[i]));
+        SCSIdisk[i].dsk    = dsk;
+        SCSIdisk[i].shadow = shadow;
+        
+        if (!SCSIdisk[i].dsk) {
+            SCSIdisk[i].size = 0;
+        }
+        blocks = (uint32_t)(SCSIdisk[i].size / SCSIdisk[i].blocksize);
+        
+        count = 0;
+        if (bSave && shadow) {
+            for (blk = 0; blk < blocks; blk++) {
+                if (shadow[blk]) count++;
+            }
+        }
+        MemorySnapShot_Store(&count, sizeof(count));
+        
+        if (!bSave && count && !shadow && blocks) {
+            SCSIdisk[i].shadow = calloc(blocks, sizeof(uint8_t*));
+        }
+        for (blk = 0; count > 0; count--, blk++) {
+            if (bSave) {
+                while (!shadow[blk]) blk++;
+            }
+            MemorySnapShot_Store(&blk, sizeof(blk));
+            if (bSave) {
+                MemorySnapShot_Store(shadow[blk], SCSIdisk[i].blocksize);
+            } else if (SCSIdisk[i].shadow && blk < blocks) {
+                if (!SCSIdisk[i].shadow[blk]) {
+                    SCSIdisk[i].shadow[blk] = malloc(SCSIdisk[i].blocksize);
+                }
+                MemorySnapShot_Store(SCSIdisk[i].shadow[blk], SCSIdisk[i].blocksize);
+            } else {
+                uint8_t skip[SCSI_MAX_BLOCK];
+                MemorySnapShot_Store(skip, SCSIdisk[i].blocksize);
+            }
+        }
+    }
+}
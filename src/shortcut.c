@@ -178,6 +178,9 @@ void ShortCut_ActKey(void)
 	 case SHORTCUT_RECORD:
 		Grab_SoundToggle();            /* Enable/disable sound recording */
 		break;
+	 case SHORTCUT_VIDEO:
+		Grab_VideoToggle();            /* Enable/disable video recording */
+		break;
 	 case SHORTCUT_SOUND:
 		ShortCut_SoundOnOff();         /* Enable/disable sound */
 		break;
@@ -226,6 +229,10 @@ bool Shortcut_Invoke(const char *shortcut)
 	} shortcuts[] = {
 		{ SHORTCUT_MOUSEGRAB, "mousegrab" },
 		{ SHORTCUT_COLDRESET, "coldreset" },
+		{ SHORTCUT_SCREENSHOT, "screenshot" },
+		{ SHORTCUT_RECORD, "record" },
+		{ SHORTCUT_VIDEO, "video" },
+		{ SHORTCUT_PAUSE, "pause" },
 		{ SHORTCUT_QUIT, "quit" },
 		{ SHORTCUT_NONE, NULL }
 	};
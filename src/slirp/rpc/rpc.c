@@ -627,6 +627,21 @@ int rpc_read_file(const char* vfs_path, uint32_t offset, uint8_t* data, uint32_t
     return -1;
 }
 
+int rpc_load_file(const char* vfs_path, uint8_t** data, uint32_t* len) {
+    if (rpc_server[0] && rpc_server[0]->ft) {
+        struct path_t path;
+        vfscpy(path.vfs, vfs_path, sizeof(path.vfs));
+        vfs_to_host_path(rpc_server[0]->ft->vfs, &path);
+        if (vfs_load(&path, data, len) == 0)
+            return 0;
+    }
+    return -1;
+}
+
+void rpc_unload_file(uint8_t* data) {
+    vfs_unload(data);
+}
+
 int rpc_match_arp(uint8_t byte) {
     int i;
     for (i = 0; i < EN_MAX_SHARES; i++) {
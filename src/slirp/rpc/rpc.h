@@ -130,6 +130,8 @@ const char* rpc_ip_str(char* buf, uint32_t addr, int count, size_t maxsize);
 void rpc_log(struct rpc_t* rpc, const char *format, ...);
 
 int rpc_read_file(const char* vfs_path, uint32_t offset, uint8_t* data, uint32_t len);
+int rpc_load_file(const char* vfs_path, uint8_t** data, uint32_t* len);
+void rpc_unload_file(uint8_t* data);
 
 int rpc_match_arp(uint8_t byte);
 int rpc_match_icmp(uint32_t addr);
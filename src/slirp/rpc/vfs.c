@@ -619,6 +619,42 @@ int vfs_read(const struct path_t* path, uint32_t offset, uint8_t* data, uint32_t
     return err;
 }
 
+/* Read a whole file into memory. The file is copied instead of mapped, *
+ * because a mapping faults if the host truncates the file underneath.   */
+int vfs_load(const struct path_t* path, uint8_t** data, uint32_t* len) {
+    int err = 0;
+    struct stat st;
+    struct file_t* file = file_open(path, "rb");
+    
+    *data = NULL;
+    *len  = 0;
+    err = file_is_open(file);
+    if (err == 0) {
+        if (fstat(fileno(file->file), &st) < 0) {
+            err = errno;
+        } else if ((uint64_t)st.st_size > UINT32_MAX) {
+            err = EFBIG;
+        } else if (st.st_size > 0) {
+            uint8_t* buf = (uint8_t*)malloc(st.st_size);
+            if (buf == NULL) {
+                err = ENOMEM;
+            } else if (file_read(file, buf, st.st_size) != (size_t)st.st_size) {
+                err = EIO;
+                free(buf);
+            } else {
+                *data = buf;
+                *len  = (uint32_t)st.st_size;
+            }
+        }
+    }
+    file_close(path, file);
+    return err;
+}
+
+void vfs_unload(uint8_t* data) {
+    free(data);
+}
+
 int vfs_write(const struct path_t* path, uint32_t offset, uint8_t* data, uint32_t len) {
     int err;
     struct file_t* file = file_open(path, "r+b");
@@ -112,6 +112,8 @@ int vfs_stat(const struct path_t* path, struct stat* fstat);
 uint64_t vfs_get_fhandle(const struct path_t* path);
 int vfs_readlink(const struct path_t* path, struct path_t* result);
 int vfs_read(const struct path_t* path, uint32_t offset, uint8_t* data, uint32_t* len);
+int vfs_load(const struct path_t* path, uint8_t** data, uint32_t* len);
+void vfs_unload(uint8_t* data);
 int vfs_write(const struct path_t* path, uint32_t offset, uint8_t* data, uint32_t len);
 int vfs_create(const struct path_t* path, uint8_t* data, uint32_t len);
 int vfs_remove(const struct path_t* path);
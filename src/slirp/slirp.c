@@ -21,6 +21,7 @@ const uint8_t special_ethaddr[6] = {
 uint8_t client_ethaddr[6];
 
 int do_slowtimo;
+int do_output;
 int link_up;
 struct timeval tt;
 FILE *lfd;
@@ -210,6 +211,7 @@ int slirp_select_fill(int *pnfds,
 	 * First, TCP sockets
 	 */
 	do_slowtimo = 0;
+	do_output = 0;
 	if (link_up) {
 		/* 
 		 * *_slowtimo needs calling if there are IP fragments
@@ -227,6 +229,12 @@ int slirp_select_fill(int *pnfds,
 			if (time_fasttimo == 0 && so->so_tcpcb->t_flags & TF_DELACK)
 				time_fasttimo = curtime; /* Flag when we want a fasttimo */
 			
+			/*
+			 * See if output was deferred by tcp_input
+			 */
+			if (so->so_tcpcb->t_flags & TF_NEEDOUTPUT)
+				do_output = 1;
+			
 			/*
 			 * NOFDREF can include still connecting to local-host,
 			 * newly socreated() sockets etc. Don't want to select these.
@@ -345,6 +353,12 @@ int slirp_select_fill(int *pnfds,
 	 */
 	if (timeout < (FAST_TIMO * 1000))
 		timeout = FAST_TIMO * 1000;
+	
+	/*
+	 * Don't wait if there is deferred output
+	 */
+	if (do_output)
+		timeout = 0;
 
 	return timeout;
 }	
@@ -386,6 +400,13 @@ void slirp_select_poll(fd_set *readfds, fd_set *writefds, fd_set *xfds)
 		for (so = tcb.so_next; so != &tcb; so = so_next) {
 			so_next = so->so_next;
 
+			/*
+			 * Send the segments for all ACKs received
+			 * from the guest since the last poll at once
+			 */
+			if (so->so_tcpcb->t_flags & TF_NEEDOUTPUT)
+				tcp_output(so->so_tcpcb);
+
 			/*
 			 * FD_ISSET is meaningless on these sockets
 			 * (and they can crash the program)
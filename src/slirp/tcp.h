@@ -42,7 +42,7 @@ extern size_t tcp_rcvspace;
 extern size_t tcp_sndspace;
 extern struct socket *tcp_last_so;
 
-#define TCP_SNDSPACE 8192
+#define TCP_SNDSPACE 32768     /* host data read per socket wakeup */
 #define TCP_RCVSPACE 8192
 
 /*
@@ -237,7 +237,7 @@ void tcp_input(register struct mbuf *m, int iphlen, struct socket *inso)
 	struct socket *so = 0;
 	int todrop;
 	u_int acked;
-	int ourfinisacked, needoutput = 0;
+	int ourfinisacked, needoutput = 0, wndopened = 0;
 	/*	int dropsocket = 0; */
 	int iss = 0;
 	u_long tiwin;
@@ -1296,6 +1296,8 @@ step6:
 		if (ti->ti_len == 0 &&
 			tp->snd_wl2 == ti->ti_ack && tiwin > tp->snd_wnd)
 			tcpstat.tcps_rcvwinupd++;
+		if (tp->snd_wnd == 0 && tiwin > 0)
+			wndopened = 1;
 		tp->snd_wnd = tiwin;
 		tp->snd_wl1 = ti->ti_seq;
 		tp->snd_wl2 = ti->ti_ack;
@@ -1462,8 +1464,23 @@ dodata:
 	/*
 	 * Return any desired output.
 	 */
-	if (needoutput || (tp->t_flags & TF_ACKNOW)) {
+	if (tp->t_flags & TF_ACKNOW) {
 		(void)tcp_output(tp);
+	} else if (needoutput) {
+		/*
+		 * The guest acknowledges every segment or two of a bulk
+		 * transfer. Instead of sending a segment per ACK, defer the
+		 * output to the next poll, which then sends as much as the
+		 * accumulated window allows in one burst. Only do this while
+		 * data is still in flight: if everything was acknowledged or
+		 * the window just opened from zero, nothing else will arrive
+		 * to keep the pipe busy, so send right away.
+		 */
+		if (tp->t_state == TCPS_ESTABLISHED && !wndopened &&
+		    tp->snd_una != tp->snd_max)
+			tp->t_flags |= TF_NEEDOUTPUT;
+		else
+			(void)tcp_output(tp);
 	}
 	return;
 
@@ -77,6 +77,8 @@ int tcp_output(register struct tcpcb *tp)
 	DEBUG_CALL("tcp_output");
 	DEBUG_ARG("tp = %lx", (long )tp);
 	
+	tp->t_flags &= ~TF_NEEDOUTPUT;
+	
 	/*
 	 * Determine length of data that should be transmitted,
 	 * and flags that will be used.
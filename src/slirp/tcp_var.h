@@ -60,6 +60,7 @@ struct tcpcb {
 #define	TF_REQ_TSTMP	0x0080		/* have/will request timestamps */
 #define	TF_RCVD_TSTMP	0x0100		/* a timestamp was received in SYN */
 #define	TF_SACK_PERMIT	0x0200		/* other side said I could SACK */
+#define	TF_NEEDOUTPUT	0x0400		/* output deferred to next poll */
 
 	/* Make it static  for now */
 /*	struct	tcpiphdr *t_template;	/ * skeletal packet for transmit */
@@ -22,10 +22,19 @@
  * THE SOFTWARE.
  */
 
+#include <stdlib.h>
 #include <slirp.h>
 #include "configuration.h"
 #include "rpc/rpc.h"
 
+struct tftp_file {
+    char filename[TFTP_FILENAME_MAX];
+    u_int8_t *data;
+    u_int32_t size;
+    int refcount;
+    int timestamp;
+};
+
 struct tftp_session {
     int in_use;
     char filename[TFTP_FILENAME_MAX];
@@ -33,13 +42,76 @@ struct tftp_session {
     struct in_addr client_ip;
     u_int16_t client_port;
     
+    struct tftp_file *file;
+    int blksize;
+    
     int timestamp;
 };
 
 struct tftp_session tftp_sessions[TFTP_SESSIONS_MAX];
 
+/* Files are loaded once and shared by all sessions that serve them. Unused *
+ * copies are kept for a while, so that a fleet of clients booting the      *
+ * same file does not read it again for each client.                       */
+static struct tftp_file tftp_files[TFTP_SESSIONS_MAX];
+
 const char *tftp_prefix = "/";
 
+static void tftp_file_release(struct tftp_file *f)
+{
+  if (f->data) {
+    rpc_unload_file(f->data);
+  }
+  memset(f, 0, sizeof(*f));
+}
+
+static struct tftp_file *tftp_file_get(const char *filename)
+{
+  struct tftp_file *f, *unused = NULL;
+  int k;
+
+  for (k = 0; k < TFTP_SESSIONS_MAX; k++) {
+    f = &tftp_files[k];
+
+    if (f->filename[0] && !strcmp(f->filename, filename)) {
+      if (f->refcount > 0 || (int)(curtime - f->timestamp) <= TFTP_FILE_TIMEOUT) {
+        f->refcount++;
+        return f;
+      }
+      /* copy is stale, load the file again in case it changed */
+      tftp_file_release(f);
+      unused = f;
+      break;
+    }
+    if (f->refcount == 0 && (!unused || !f->filename[0] ||
+                             (unused->filename[0] && (int)(f->timestamp - unused->timestamp) < 0))) {
+      unused = f;
+    }
+  }
+
+  if (!unused) {
+    return NULL;
+  }
+  tftp_file_release(unused);
+
+  if (rpc_load_file(filename, &unused->data, &unused->size) < 0) {
+    return NULL;
+  }
+  strncpy(unused->filename, filename, sizeof(unused->filename) - 1);
+  unused->refcount = 1;
+  unused->timestamp = curtime;
+
+  return unused;
+}
+
+static void tftp_file_put(struct tftp_file *f)
+{
+  if (f) {
+    f->refcount--;
+    f->timestamp = curtime;
+  }
+}
+
 static void tftp_session_update(struct tftp_session *spt)
 {
     spt->timestamp = curtime;
@@ -48,6 +120,8 @@ static void tftp_session_update(struct tftp_session *spt)
 
 static void tftp_session_terminate(struct tftp_session *spt)
 {
+  tftp_file_put(spt->file);
+  spt->file = NULL;
   spt->in_use = 0;
 }
 
@@ -70,9 +144,11 @@ static int tftp_session_allocate(struct tftp_t *tp)
   return -1;
 
  found:
+  tftp_file_put(spt->file);
   memset(spt, 0, sizeof(*spt));
   memcpy(&spt->client_ip, &tp->ip.ip_src, sizeof(spt->client_ip));
   spt->client_port = tp->udp.uh_sport;
+  spt->blksize = TFTP_BLKSIZE_DEFAULT;
 
   tftp_session_update(spt);
 
@@ -102,8 +178,39 @@ static int tftp_session_find(struct tftp_t *tp)
 static int tftp_read_data(struct tftp_session *spt, u_int16_t block_nr,
 			  u_int8_t *buf, int len)
 {
-    int bytes_read = rpc_read_file(spt->filename, block_nr * 512, buf, len);
-    return bytes_read < 0 ? -1 : bytes_read;
+    u_int32_t offset = (u_int32_t)block_nr * spt->blksize;
+
+    if (!spt->file) {
+        return -1;
+    }
+    if (offset >= spt->file->size) {
+        return 0;
+    }
+    if (len > (int)(spt->file->size - offset)) {
+        len = spt->file->size - offset;
+    }
+    memcpy(buf, spt->file->data + offset, len);
+    return len;
+}
+
+/* Largest block that fits into an mbuf behind the link, IP and UDP headers */
+static int tftp_blksize_max(void)
+{
+    struct mbuf *m;
+    int room;
+
+    m = m_get();
+    if (!m) {
+        return TFTP_BLKSIZE_DEFAULT;
+    }
+    m->m_data += if_maxlinkhdr + sizeof(struct udpiphdr);
+    room = (int)M_FREEROOM(m) - TFTP_DATA_HDRLEN;
+    m_free(m);
+
+    if (room > TFTP_BLKSIZE_MAX) {
+        room = TFTP_BLKSIZE_MAX;
+    }
+    return room;
 }
 
 static int tftp_send_error(struct tftp_session *spt, 
@@ -154,6 +261,7 @@ static int tftp_send_data(struct tftp_session *spt,
   struct sockaddr_in saddr, daddr;
   struct mbuf *m;
   struct tftp_t *tp;
+  u_int8_t *data;
   int nobytes;
 
   if (block_nr < 1) {
@@ -181,7 +289,15 @@ static int tftp_send_data(struct tftp_session *spt,
   daddr.sin_addr = spt->client_ip;
   daddr.sin_port = spt->client_port;
 
-  nobytes = tftp_read_data(spt, block_nr - 1, tp->x.tp_data.tp_buf, 512);
+  /* blocks can be larger than tp_buf, so address the mbuf directly */
+  data = (u_int8_t *)m->m_data + TFTP_DATA_HDRLEN;
+  if (spt->blksize > (int)M_FREEROOM(m) - TFTP_DATA_HDRLEN) {
+    m_free(m);
+    tftp_send_error(spt, 0, "Block size too large", recv_tp);
+    return -1;
+  }
+
+  nobytes = tftp_read_data(spt, block_nr - 1, data, spt->blksize);
 
   if (nobytes < 0) {
     m_free(m);
@@ -193,12 +309,11 @@ static int tftp_send_data(struct tftp_session *spt,
     return -1;
   }
 
-  m->m_len = sizeof(struct tftp_t) - (512 - nobytes) - 
-        sizeof(struct ip) - sizeof(struct udphdr);
+  m->m_len = TFTP_DATA_HDRLEN + nobytes;
 
   udp_output2(NULL, m, &saddr, &daddr, IPTOS_LOWDELAY);
 
-  if (nobytes == 512) {
+  if (nobytes == spt->blksize) {
     tftp_session_update(spt);
   }
   else {
@@ -208,11 +323,50 @@ static int tftp_send_data(struct tftp_session *spt,
   return 0;
 }
 
+static int tftp_send_oack(struct tftp_session *spt,
+                          const char *options, int optlen,
+                          struct tftp_t *recv_tp)
+{
+  struct sockaddr_in saddr, daddr;
+  struct mbuf *m;
+  struct tftp_t *tp;
+
+  m = m_get();
+
+  if (!m) {
+    return -1;
+  }
+
+  memset(m->m_data, 0, m->m_size);
+
+  m->m_data += if_maxlinkhdr;
+  tp = (void *)m->m_data;
+  m->m_data += sizeof(struct udpiphdr);
+
+  tp->tp_op = htons(TFTP_OACK);
+  memcpy(tp->x.tp_buf, options, optlen);
+
+  saddr.sin_addr = recv_tp->ip.ip_dst;
+  saddr.sin_port = recv_tp->udp.uh_dport;
+
+  daddr.sin_addr = spt->client_ip;
+  daddr.sin_port = spt->client_port;
+
+  m->m_len = sizeof(tp->tp_op) + optlen;
+
+  udp_output2(NULL, m, &saddr, &daddr, IPTOS_LOWDELAY);
+
+  return 0;
+}
+
 static void tftp_handle_rrq(struct tftp_t *tp, int pktlen)
 {
   struct tftp_session *spt;
   int s, k, n;
   u_int8_t *src, *dst;
+  char options[TFTP_OPTIONS_MAX];
+  int optlen = 0;
+  int have_blksize = 0, have_tsize = 0;
 
   s = tftp_session_allocate(tp);
 
@@ -276,11 +430,64 @@ static void tftp_handle_rrq(struct tftp_t *tp, int pktlen)
 
   /* check if the file exists */
   
-  if (tftp_read_data(spt, 0, (u_int8_t *)spt->filename, 0) < 0) {
+  spt->file = tftp_file_get(spt->filename);
+  if (!spt->file) {
       tftp_send_error(spt, 1, "File not found", tp);
       return;
   }
 
+  /* check options (RFC 2347, 2348, 2349) */
+
+  k += 6;
+  while (k < n) {
+      const char *name = (const char *)&src[k];
+      const char *value;
+      int vlen, nlen = strnlen(name, n - k);
+
+      if (k + nlen + 1 >= n) {
+          break;
+      }
+      value = name + nlen + 1;
+      vlen = strnlen(value, n - k - nlen - 1);
+      if (k + nlen + 1 + vlen >= n) {
+          break;
+      }
+      k += nlen + 1 + vlen + 1;
+
+      /* each option is acknowledged once, and only if it fits */
+      if (!have_blksize && !strcasecmp(name, "blksize")) {
+          int len, blksize = atoi(value);
+          if (blksize < 8) {
+              continue;
+          }
+          if (blksize > tftp_blksize_max()) {
+              blksize = tftp_blksize_max();
+          }
+          len = snprintf(options + optlen, sizeof(options) - optlen,
+                         "blksize%c%d", 0, blksize);
+          if (len < 0 || len >= (int)sizeof(options) - optlen) {
+              break;
+          }
+          optlen += len + 1;
+          spt->blksize = blksize;
+          have_blksize = 1;
+      } else if (!have_tsize && !strcasecmp(name, "tsize")) {
+          int len = snprintf(options + optlen, sizeof(options) - optlen,
+                             "tsize%c%u", 0, spt->file->size);
+          if (len < 0 || len >= (int)sizeof(options) - optlen) {
+              break;
+          }
+          optlen += len + 1;
+          have_tsize = 1;
+      }
+  }
+
+  if (optlen > 0) {
+      /* client acknowledges with block 0 before data is sent */
+      tftp_send_oack(spt, options, optlen, tp);
+      return;
+  }
+
   tftp_send_data(spt, 1, tp);
 }
 
@@ -9,6 +9,13 @@
 #define TFTP_DATA   3
 #define TFTP_ACK    4
 #define TFTP_ERROR  5
+#define TFTP_OACK   6
+
+#define TFTP_BLKSIZE_DEFAULT 512
+#define TFTP_BLKSIZE_MAX     1468   /* 1500 byte MTU minus IP, UDP and TFTP headers */
+#define TFTP_OPTIONS_MAX     64
+#define TFTP_DATA_HDRLEN     4      /* opcode and block number */
+#define TFTP_FILE_TIMEOUT    30000  /* keep unused file copies for 30 seconds */
 
 #define TFTP_FILENAME_MAX 512
 
@@ -17,6 +17,8 @@ const char Snd_fileid[] = "Previous snd.c";
 #include "snd.h"
 #include "kms.h"
 #include "dsp.h"
+#include "memorySnapShot.h"
+#include "replay.h"
 
 #define LOG_SND_LEVEL   LOG_DEBUG
 #define LOG_VOL_LEVEL   LOG_DEBUG
@@ -31,7 +33,7 @@ uint8_t snd_buffer[SND_BUFFER_SIZE];
 int     snd_buffer_len = 0;
 
 static struct {
-    double volume[2]; /* 0 = left, 1 = right */
+    int16_t volume[2]; /* Q14 gain, 0 = left, 1 = right */
     
     uint8_t mode;
     uint8_t mute;
@@ -93,31 +95,80 @@ static uint8_t snd_make_ulaw(int16_t sample) {
 static uint32_t foursamples;
 static int ulawsamplecount;
 
+/* Vector kernels for the sample processing below. Samples are 16-bit
+ * big-endian stereo frames, all kernels work on 4 frames at a time. */
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SND_SSE2 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SND_NEON 1
+#include <arm_neon.h>
+#endif
+
 /* This function performs two times upsampling using repeat or zero-fill */
 static void snd_make_double_samples(uint8_t* buf, int len, int repeat) {
     uint32_t copy, fill;
     uint32_t* src = (uint32_t*)(buf + len);
     uint32_t* dst = (uint32_t*)(buf + len * 2);
-    while (src < dst) {
+    /* Work from the top down, destination never overtakes unread source */
+    while ((src - (uint32_t*)buf) & 3) {
         memcpy(&copy, --src, 4); /* read sample from top of source */
         fill = copy * repeat;    /* repeat or zero-fill the sample */
         memcpy(--dst, &fill, 4); /* write filling sample to top of destination */
         memcpy(--dst, &copy, 4); /* copy original sample to top of destination */
     }
+#if SND_SSE2
+    {
+        __m128i mask = _mm_set1_epi32(repeat ? -1 : 0);
+        while (src > (uint32_t*)buf) {
+            __m128i x, f;
+            src -= 4;
+            dst -= 8;
+            x = _mm_loadu_si128((__m128i*)src);
+            f = _mm_and_si128(x, mask);
+            _mm_storeu_si128((__m128i*)(dst + 4), _mm_unpackhi_epi32(x, f));
+            _mm_storeu_si128((__m128i*)dst, _mm_unpacklo_epi32(x, f));
+        }
+    }
+#elif SND_NEON
+    {
+        uint32x4_t mask = vdupq_n_u32(repeat ? 0xFFFFFFFF : 0);
+        while (src > (uint32_t*)buf) {
+            uint32x4x2_t y;
+            src -= 4;
+            dst -= 8;
+            y.val[0] = vld1q_u32(src);
+            y.val[1] = vandq_u32(y.val[0], mask);
+            vst2q_u32(dst, y);
+        }
+    }
+#else
+    while (src > (uint32_t*)buf) {
+        memcpy(&copy, --src, 4);
+        fill = copy * repeat;
+        memcpy(--dst, &fill, 4);
+        memcpy(--dst, &copy, 4);
+    }
+#endif
 }
 
-/* This is a de-emphasis filter for 44.1 kHz pre-emphasised CD audio input */
+/* This is a de-emphasis filter for 44.1 kHz pre-emphasised CD audio input.
+ * It runs in fixed-point with 8 fractional bits kept in the output state
+ * and both channels side by side. */
+#define DEEMPH_SHIFT 30
+#define DEEMPH_FRAC  8
+
 static struct deemph_t {
-    double li[2];
-    double lo[2];
+    int32_t li[2];
+    int64_t lo[2];
 } deemph;
 
 static void snd_deemphasis_start(void) {
-    deemph.li[0] = deemph.li[1] = 0.0;
-    deemph.lo[0] = deemph.lo[1] = 0.0;
+    deemph.li[0] = deemph.li[1] = 0;
+    deemph.lo[0] = deemph.lo[1] = 0;
 }
 
-static double snd_deemphasis_filter(double i, int c) {
+static void snd_deemphasis_filter(int32_t* s) {
     /* Coefficients have been calculated as follows:
      *   T = 1./44100.
      *   V0 = 0.3365
@@ -126,27 +177,84 @@ static double snd_deemphasis_filter(double i, int c) {
      *   a1 = (B-1.)/(B+1.)
      *   b0 = (1.+(1.-a1)*(V0-1.)/2.)
      *   b1 = (a1+(a1-1.)*(V0-1.)/2.)
+     * and scaled by 2^DEEMPH_SHIFT.
      */
-    static const double a1 = -0.62786881719628784282;
-    static const double b0 =  0.45995451989513153057;
-    static const double b1 = -0.08782333709141937339;
-    
-    double o = i * b0 + deemph.li[c] * b1 - deemph.lo[c] * a1;
-    
-    deemph.li[c] = i;
-    deemph.lo[c] = o;
+    static const int64_t a1 = -674169009; /* -0.62786881719628784282 */
+    static const int64_t b0 =  493872405; /*  0.45995451989513153057 */
+    static const int64_t b1 =  -94299590; /* -0.08782333709141937339 */
+    int c;
     
-    return o;
+    for (c = 0; c < 2; c++) {
+        int64_t o = (s[c] * b0 + deemph.li[c] * b1) * (1 << DEEMPH_FRAC) - deemph.lo[c] * a1;
+        
+        o = (o + (1LL << (DEEMPH_SHIFT - 1))) >> DEEMPH_SHIFT;
+        deemph.li[c] = s[c];
+        deemph.lo[c] = o;
+        
+        s[c] = (int32_t)((o + (1 << (DEEMPH_FRAC - 1))) >> DEEMPH_FRAC);
+    }
 }
 
+/* Volume is applied as a gain in Q14 format */
+#define SND_GAIN_SHIFT 14
+#define SND_GAIN_ONE   (1 << SND_GAIN_SHIFT)
+
 /* This function returns a factor for adding volume adjustment to samples */
-static double snd_get_volume_factor(uint8_t vol_data) {
+static int16_t snd_get_volume_factor(uint8_t vol_data) {
     double gain = (double)vol_data * -2.0;
     
     switch (vol_data) {
-        case 0:           return 1.0;
-        case SND_MAX_VOL: return 0.0;
-        default:          return pow(10.0, gain*0.05);
+        case 0:           return SND_GAIN_ONE;
+        case SND_MAX_VOL: return 0;
+        default:          return (int16_t)(pow(10.0, gain*0.05) * SND_GAIN_ONE + 0.5);
+    }
+}
+
+static inline int16_t snd_clamp(int32_t sample) {
+    return (sample > INT16_MAX) ? INT16_MAX : ((sample < INT16_MIN) ? INT16_MIN : (int16_t)sample);
+}
+
+/* This function multiplies samples with gain, clamps the result and keeps
+ * big-endian byte order */
+static void snd_apply_gain(uint8_t* buf, int len, int16_t lgain, int16_t rgain) {
+    int i = 0;
+#if SND_SSE2
+    /* madd pairs each sample with 1 and each gain with the rounding term */
+    __m128i g = _mm_setr_epi16(lgain, 1 << (SND_GAIN_SHIFT - 1), rgain, 1 << (SND_GAIN_SHIFT - 1),
+                               lgain, 1 << (SND_GAIN_SHIFT - 1), rgain, 1 << (SND_GAIN_SHIFT - 1));
+    __m128i one = _mm_set1_epi16(1);
+    for (; i + 16 <= len; i += 16) {
+        __m128i x = _mm_loadu_si128((__m128i*)(buf + i));
+        __m128i lo, hi;
+        x  = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        lo = _mm_srai_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(x, one), g), SND_GAIN_SHIFT);
+        hi = _mm_srai_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(x, one), g), SND_GAIN_SHIFT);
+        x  = _mm_packs_epi32(lo, hi);
+        x  = _mm_or_si128(_mm_slli_epi16(x, 8), _mm_srli_epi16(x, 8));
+        _mm_storeu_si128((__m128i*)(buf + i), x);
+    }
+#elif SND_NEON
+    int16_t gains[4] = { lgain, rgain, lgain, rgain };
+    int16x4_t g = vld1_s16(gains);
+    for (; i + 16 <= len; i += 16) {
+        int16x8_t x = vreinterpretq_s16_u8(vrev16q_u8(vld1q_u8(buf + i)));
+        int32x4_t lo = vmull_s16(vget_low_s16(x), g);
+        int32x4_t hi = vmull_s16(vget_high_s16(x), g);
+        x = vcombine_s16(vqrshrn_n_s32(lo, SND_GAIN_SHIFT), vqrshrn_n_s32(hi, SND_GAIN_SHIFT));
+        vst1q_u8(buf + i, vrev16q_u8(vreinterpretq_u8_s16(x)));
+    }
+#endif
+    for (; i < len; i += 4) {
+        int32_t lsample = (int16_t)((buf[i + 0] << 8) | buf[i + 1]);
+        int32_t rsample = (int16_t)((buf[i + 2] << 8) | buf[i + 3]);
+        
+        lsample = snd_clamp((lsample * lgain + (1 << (SND_GAIN_SHIFT - 1))) >> SND_GAIN_SHIFT);
+        rsample = snd_clamp((rsample * rgain + (1 << (SND_GAIN_SHIFT - 1))) >> SND_GAIN_SHIFT);
+        
+        buf[i + 0] = lsample >> 8;
+        buf[i + 1] = lsample;
+        buf[i + 2] = rsample >> 8;
+        buf[i + 3] = rsample;
     }
 }
 
@@ -154,33 +262,27 @@ static double snd_get_volume_factor(uint8_t vol_data) {
 static void snd_adjust_volume_and_deemphasis(uint8_t* buf, int len) {
     if (sndout_state.mute) {
         memset(buf, 0, len);
-    } else if (sndout_state.attenuation[0] || sndout_state.attenuation[1] || sndout_state.deemph) {
-        int16_t lsample, rsample;
-        double ldata, rdata;
+        return;
+    }
+    if (sndout_state.deemph) {
+        int32_t s[2];
         int i;
         
         for (i = 0; i < len; i += 4) {
-            ldata = (double)(int16_t)((buf[i + 0] << 8) | buf[i + 1]);
-            rdata = (double)(int16_t)((buf[i + 2] << 8) | buf[i + 3]);
-            if (sndout_state.deemph) {
-                ldata = snd_deemphasis_filter(ldata, 0);
-                rdata = snd_deemphasis_filter(rdata, 1);
-            }
-            ldata *= sndout_state.volume[0];
-            rdata *= sndout_state.volume[1];
-            
-            ldata += (ldata < 0.0) ? -0.5 : +0.5;
-            rdata += (rdata < 0.0) ? -0.5 : +0.5;
-            
-            lsample = (ldata > INT16_MAX) ? INT16_MAX : ((ldata < INT16_MIN) ? INT16_MIN : (int16_t)ldata);
-            rsample = (rdata > INT16_MAX) ? INT16_MAX : ((rdata < INT16_MIN) ? INT16_MIN : (int16_t)rdata);
-            
-            buf[i + 0] = lsample >> 8;
-            buf[i + 1] = lsample;
-            buf[i + 2] = rsample >> 8;
-            buf[i + 3] = rsample;
+            s[0] = (int16_t)((buf[i + 0] << 8) | buf[i + 1]);
+            s[1] = (int16_t)((buf[i + 2] << 8) | buf[i + 3]);
+            snd_deemphasis_filter(s);
+            s[0] = snd_clamp(s[0]);
+            s[1] = snd_clamp(s[1]);
+            buf[i + 0] = s[0] >> 8;
+            buf[i + 1] = s[0];
+            buf[i + 2] = s[1] >> 8;
+            buf[i + 3] = s[1];
         }
     }
+    if (sndout_state.attenuation[0] || sndout_state.attenuation[1]) {
+        snd_apply_gain(buf, len, sndout_state.volume[0], sndout_state.volume[1]);
+    }
 }
 
 /* This function processes and sends multiple samples */
@@ -448,6 +550,46 @@ void Sound_Pause(bool pause) {
     }
 }
 
+/* Save/Restore snapshot of sound state. Host audio is started or stopped
+ * to match the restored loops. */
+void Sound_MemorySnapShot_Capture(bool bSave) {
+    bool output_active = sound_output_active;
+    bool input_active  = sound_input_active;
+    bool dsp_active    = sound_dsp_active;
+    
+    MemorySnapShot_Store(&sndout_state, sizeof(sndout_state));
+    MemorySnapShot_Store(&tmp_vol, sizeof(tmp_vol));
+    MemorySnapShot_Store(&bit_num, sizeof(bit_num));
+    MemorySnapShot_Store(&snd_buffer_len, sizeof(snd_buffer_len));
+    MemorySnapShot_Store(snd_buffer, sizeof(snd_buffer));
+    MemorySnapShot_Store(&output_active, sizeof(output_active));
+    MemorySnapShot_Store(&input_active, sizeof(input_active));
+    MemorySnapShot_Store(&dsp_active, sizeof(dsp_active));
+    
+    if (!bSave) {
+        if (output_active && !sound_output_active) {
+            snd_start_output(sndout_state.mode);
+        } else if (!output_active) {
+            snd_stop_output();
+        }
+        if (input_active && !sound_input_active) {
+            snd_start_input();
+        } else if (!input_active && sound_input_active) {
+            snd_stop_input();
+        }
+        if (dsp_active && !sound_dsp_active) {
+            snd_dsp_start();
+        } else if (!dsp_active && sound_dsp_active) {
+            snd_dsp_stop();
+        }
+    }
+    
+    /* Stored after restarting, starting the loops resets these */
+    MemorySnapShot_Store(&deemph, sizeof(deemph));
+    MemorySnapShot_Store(&foursamples, sizeof(foursamples));
+    MemorySnapShot_Store(&ulawsamplecount, sizeof(ulawsamplecount));
+}
+
 
 /* Sound IO loops */
 
@@ -467,7 +609,7 @@ void SND_Out_Handler(void) {
     
     if (sound_output_inited) {
         frametime = 8;   /* Use short delay for host sound sync. See comment above. */
-        count = Audio_Output_Queue_Size();
+        count = Replay_Value(REPLAY_SND_OUT_SIZE, Audio_Output_Queue_Size());
         if (count > 0) { /* Enough sample frames queued. Waiting syncs with playback. */
             count >>= 2;
             CycInt_UpdateTimeEvent(frametime * count, 0, EVENT_SND_OUTPUT);
@@ -489,6 +631,14 @@ void SND_Out_Handler(void) {
     }
 }
 
+/* Record or replay result of reading a host input sample, -1 if none */
+static int snd_input_sample(replay_event_t type, int result, int16_t* sample) {
+    int value = Replay_Value(type, result < 0 ? -1 : (uint16_t)*sample);
+    
+    *sample = (int16_t)value;
+    return value < 0 ? -1 : 0;
+}
+
 /*
   Sound is recorded at 8012 Hz. One sample (byte) takes about 125 microseconds.
  */
@@ -511,7 +661,7 @@ void SND_In_Handler(void) {
     
     /* Process 256 samples at a time and then sync */
     while (count < 256) {
-        if (Audio_Input_Buffer_Get(&sample) < 0) {
+        if (snd_input_sample(REPLAY_SND_IN, Audio_Input_Buffer_Get(&sample), &sample) < 0) {
             Log_Printf(LOG_WARN, "[Sound] Waiting for sound input data");
             count = 256; /* Long delay */
             break;
@@ -532,7 +682,7 @@ void SND_In_Handler(void) {
     }
     
     /* If we accumulated too much data write it fast */
-    if (Audio_Input_Buffer_Size() > 8192) { /* this is 4096 ulaw samples equaling about 0.5 seconds */
+    if (Replay_Value(REPLAY_SND_IN_SIZE, Audio_Input_Buffer_Size()) > 8192) { /* this is 4096 ulaw samples equaling about 0.5 seconds */
         Log_Printf(LOG_WARN, "[Sound] Writing input data fast");
         count = 16; /* Short delay */
     }
@@ -557,7 +707,7 @@ void SND_DSP_Handler(void) {
     } else {
         sampletime = SND_CDDA_INTERVAL >> 1;
     }
-    if (Audio_DSP_Buffer_Get(&sample) == 0) {
+    if (snd_input_sample(REPLAY_DSP_IN, Audio_DSP_Buffer_Get(&sample), &sample) == 0) {
         DSP_SsiWriteRxValue(sample);
         DSP_SsiReceive_SC0();
     }
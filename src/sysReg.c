@@ -21,6 +21,7 @@ const char SysReg_fileid[] = "Previous sysReg.c";
 #include "bmap.h"
 #include "statusbar.h"
 #include "timing.h"
+#include "memorySnapShot.h"
 
 #define LOG_SCR_LEVEL       LOG_DEBUG
 #define LOG_HARDCLOCK_LEVEL LOG_DEBUG
@@ -743,3 +744,33 @@ void Brightness_Write(void) {
         Log_Printf(LOG_WARN,"[Brightness] Setting brightness to %02x\n", bright_reg&BRIGHTNESS_MASK);
     }
 }
+
+
+/* Save/Restore snapshot of system control registers */
+void SCR_MemorySnapShot_Capture(bool bSave) {
+    MemorySnapShot_Store(&scr1, sizeof(scr1));
+    MemorySnapShot_Store(&scr2_0, sizeof(scr2_0));
+    MemorySnapShot_Store(&scr2_1, sizeof(scr2_1));
+    MemorySnapShot_Store(&scr2_2, sizeof(scr2_2));
+    MemorySnapShot_Store(&scr2_3, sizeof(scr2_3));
+    MemorySnapShot_Store(&scr_have_dsp_memreset, sizeof(scr_have_dsp_memreset));
+    MemorySnapShot_Store(&col_vid_intr, sizeof(col_vid_intr));
+    MemorySnapShot_Store(&bright_reg, sizeof(bright_reg));
+    MemorySnapShot_Store(&hardclock_csr, sizeof(hardclock_csr));
+    MemorySnapShot_Store(&hardclock_counter, sizeof(hardclock_counter));
+    MemorySnapShot_Store(&hardclock_latch, sizeof(hardclock_latch));
+    MemorySnapShot_Store(&hardclock_last_time, sizeof(hardclock_last_time));
+    MemorySnapShot_Store(&scr_local_only, sizeof(scr_local_only));
+    MemorySnapShot_Store(&dsp_dma_unpacked, sizeof(dsp_dma_unpacked));
+    MemorySnapShot_Store(&dsp_intr_at_block_end, sizeof(dsp_intr_at_block_end));
+    MemorySnapShot_Store(&dsp_hreq_intr, sizeof(dsp_hreq_intr));
+    MemorySnapShot_Store(&dsp_txdn_intr, sizeof(dsp_txdn_intr));
+    MemorySnapShot_Store(&scrIntStat, sizeof(scrIntStat));
+    MemorySnapShot_Store(&scrIntMask, sizeof(scrIntMask));
+    MemorySnapShot_Store(&scrIntLevel, sizeof(scrIntLevel));
+    MemorySnapShot_Store(&eventcounter_offset, sizeof(eventcounter_offset));
+    
+    if (!bSave) {
+        Statusbar_SetSystemLed(scr2_3&SCR2_LED);
+    }
+}
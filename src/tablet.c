@@ -17,6 +17,7 @@ const char Tablet_fileid[] = "Previous tablet.c";
 #include "statusbar.h"
 #include "scc.h"
 #include "tablet.h"
+#include "memorySnapShot.h"
 
 #define LOG_TABLET_LEVEL      LOG_WARN
 #define LOG_TABLET_DATA_LEVEL LOG_DEBUG
@@ -861,3 +862,15 @@ void Tablet_Reset(void) {
 	/* Uninit tablet */
 	bTabletEnabled = false;
 }
+
+
+/* Save/Restore snapshot of tablet state, keeping the tablet functions */
+void Tablet_MemorySnapShot_Capture(bool bSave) {
+	struct tablet_device saved = tablet;
+	
+	MemorySnapShot_Store(&tablet, sizeof(tablet));
+	tablet.reset      = saved.reset;
+	tablet.receive    = saved.receive;
+	tablet.pen_move   = saved.pen_move;
+	tablet.pen_button = saved.pen_button;
+}
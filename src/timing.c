@@ -14,7 +14,6 @@ const char Timing_fileid[] = "Previous timing.c";
 #include <unistd.h>
 #define timegm _mkgmtime
 #endif
-#include <float.h>
 
 #include "main.h"
 #include "host.h"
@@ -22,6 +21,8 @@ const char Timing_fileid[] = "Previous timing.c";
 #include "configuration.h"
 #include "log.h"
 #include "m68000.h"
+#include "memorySnapShot.h"
+#include "replay.h"
 
 
 #define NUM_BLANKS 3
@@ -32,28 +33,72 @@ static uint64_t     cycleCounterStart;
 static uint64_t     cycleDivisor;
 static uint64_t     perfCounterStart;
 static uint64_t     perfFrequency;
-static bool         perfCounterFreqInt;
-static uint64_t     perfDivisor;
-static double       perfMultiplicator;
+static uint64_t     perfMultiplier;
 static uint64_t     pauseTimeStamp;
 static bool         enableRealtime;
+static bool         maxSpeed;
 static bool         osDarkmatter;
 static bool         currentIsRealtime;
 static uint64_t     hardClockExpected;
 static uint64_t     hardClockActual;
 static time_t       unixTimeStart;
-static lock_t       timeLock;
-static uint64_t     saveTime;
+static atomic_int   saveTimeSeq;
+static atomic_int   saveTimeLow;
+static atomic_int   saveTimeHigh;
 
+/* Host counter ticks are converted to microseconds by multiplying with
+ * perfMultiplier and shifting the 128-bit product right by PERF_SHIFT. */
+#define PERF_SHIFT 48
+
+static inline uint64_t Timing_MulShift(uint64_t a, uint64_t b) {
+#ifdef __SIZEOF_INT128__
+	return (uint64_t)(((unsigned __int128)a * b) >> PERF_SHIFT);
+#else
+	uint64_t aLo = (uint32_t)a, aHi = a >> 32;
+	uint64_t bLo = (uint32_t)b, bHi = b >> 32;
+	uint64_t lo  = aLo * bLo;
+	uint64_t m1  = aHi * bLo;
+	uint64_t m2  = aLo * bHi;
+	uint64_t hi  = aHi * bHi;
+	uint64_t mid = (lo >> 32) + (uint32_t)m1 + (uint32_t)m2;
+	
+	hi += (m1 >> 32) + (m2 >> 32) + (mid >> 32);
+	lo  = (mid << 32) | (uint32_t)lo;
+	return (hi << (64 - PERF_SHIFT)) | (lo >> PERF_SHIFT);
+#endif
+}
 
 static inline uint64_t Timing_GetRealTime(void) {
-	uint64_t rt = (host_get_counter() - perfCounterStart);
-	if (perfCounterFreqInt) {
-		rt /= perfDivisor;
-	} else {
-		rt *= perfMultiplicator;
-	}
-	return rt;
+	return Timing_MulShift(host_get_counter() - perfCounterStart, perfMultiplier);
+}
+
+/* Convert microseconds to host counter ticks */
+static uint64_t Timing_UsToCounter(uint64_t us) {
+	return (us / 1000000ULL) * perfFrequency + (us % 1000000ULL) * perfFrequency / 1000000ULL;
+}
+
+/* saveTime is written by the CPU thread and read by other threads. It is
+ * protected by a sequence counter which is odd while an update is in
+ * progress. Readers retry until they see the same even count before and
+ * after reading. */
+static void Timing_StoreSaveTime(uint64_t hostTime) {
+	host_atomic_add(&saveTimeSeq, 1);
+	host_atomic_set(&saveTimeLow, (int)(uint32_t)hostTime);
+	host_atomic_set(&saveTimeHigh, (int)(uint32_t)(hostTime >> 32));
+	host_atomic_add(&saveTimeSeq, 1);
+}
+
+static uint64_t Timing_LoadSaveTime(void) {
+	uint64_t hostTime;
+	int seq;
+	
+	do {
+		seq      = host_atomic_get(&saveTimeSeq);
+		hostTime = (uint32_t)host_atomic_get(&saveTimeLow);
+		hostTime |= (uint64_t)(uint32_t)host_atomic_get(&saveTimeHigh) << 32;
+	} while ((seq & 1) || host_atomic_get(&saveTimeSeq) != seq);
+	
+	return hostTime;
 }
 
 void Timing_Pause(bool pause) {
@@ -71,8 +116,9 @@ uint64_t Timing_GetTime(void) {
 	
 	/* switch to realtime if...
 	 * 1) ...realtime mode is enabled and...
-	 * 2) ...either we are running darkmatter or the m68k CPU is in user mode */
-	state = (osDarkmatter || !(regs.s)) && enableRealtime;
+	 * 2) ...either we are running darkmatter or the m68k CPU is in user mode
+	 * In max speed mode guest time always follows emulated cycles. */
+	state = (osDarkmatter || !(regs.s)) && enableRealtime && !maxSpeed;
 	
 	if (currentIsRealtime) {
 		hostTime = Timing_GetRealTime();
@@ -102,6 +148,11 @@ uint64_t Timing_GetTime(void) {
 	return hostTime;
 }
 
+/* Return true if time is currently bound to the host clock */
+bool Timing_IsRealtime(void) {
+	return currentIsRealtime;
+}
+
 void Timing_GetTimes(uint64_t* realTime, uint64_t* hostTime) {
 	*hostTime = Timing_GetTime();
 	*realTime = Timing_GetRealTime();
@@ -111,22 +162,34 @@ void Timing_Sync(void) {
 	int64_t realTimeOffset;
 	uint64_t realTime, hostTime;
 	Timing_GetTimes(&realTime, &hostTime);
-	host_lock(&timeLock);
-	saveTime = hostTime; /* save hostTime to be read by other threads */
-	host_unlock(&timeLock);
+	Timing_StoreSaveTime(hostTime); /* save hostTime to be read by other threads */
 	realTimeOffset = hostTime - realTime;
-	if (realTimeOffset > 0) {
+	if (realTimeOffset > 0 && !maxSpeed) {
 		host_sleep_us(realTimeOffset);
 	}
 }
 
+/* Enable or disable running as fast as possible */
+void Timing_SetMaxSpeed(bool enable) {
+	int64_t realTimeOffset;
+	uint64_t realTime, hostTime;
+	
+	if (maxSpeed && !enable) {
+		/* move real time forward to emulated time, so that we don't sleep
+		 * until the host clock catches up with the time we ran ahead */
+		Timing_GetTimes(&realTime, &hostTime);
+		realTimeOffset = hostTime - realTime;
+		if (realTimeOffset > 0) {
+			perfCounterStart -= Timing_UsToCounter(realTimeOffset);
+		}
+	}
+	maxSpeed = enable;
+	Log_Printf(LOG_WARN, "[Timing] Max speed mode %s.", enable ? "enabled" : "disabled");
+}
+
 /* This can be used by other threads to read hostTime */
 uint64_t Timing_GetSaveTime(void) {
-	uint64_t hostTime;
-	host_lock(&timeLock);
-	hostTime = saveTime;
-	host_unlock(&timeLock);
-	return hostTime / 1000000ULL;
+	return Timing_LoadSaveTime() / 1000000ULL;
 }
 
 /* Return current time as seconds */
@@ -218,25 +281,16 @@ static void Timing_ReportLimits(void) {
 	
 	perfCounter        = host_get_counter();
 	perfCounterLimit   = UINT64_MAX - perfCounter;
+	perfCounterLimit   = Timing_MulShift(perfCounterLimit, perfMultiplier);
+	if (perfCounterLimit > INT64_MAX)
+		perfCounterLimit = INT64_MAX;
+	perfCounterLimit /= DAY_TO_US;
+	Log_Printf(LOG_WARN, "[Timing] Realtime counter source: %s", host_get_counter_name());
 	Log_Printf(LOG_WARN, "[Timing] Realtime counter value: %"PRIu64, perfCounter);
-	if (perfCounterFreqInt) {
-		perfCounterLimit /= perfDivisor;
-		if (perfCounterLimit > INT64_MAX)
-			perfCounterLimit = INT64_MAX;
-		perfCounterLimit /= DAY_TO_US;
-		Log_Printf(LOG_WARN, "[Timing] Realtime counter frequency: %"PRIu64" MHz", perfDivisor);
-		Log_Printf(LOG_WARN, "[Timing] Realtime counter will overflow in %"PRIu64" days", perfCounterLimit);
-	} else {
-		if (perfCounterLimit > (1ULL<<DBL_MANT_DIG)-1)
-			perfCounterLimit = (1ULL<<DBL_MANT_DIG)-1;
-		if (perfMultiplicator < 1.0)
-			perfCounterLimit *= perfMultiplicator;
-		else
-			Log_Printf(LOG_WARN, "[Timing] Warning: Realtime counter cannot resolve microseconds.");
-		perfCounterLimit /= DAY_TO_US;
-		Log_Printf(LOG_WARN, "[Timing] Realtime counter frequency: %f MHz", 1.0/perfMultiplicator);
-		Log_Printf(LOG_WARN, "[Timing] Realtime timer will start losing precision in %"PRIu64" days", perfCounterLimit);
-	}
+	Log_Printf(LOG_WARN, "[Timing] Realtime counter frequency: %f MHz", perfFrequency / 1000000.0);
+	if (perfFrequency < 1000000ULL)
+		Log_Printf(LOG_WARN, "[Timing] Warning: Realtime counter cannot resolve microseconds.");
+	Log_Printf(LOG_WARN, "[Timing] Realtime counter will overflow in %"PRIu64" days", perfCounterLimit);
 }
 
 /* Check NeXT specific UNIX time limits and adjust time if needed */
@@ -271,17 +325,18 @@ static void Timing_CheckUnixTime(void) {
 void Timing_Reset(void) {
 	int i;
 	
+	perfFrequency     = host_get_counter_frequency();
 	perfCounterStart  = host_get_counter();
 	pauseTimeStamp    = perfCounterStart;
-	perfFrequency     = host_get_counter_frequency();
-	unixTimeStart     = time(NULL);
+	unixTimeStart     = Replay_UnixTime(time(NULL));
 	cycleCounterStart = 0;
 	currentIsRealtime = false;
 	hardClockExpected = 0;
 	hardClockActual   = 0;
 	enableRealtime    = ConfigureParams.System.bRealtime;
+	maxSpeed          = ConfigureParams.System.bMaxSpeed;
 	osDarkmatter      = false;
-	saveTime          = 0;
+	Timing_StoreSaveTime(0);
 	
 	for (i = NUM_BLANKS; --i >= 0;) {
 		Timing_ResetBlankCounter(i);
@@ -289,10 +344,31 @@ void Timing_Reset(void) {
 	
 	cycleDivisor = ConfigureParams.System.nCpuFreq;
 	
-	perfCounterFreqInt = (perfFrequency % 1000000ULL) == 0;
-	perfDivisor        = perfFrequency / 1000000ULL;
-	perfMultiplicator  = 1000000.0 / perfFrequency;
+	perfMultiplier = (uint64_t)(1000000.0 / perfFrequency * (double)(1ULL << PERF_SHIFT) + 0.5);
 	
 	Timing_ReportLimits();
 	Timing_CheckUnixTime();
 }
+
+/* Save/Restore snapshot of guest time. Host counters are rebased so that
+ * guest time continues where it was saved. Must be restored after CycInt. */
+void Timing_MemorySnapShot_Capture(bool bSave) {
+	uint64_t hostTime = 0;
+	
+	if (bSave) {
+		hostTime = Timing_GetTime();
+	}
+	MemorySnapShot_Store(&hostTime, sizeof(hostTime));
+	MemorySnapShot_Store(&unixTimeStart, sizeof(unixTimeStart));
+	MemorySnapShot_Store(&currentIsRealtime, sizeof(currentIsRealtime));
+	MemorySnapShot_Store(&osDarkmatter, sizeof(osDarkmatter));
+	MemorySnapShot_Store(&hardClockExpected, sizeof(hardClockExpected));
+	MemorySnapShot_Store(&hardClockActual, sizeof(hardClockActual));
+	
+	if (!bSave) {
+		cycleCounterStart = nCyclesMainCounter - hostTime * cycleDivisor;
+		perfCounterStart = host_get_counter() - Timing_UsToCounter(hostTime);
+		pauseTimeStamp = host_get_counter();
+		Timing_StoreSaveTime(hostTime);
+	}
+}
@@ -14,6 +14,7 @@ const char Tmc_fileid[] = "Previous tmc.c";
 #include "sysReg.h"
 #include "adb.h"
 #include "tmc.h"
+#include "memorySnapShot.h"
 
 #define LOG_TMC_LEVEL LOG_DEBUG
 
@@ -500,3 +501,9 @@ void TMC_Reset(void) {
 	
 	adb_reset();
 }
+
+
+/* Save/Restore snapshot of TMC registers */
+void TMC_MemorySnapShot_Capture(bool bSave) {
+	MemorySnapShot_Store(&tmc, sizeof(tmc));
+}
@@ -20,10 +20,9 @@ const char Video_fileid[] = "Previous video.c";
 #include "dma.h"
 #include "sysReg.h"
 #include "tmc.h"
+#include "grab.h"
 
 
-#define NEXT_VBL_FREQ 68
-
 /*-----------------------------------------------------------------------*/
 /**
  * Start VBL interrupt.
@@ -71,12 +70,14 @@ void Video_VBL_Handler(void) {
 	Timing_BlankCount(MAIN_DISPLAY, true);
 	Screen_StatusbarUpdate();
 	Video_Interrupt();
+	Grab_VideoFrame();
 	CycInt_UpdateTimeEvent((1000*1000)/NEXT_VBL_FREQ, 0, EVENT_VIDEO_VBL);
 #else
 	static bool bBlankToggle = false;
 	Timing_BlankCount(MAIN_DISPLAY, bBlankToggle);
 	if (bBlankToggle) {
 		Video_Interrupt();
+		Grab_VideoFrame();
 	} else if (!Configuration_SingleColorScreen()) {
 		GuiEvent_SendSpecialEvent(SPECIAL_EVENT_REPAINT);
 	}